@@ -0,0 +1,143 @@
+#ifndef __MG_ARENA_H__
+#define __MG_ARENA_H__
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+/* *************Build flags***************
+ * MG_ALLOC_TRAP : 0 (default) nothing, 1 malloc/free inside an Arena::NoAlloc scope
+ *                 stops the program (link with --wrap, see `make ALLOC_TRAP=1`)
+ * *******************************/
+#ifndef MG_ALLOC_TRAP
+#define MG_ALLOC_TRAP 0
+#endif
+
+namespace Arena
+{ // One block of memory, allocated at startup, handed out in aligned pieces (include SDL.h first)
+    /* *************DOC***************
+     * Arena::init() is the only malloc. alloc() just bumps an offset:
+     *
+     *      Arena::Arena a;
+     *      if(!Arena::init(&a, 1<<20)) ...out of memory...
+     *      float* delay = Arena::alloc_array<float>(&a, 4096);  // NULL if arena is full
+     *      ...
+     *      Arena::destroy(&a);                     // Frees every block at once
+     *
+     * Every block starts on an ALIGN byte boundary (a cache line, and wide enough
+     * for any SIMD load), and is zeroed. There is no free() of one block: reset()
+     * empties the whole arena, destroy() gives it back.
+     *
+     * Real-time code (the audio callback) must not call malloc or free: either one
+     * can take a lock the UI thread is holding. Mark it with a NoAlloc scope:
+     *
+     *      Arena::NoAlloc no_alloc;                // Rest of this scope : no malloc
+     *
+     * With MG_ALLOC_TRAP=1, malloc, calloc, realloc, free (and new and delete,
+     * which call them) in a NoAlloc scope print a message and stop at a
+     * breakpoint. With MG_ALLOC_TRAP=0, NoAlloc is empty and costs nothing.
+     * *******************************/
+    constexpr size_t ALIGN = 64;                        // Bytes : one cache line
+    struct Arena
+    {
+        void* mem{};                                    // From malloc : give this to free
+        Uint8* base{};                                  // mem, rounded up to ALIGN
+        size_t size{};                                  // Bytes usable from base
+        size_t used{};                                  // Bytes handed out (a multiple of ALIGN)
+    };
+    size_t round_up(size_t n) { return (n + ALIGN-1) & ~(ALIGN-1); }
+    bool init(Arena* a, size_t size)
+    { // Allocate the arena. False if out of memory.
+        a->mem = malloc(size + ALIGN-1);
+        if(a->mem == NULL) return false;
+        a->base = reinterpret_cast<Uint8*>(round_up(reinterpret_cast<size_t>(a->mem)));
+        a->size = size; a->used = 0;
+        return true;
+    }
+    void* alloc(Arena* a, size_t bytes)
+    { // Zeroed block of at least bytes, ALIGN-aligned. NULL if the arena is full.
+        size_t n = round_up(bytes ? bytes : 1);
+        if((a->base == NULL) || (n > a->size - a->used)) return NULL;
+        Uint8* p = a->base + a->used;
+        a->used += n;
+        memset(p, 0, n);
+        return p;
+    }
+    template<typename T>
+    T* alloc_array(Arena* a, size_t count)
+    { // count zeroed T's, for plain data types (no constructor is run)
+        if(count > (a->size/sizeof(T))) return NULL;
+        return static_cast<T*>(alloc(a, count*sizeof(T)));
+    }
+    void reset(Arena* a) { a->used = 0; }              // Every block is free again
+    void destroy(Arena* a)
+    {
+        free(a->mem);
+        *a = Arena{};
+    }
+
+    ////////////////
+    // ALLOC TRAP
+    ////////////////
+    thread_local int no_alloc_depth{};                  // NoAlloc scopes open on this thread
+    struct NoAlloc
+    { // RAII : malloc/free in this scope is a bug (trapped if MG_ALLOC_TRAP)
+        NoAlloc()  { if(MG_ALLOC_TRAP) no_alloc_depth++; }
+        ~NoAlloc() { if(MG_ALLOC_TRAP) no_alloc_depth--; }
+    };
+    void trap(const char* what)
+    { // No malloc here : the message is a literal, fputs to unbuffered stderr
+        fputs("Arena : ", stderr); fputs(what, stderr);
+        fputs(" in a NoAlloc scope (real-time thread)\n", stderr);
+        SDL_TriggerBreakpoint();
+    }
+}
+
+#if MG_ALLOC_TRAP
+/* *************Alloc trap***************
+ * The linker flags --wrap=malloc (and calloc, realloc, free) send every call
+ * to those in this program to __wrap_malloc, and __real_malloc is the libc one.
+ * *******************************/
+extern "C"
+{
+    void* __real_malloc(size_t);
+    void* __real_calloc(size_t, size_t);
+    void* __real_realloc(void*, size_t);
+    void  __real_free(void*);
+    void* __wrap_malloc(size_t n)
+    {
+        if(Arena::no_alloc_depth) Arena::trap("malloc");
+        return __real_malloc(n);
+    }
+    void* __wrap_calloc(size_t n, size_t size)
+    {
+        if(Arena::no_alloc_depth) Arena::trap("calloc");
+        return __real_calloc(n, size);
+    }
+    void* __wrap_realloc(void* p, size_t n)
+    {
+        if(Arena::no_alloc_depth) Arena::trap("realloc");
+        return __real_realloc(p, n);
+    }
+    void __wrap_free(void* p)
+    {
+        if(Arena::no_alloc_depth && p) Arena::trap("free");
+        __real_free(p);
+    }
+}
+// new and delete go through malloc and free, so they are trapped too
+void* operator new(size_t n)
+{
+    void* p = malloc(n ? n : 1);
+    if(p == NULL) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
+
+#endif // __MG_ARENA_H__
@@ -0,0 +1,38 @@
+#include <cstdio>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_arena.h"
+
+void run_tests_for_mg_arena()
+{
+    Arena::Arena a;
+    TEST(Arena::init(&a, 1<<12));
+    { // Every block is aligned and zeroed, whatever size came before it
+        bool ok = true;
+        const size_t sizes[] = {1, 3, 64, 65, 100, 7};
+        for(size_t n : sizes)
+        {
+            Uint8* p = static_cast<Uint8*>(Arena::alloc(&a, n));
+            if((p == NULL) || (reinterpret_cast<size_t>(p) % Arena::ALIGN != 0)) ok = false;
+            for(size_t i=0; ok && (i<n); i++) ok = (p[i] == 0);
+            if(ok) memset(p, 0xFF, n);                  // Next test : reset() re-zeroes
+            if(!ok) { Tests::note("block of %zu bytes", n); break; }
+        }
+        TEST(ok);
+    }
+    { // Full arena : NULL, nothing handed out past the end
+        Arena::reset(&a);
+        TEST(Arena::alloc_array<float>(&a, 1<<10) != NULL); // Exactly 4KB
+        TESTeq(a.used, a.size);
+        TEST(Arena::alloc(&a, 1) == NULL);
+        TEST(Arena::alloc_array<float>(&a, static_cast<size_t>(-1)/2) == NULL); // count*size overflows
+    }
+    { // reset() : first block is at the start again, and zeroed
+        Arena::reset(&a);
+        Uint8* p = Arena::alloc_array<Uint8>(&a, 64);
+        TEST(p == a.base);
+        TESTeq(p[0], 0);
+    }
+    Arena::destroy(&a);
+    TEST(Arena::alloc(&a, 1) == NULL);                  // Destroyed arena is empty
+}
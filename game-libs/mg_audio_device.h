@@ -0,0 +1,118 @@
+#ifndef __MG_AUDIO_DEVICE_H__
+#define __MG_AUDIO_DEVICE_H__
+
+#include <atomic>
+#include <cstdio>
+
+namespace AudioDevice
+{ // Keep an audio output open : reopen it off the UI thread when it goes away (include SDL.h first)
+    /* *************DOC***************
+     * UI thread:
+     *
+     *      AudioDevice::Device d;
+     *      SDL_AudioDeviceID id = AudioDevice::open(&d, &want, &got);  // Startup, like SDL_OpenAudioDevice
+     *      ...
+     *      case SDL_AUDIODEVICEREMOVED: AudioDevice::removed(&d, e.adevice.which, e.adevice.iscapture, now); break;
+     *      case SDL_AUDIODEVICEADDED:   AudioDevice::added(&d, e.adevice.iscapture, now); break;
+     *      ...
+     *      if(AudioDevice::update(&d, now) == AudioDevice::REOPENED)
+     *      { // d.id is a new device, paused
+     *          ...fade in...; SDL_PauseAudioDevice(d.id, 0);
+     *      }
+     *
+     * The device is the default output (NULL), with the spec of the first
+     * open(). Losing it closes our handle at once (SDL requires that). The
+     * reopen runs on a thread : opening a device can block for a long time
+     * (PulseAudio, Bluetooth). A new output showing up retries at once;
+     * otherwise update() retries every RETRY_MS.
+     *
+     * The callback and everything it reads stay as they were, so the sound
+     * carries on where it stopped. A device that opens with a different
+     * buffer size is closed again : the caller sized its buffers for the first.
+     *
+     * lose() does what a removed event does, for testing with SDL's dummy or
+     * disk drivers (SDL_AUDIODRIVER=dummy), which never lose their device.
+     * *******************************/
+    enum State { CLOSED, PLAYING, LOST, OPENING };
+    enum Result { NOTHING, REOPENED, RETRY };           // What update() did
+    constexpr Uint32 RETRY_MS = 1000;
+    struct Device
+    {
+        SDL_AudioSpec want{};                           // Spec of the first open()
+        SDL_AudioDeviceID id{};                         // Open device (0 : none)
+        State state{CLOSED};                            // UI thread
+        Uint32 retry_at{};                              // LOST : ticks of the next try
+        Uint32 lost_at{};                               // Ticks when the device went away
+        int reopens{};                                  // Devices reopened so far
+        // Opener thread
+        SDL_Thread* thread{};
+        std::atomic<bool> done{false};                  // Opener finished : read got, opened
+        SDL_AudioDeviceID opened{};
+        SDL_AudioSpec got{};
+        char error[256]{};                              // Why the last try failed
+    };
+    SDL_AudioDeviceID open(Device* d, const SDL_AudioSpec* want, SDL_AudioSpec* got)
+    { // Startup : open the default output, paused. 0 if there is none (see SDL_GetError).
+        d->want = *want;
+        d->id = SDL_OpenAudioDevice(NULL, 0, want, got, 0);
+        d->state = d->id ? PLAYING : LOST;
+        return d->id;
+    }
+    int SDLCALL open_thread(void* userdata)
+    {
+        Device* d = static_cast<Device*>(userdata);
+        d->opened = SDL_OpenAudioDevice(NULL, 0, &d->want, &d->got, 0);
+        if(d->opened == 0) snprintf(d->error, sizeof(d->error), "%s", SDL_GetError());
+        else if(d->got.size != d->want.size)
+        {
+            snprintf(d->error, sizeof(d->error), "buffer is %u bytes, expected %u", d->got.size, d->want.size);
+            SDL_CloseAudioDevice(d->opened); d->opened = 0;
+        }
+        d->done.store(true, std::memory_order_release);
+        return 0;
+    }
+    void lose(Device* d, Uint32 now)
+    { // Our device is gone : close it, reopen at the next update()
+        if(d->state != PLAYING) return;
+        SDL_CloseAudioDevice(d->id); d->id = 0;
+        d->state = LOST; d->lost_at = now; d->retry_at = now;
+    }
+    void removed(Device* d, Uint32 which, bool iscapture, Uint32 now)
+    { // SDL_AUDIODEVICEREMOVED : which is a device id
+        if(!iscapture && (which == d->id)) lose(d, now);
+    }
+    void added(Device* d, bool iscapture, Uint32 now)
+    { // SDL_AUDIODEVICEADDED : a new output may be the one to use
+        if(!iscapture && (d->state == LOST)) d->retry_at = now;
+    }
+    Result update(Device* d, Uint32 now)
+    { // UI thread, once per frame. REOPENED : d.id is open and paused.
+        if((d->state == LOST) && (static_cast<Sint32>(now - d->retry_at) >= 0))
+        {
+            d->done.store(false, std::memory_order_relaxed);
+            d->thread = SDL_CreateThread(open_thread, "audio open", d);
+            if(d->thread) d->state = OPENING;
+            else d->retry_at = now + RETRY_MS;
+            return NOTHING;
+        }
+        if((d->state != OPENING) || !d->done.load(std::memory_order_acquire)) return NOTHING;
+        SDL_WaitThread(d->thread, NULL); d->thread = NULL;
+        if(d->opened == 0)
+        {
+            d->state = LOST; d->retry_at = now + RETRY_MS;
+            return RETRY;
+        }
+        d->id = d->opened; d->opened = 0;
+        d->state = PLAYING; d->reopens++;
+        return REOPENED;
+    }
+    void close(Device* d)
+    { // Shutdown : wait for a reopen still running, close whatever is open
+        if(d->thread) { SDL_WaitThread(d->thread, NULL); d->thread = NULL; }
+        if(d->opened) { SDL_CloseAudioDevice(d->opened); d->opened = 0; }
+        if(d->id) { SDL_CloseAudioDevice(d->id); d->id = 0; }
+        d->state = CLOSED;
+    }
+}
+
+#endif // __MG_AUDIO_DEVICE_H__
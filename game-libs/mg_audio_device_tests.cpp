@@ -0,0 +1,77 @@
+#include <atomic>
+#include <cstring>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_audio_device.h"
+
+namespace AudioDeviceTests
+{
+    std::atomic<int> calls{0};
+    void SDLCALL callback(void*, Uint8* stream, int len) { memset(stream, 0, len); calls++; }
+    bool plays(void)
+    { // Callback runs (a few buffers within a second)
+        calls = 0;
+        for(int k=0; (k<200) && (calls < 3); k++) SDL_Delay(5);
+        return calls >= 3;
+    }
+    AudioDevice::Result reopen(AudioDevice::Device* d, Uint32 now)
+    { // update() until the opener thread is done
+        AudioDevice::Result r = AudioDevice::NOTHING;
+        for(int k=0; (k<400) && (r == AudioDevice::NOTHING); k++) { r = AudioDevice::update(d, now); SDL_Delay(5); }
+        return r;
+    }
+}
+
+void run_tests_for_mg_audio_device()
+{
+    using namespace AudioDeviceTests;
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);         // No sound card needed
+    if(SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
+    {
+        Tests::note("SKIP mg_audio_device : no dummy audio driver (%s)", SDL_GetError());
+        return;
+    }
+    SDL_AudioSpec want{};
+    want.freq = 44100; want.format = AUDIO_S16SYS; want.channels = 1;
+    want.samples = 512; want.size = 1024; want.callback = callback;
+    AudioDevice::Device d; SDL_AudioSpec got{};
+    TEST(AudioDevice::open(&d, &want, &got) != 0);
+    TESTeq(d.state, AudioDevice::PLAYING);
+    SDL_PauseAudioDevice(d.id, 0);
+    TEST(plays());
+    { // Other devices come and go : nothing to do
+        AudioDevice::removed(&d, d.id + 1, false, 0);
+        AudioDevice::removed(&d, d.id, true, 0);        // A microphone with the same id
+        AudioDevice::added(&d, false, 0);
+        TESTeq(d.state, AudioDevice::PLAYING);
+        TESTeq(AudioDevice::update(&d, 0), AudioDevice::NOTHING);
+    }
+    { // Output removed : closed at once, reopened off the UI thread, same callback
+        AudioDevice::removed(&d, d.id, false, 100);
+        TESTeq(d.state, AudioDevice::LOST);
+        TESTeq(d.id, 0);
+        TESTeq(AudioDevice::update(&d, 100), AudioDevice::NOTHING);  // Opener started
+        TESTeq(d.state, AudioDevice::OPENING);
+        TESTeq(reopen(&d, 100), AudioDevice::REOPENED);
+        TEST(d.id != 0);
+        TESTeq(d.reopens, 1);
+        SDL_PauseAudioDevice(d.id, 0);                  // Caller starts it
+        TEST(plays());
+    }
+    { // Reopen fails : retry every RETRY_MS, or at once when an output shows up
+        d.want.size++;                                  // Device buffer will not match
+        AudioDevice::lose(&d, 1000);
+        TESTeq(reopen(&d, 1000), AudioDevice::RETRY);
+        TEST(d.error[0] != '\0');
+        TESTeq(d.id, 0);
+        TESTeq(AudioDevice::update(&d, 1000 + AudioDevice::RETRY_MS - 1), AudioDevice::NOTHING);
+        TESTeq(d.state, AudioDevice::LOST);
+        d.want.size--;
+        AudioDevice::added(&d, false, 1500);
+        TESTeq(reopen(&d, 1500), AudioDevice::REOPENED);
+        TESTeq(d.reopens, 2);
+    }
+    AudioDevice::close(&d);
+    TESTeq(d.id, 0);
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
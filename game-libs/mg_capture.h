@@ -0,0 +1,203 @@
+#ifndef __MG_CAPTURE_H__
+#define __MG_CAPTURE_H__
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include "mg_flac.h"
+
+namespace Capture
+{ // Record what the audio thread plays to a WAV or FLAC file, off the audio thread (include SDL.h first)
+    /* *************DOC***************
+     * Audio thread, after the final mix:
+     *
+     *      Capture::write_le16(&tap, bytes, n);        // Copies, never waits
+     *
+     * UI thread:
+     *
+     *      Capture::start(&tap, "capture.flac", Capture::FLAC, 44100);
+     *      ...tap.dropped : blocks lost so far...
+     *      Capture::stop(&tap);                        // Joins the writer, closes the file
+     *
+     * The tap is a single-producer single-consumer ring of NUM_BLOCKS blocks.
+     * The audio thread fills a block, then publishes it with one atomic store.
+     * A writer thread takes whole blocks, encodes them into a large buffer and
+     * fwrite()s the buffer when it is full. Only the writer thread touches the
+     * file.
+     *
+     * If the disk stalls long enough for the ring to fill (NUM_BLOCKS*BLOCK
+     * samples, ~6s at 44.1kHz), the audio thread drops whole blocks and counts
+     * them in tap.dropped : the file has a gap, the sound does not glitch. Memory
+     * is the ring and the buffer, however long the recording.
+     *
+     * WAV sizes are 32-bit : a WAV stops growing at 4GB (~13h of 44.1kHz mono)
+     * and stop() reports it. FLAC has no such limit. The last partial block
+     * (under BLOCK samples) is not written.
+     *
+     * For tests : open(), drain(), close() are start() and stop() without the
+     * thread.
+     * *******************************/
+    enum Format { WAV, FLAC };
+    constexpr int BLOCK = 4096;                         // Samples per block : one FLAC frame
+    constexpr Uint32 NUM_BLOCKS = 64;                   // Power of two
+    constexpr size_t OUT_BYTES = 1<<18;                 // Writes are this big (but the last)
+    constexpr int WAV_HEADER_BYTES = 44;
+    constexpr Uint64 WAV_MAX_DATA = 0xFFFFFFFFull - 36; // RIFF size is 32-bit
+    constexpr Uint32 WAIT_MS = 10;                      // Writer sleeps this long when the ring is empty
+    static_assert(BLOCK <= Flac::MAX_BLOCK, "one block is one FLAC frame");
+    static_assert((NUM_BLOCKS & (NUM_BLOCKS-1)) == 0, "ring index wraps with a mask");
+    struct Tap
+    {
+        Sint16 blocks[NUM_BLOCKS][BLOCK]{};             // Ring : audio fills, writer empties
+        std::atomic<Uint32> head{0};                    // Blocks published (audio, wraps)
+        std::atomic<Uint32> tail{0};                    // Blocks taken (writer, wraps)
+        std::atomic<Uint32> session{0};                 // UI : odd while recording
+        std::atomic<Uint32> dropped{0};                 // Blocks the ring had no room for
+        // Audio thread only
+        Uint32 seen{};                                  // Session of the block being filled
+        int fill{};                                     // Samples in the block being filled
+        bool skip{};                                    // No room : drop the block being filled
+        // Writer thread (UI before start, after stop)
+        SDL_Thread* thread{};
+        std::atomic<bool> quit{false};
+        FILE* f{};
+        Format format{};
+        int sample_rate{};
+        Uint64 samples{};                               // Written to the file
+        Uint32 frames{};                                // FLAC frame number
+        size_t used{};                                  // Bytes in out
+        Uint8 out[OUT_BYTES]{};
+        char error[96]{};                               // Why the file is short, if it is
+    };
+
+    ////////////////
+    // AUDIO THREAD
+    ////////////////
+    void write_le16(Tap* t, const Uint8* bytes, Uint32 n)
+    { // Append n 16-bit little-endian samples. No-op unless recording.
+        Uint32 s = t->session.load(std::memory_order_acquire);
+        if((s & 1) == 0) return;
+        if(s != t->seen) { t->seen = s; t->fill = 0; }  // New recording : drop what the last one left
+        while(n > 0)
+        {
+            Uint32 head = t->head.load(std::memory_order_relaxed);
+            if(t->fill == 0) t->skip = (head - t->tail.load(std::memory_order_acquire) >= NUM_BLOCKS);
+            Uint32 k = static_cast<Uint32>(BLOCK - t->fill);
+            if(k > n) k = n;
+            if(!t->skip) memcpy(&t->blocks[head & (NUM_BLOCKS-1)][t->fill], bytes, 2*k);
+            t->fill += static_cast<int>(k); bytes += 2*k; n -= k;
+            if(t->fill < BLOCK) break;
+            t->fill = 0;
+            if(t->skip) t->dropped.fetch_add(1, std::memory_order_relaxed);
+            else        t->head.store(head+1, std::memory_order_release);
+        }
+    }
+
+    ////////////////
+    // WRITER
+    ////////////////
+    void wav_header(Uint8* h, int sample_rate, Uint32 data_bytes)
+    { // WAV_HEADER_BYTES : 16-bit mono PCM
+        auto le = [&h](Uint32 v, int bytes) { for(int i=0; i<bytes; i++) *h++ = static_cast<Uint8>(v >> (8*i)); };
+        memcpy(h, "RIFF", 4); h += 4; le(36 + data_bytes, 4);
+        memcpy(h, "WAVEfmt ", 8); h += 8; le(16, 4);
+        le(1, 2); le(1, 2);                             // PCM, mono
+        le(static_cast<Uint32>(sample_rate), 4); le(static_cast<Uint32>(2*sample_rate), 4);
+        le(2, 2); le(16, 2);                            // Bytes per frame, bits per sample
+        memcpy(h, "data", 4); h += 4; le(data_bytes, 4);
+    }
+    bool flush(Tap* t)
+    {
+        bool ok = (fwrite(t->out, 1, t->used, t->f) == t->used);
+        if(!ok && !t->error[0]) snprintf(t->error, sizeof(t->error), "write failed (disk full?)");
+        t->used = 0;
+        return ok;
+    }
+    bool drain(Tap* t)
+    { // Writer : encode every published block. False if there were none.
+        Uint32 tail = t->tail.load(std::memory_order_relaxed);
+        Uint32 head = t->head.load(std::memory_order_acquire);
+        if(tail == head) return false;
+        for(; tail != head; tail++)
+        {
+            const Sint16* x = t->blocks[tail & (NUM_BLOCKS-1)];
+            size_t need = (t->format == FLAC) ? Flac::max_frame_bytes(BLOCK) : 2*BLOCK;
+            if(t->used + need > OUT_BYTES) flush(t);
+            if((t->format == WAV) && (2*(t->samples + BLOCK) > WAV_MAX_DATA) && !t->error[0])
+                snprintf(t->error, sizeof(t->error), "WAV is full (4GB) : record FLAC for longer takes");
+            if(t->error[0]) {}                          // File is done : keep emptying the ring
+            else if(t->format == FLAC)
+            {
+                t->used += Flac::frame(t->out + t->used, x, BLOCK, t->frames++, t->sample_rate);
+                t->samples += BLOCK;
+            }
+            else
+            {
+                memcpy(t->out + t->used, x, 2*BLOCK);   // Little-endian (x86/ARM) : already WAV order
+                t->used += 2*BLOCK;
+                t->samples += BLOCK;
+            }
+            t->tail.store(tail+1, std::memory_order_release);   // Room for the audio thread right away
+        }
+        return true;
+    }
+    bool open(Tap* t, const char* path, Format format, int sample_rate)
+    { // UI : create the file. Recording starts now. False if it is already on or the file fails.
+        if(t->f) return false;
+        t->f = fopen(path, "wb");
+        if(t->f == NULL) return false;
+        t->format = format; t->sample_rate = sample_rate;
+        t->samples = 0; t->frames = 0; t->used = 0; t->error[0] = '\0';
+        t->dropped.store(0, std::memory_order_relaxed);
+        if(format == FLAC) { Flac::header(t->out, sample_rate, 0); t->used = Flac::HEADER_BYTES; }
+        else               { wav_header(t->out, sample_rate, 0); t->used = WAV_HEADER_BYTES; }
+        t->tail.store(t->head.load(std::memory_order_acquire), std::memory_order_relaxed);   // Nothing stale
+        t->session.fetch_add(1, std::memory_order_acq_rel); // Odd : audio starts filling
+        return true;
+    }
+    bool close(Tap* t)
+    { // UI : stop recording, write what is left, fix the header. False if the file is short or bad.
+        if(t->f == NULL) return false;
+        if(t->session.load(std::memory_order_relaxed) & 1) t->session.fetch_add(1, std::memory_order_acq_rel);
+        drain(t);                                       // Blocks published before the audio saw that
+        bool ok = flush(t);
+        Uint8 h[Flac::HEADER_BYTES];
+        size_t len;
+        if(t->format == FLAC) { Flac::header(h, t->sample_rate, t->samples); len = Flac::HEADER_BYTES; }
+        else                  { wav_header(h, t->sample_rate, static_cast<Uint32>(2*t->samples)); len = WAV_HEADER_BYTES; }
+        ok = (fseek(t->f, 0, SEEK_SET) == 0) && (fwrite(h, 1, len, t->f) == len) && ok;
+        ok = (fclose(t->f) == 0) && ok;
+        t->f = NULL;
+        return ok && !t->error[0];
+    }
+    int SDLCALL writer_thread(void* userdata)
+    {
+        Tap* t = static_cast<Tap*>(userdata);
+        while(!t->quit.load(std::memory_order_acquire))
+        {
+            if(!drain(t)) SDL_Delay(WAIT_MS);
+        }
+        return 0;
+    }
+    bool recording(const Tap* t) { return t->f != NULL; }
+    bool start(Tap* t, const char* path, Format format, int sample_rate)
+    { // UI : open the file and start the writer thread
+        if(!open(t, path, format, sample_rate)) return false;
+        t->quit.store(false, std::memory_order_relaxed);
+        t->thread = SDL_CreateThread(writer_thread, "capture", t);
+        if(t->thread == NULL) { close(t); return false; }
+        return true;
+    }
+    bool stop(Tap* t)
+    { // UI : join the writer, then close(). Also the shutdown call : no-op if not recording.
+        if(t->thread)
+        {
+            t->quit.store(true, std::memory_order_release);
+            SDL_WaitThread(t->thread, NULL);
+            t->thread = NULL;
+        }
+        return recording(t) && close(t);
+    }
+}
+
+#endif // __MG_CAPTURE_H__
@@ -0,0 +1,117 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_capture.h"
+
+namespace CaptureTests
+{
+    const char* PATH = "mg_capture_tests.out";          // Removed when done
+    Capture::Tap tap;
+    Sint16 played[3*Capture::BLOCK + 100];              // What the "audio thread" wrote
+    Sint16 got[3*Capture::BLOCK + 100];
+    Uint8 file[4*Capture::BLOCK*2];
+    void play(Sint16 first, int n, Uint32 chunk)
+    { // Audio thread writes n samples in device-buffer chunks
+        for(int i=0; i<n; i++) played[i] = static_cast<Sint16>(first + 7*i);
+        const Uint8* p = reinterpret_cast<const Uint8*>(played);
+        for(Uint32 done=0; done<static_cast<Uint32>(n); done+=chunk)
+            Capture::write_le16(&tap, p + 2*done, (n - done < chunk) ? n - done : chunk);
+    }
+    size_t read_file(void)
+    {
+        FILE* f = fopen(PATH, "rb");
+        if(f == NULL) return 0;
+        size_t n = fread(file, 1, sizeof(file), f);
+        fclose(f);
+        return n;
+    }
+    Uint32 le32(const Uint8* p) { return p[0] | (p[1]<<8) | (p[2]<<16) | (static_cast<Uint32>(p[3])<<24); }
+    size_t frame(Sint16* x, int n, Uint32 number)
+    {
+        size_t len = Flac::frame(file, x, n, number, 44100);
+        bool crcs = (Flac::crc16(file, len) == 0);      // Data then its CRC : remainder 0
+        if(!crcs) Tests::note("frame %u : bad CRC-16", number);
+        return crcs ? len : 0;
+    }
+}
+
+void run_tests_for_mg_capture()
+{
+    using namespace CaptureTests;
+    { // Not recording : the tap ignores audio
+        play(0, Capture::BLOCK, 512);
+        TESTeq(tap.head.load(), 0);
+        TEST(!Capture::recording(&tap));
+        TEST(!Capture::close(&tap));
+    }
+    { // WAV : whole blocks round trip, in any chunk size; the header has the sizes
+        TEST(Capture::open(&tap, PATH, Capture::WAV, 44100));
+        TEST(!Capture::open(&tap, PATH, Capture::WAV, 44100));  // Already recording
+        play(-3000, 3*Capture::BLOCK + 100, 441);
+        TEST(Capture::drain(&tap));
+        TEST(!Capture::drain(&tap));                    // Nothing new
+        TEST(Capture::close(&tap));
+        size_t n = read_file();
+        TESTeq(n, Capture::WAV_HEADER_BYTES + 2*3*Capture::BLOCK);   // Partial block not written
+        TEST(memcmp(file, "RIFF", 4) == 0 && memcmp(file+8, "WAVEfmt ", 8) == 0);
+        TESTeq(le32(file+4), 36 + 2*3*Capture::BLOCK);
+        TESTeq(le32(file+24), 44100);
+        TESTeq(le32(file+40), 2*3*Capture::BLOCK);
+        memcpy(got, file + Capture::WAV_HEADER_BYTES, 2*3*Capture::BLOCK);
+        TEST(memcmp(got, played, 2*3*Capture::BLOCK) == 0);
+        TEST(!Capture::recording(&tap));
+    }
+    { // Writer stalls : the audio thread drops whole blocks and counts them, never waits
+        TEST(Capture::open(&tap, PATH, Capture::WAV, 44100));
+        TESTeq(tap.dropped.load(), 0);                  // Counts are per recording
+        for(Uint32 b=0; b<Capture::NUM_BLOCKS + 3; b++) play(static_cast<Sint16>(b), Capture::BLOCK, 1024);
+        TESTeq(tap.dropped.load(), 3);
+        TESTeq(tap.head.load() - tap.tail.load(), Capture::NUM_BLOCKS);
+        TEST(Capture::drain(&tap));                     // Disk is back
+        play(1, Capture::BLOCK, 1024);
+        TESTeq(tap.dropped.load(), 3);
+        TEST(Capture::close(&tap));
+        TESTeq(tap.samples, static_cast<Uint64>(Capture::NUM_BLOCKS + 1)*Capture::BLOCK);
+    }
+    { // Writer thread : start, play, stop
+        TEST(Capture::start(&tap, PATH, Capture::WAV, 44100));
+        play(5, 2*Capture::BLOCK, 735);
+        TEST(Capture::stop(&tap));
+        TESTeq(tap.samples, 2*Capture::BLOCK);
+        TEST(!Capture::stop(&tap));                     // Not recording
+    }
+    { // FLAC : CRCs check out, and frames shrink when the signal is predictable
+        TESTeq(Flac::crc8(reinterpret_cast<const Uint8*>("123456789"), 9), 0xF4);
+        TESTeq(Flac::crc16(reinterpret_cast<const Uint8*>("123456789"), 9), 0xFEE8);
+        Sint16* x = got;
+        for(int i=0; i<Capture::BLOCK; i++) x[i] = 0;
+        size_t silence = frame(x, Capture::BLOCK, 0);
+        const bool silence_ok = (silence > 0 && silence < 16);  // One CONSTANT subframe
+        TEST(silence_ok);
+        for(int i=0; i<Capture::BLOCK; i++) x[i] = static_cast<Sint16>(10000*sin(0.05*i));
+        size_t sine = frame(x, Capture::BLOCK, 300);    // Two-byte frame number
+        const bool sine_ok = (sine > 0 && sine < Capture::BLOCK/2);   // Under a quarter of verbatim
+        TEST(sine_ok);
+        Uint32 rng = 1;
+        for(int i=0; i<Capture::BLOCK; i++) { rng = rng*1664525u + 1013904223u; x[i] = static_cast<Sint16>(rng >> 16); }
+        size_t noise = frame(x, 100, 70000);            // Odd size, three-byte frame number
+        const bool noise_ok = (noise > 0 && noise <= Flac::max_frame_bytes(100));   // Verbatim
+        TEST(noise_ok);
+        if(!(silence_ok && sine_ok && noise_ok)) Tests::note("FLAC frame bytes : silence %zu, sine %zu, noise (100 samples) %zu", silence, sine, noise);
+    }
+    { // FLAC file : STREAMINFO has the sample count once closed
+        TEST(Capture::open(&tap, PATH, Capture::FLAC, 44100));
+        play(0, 3*Capture::BLOCK, 512);
+        TEST(Capture::close(&tap));
+        size_t n = read_file();
+        TEST(n > Flac::HEADER_BYTES && n < Flac::HEADER_BYTES + 2*3*Capture::BLOCK);
+        TEST(memcmp(file, "fLaC", 4) == 0);
+        TESTeq(file[4], 0x80);                          // Last metadata block, STREAMINFO
+        TESTeq((file[18] << 12) | (file[19] << 4) | (file[20] >> 4), 44100);
+        TESTeq((file[22] << 24) | (file[23] << 16) | (file[24] << 8) | file[25], 3*Capture::BLOCK);
+        TEST(file[Flac::HEADER_BYTES] == 0xFF && file[Flac::HEADER_BYTES+1] == 0xF8);   // First frame sync
+    }
+    remove(PATH);
+}
@@ -22,7 +22,21 @@ void run_examples_for_mg_colors()
 
 void run_tests_for_mg_colors()
 {
-    { // Placeholder : example test
-        TESTeq(1,2);
+    { // Every color has a name
+        TESTeq(sizeof(Colors::name)/sizeof(Colors::name[0]), Colors::count);
+    }
+    { // next() and prev() walk the whole list and wrap
+        int i = Colors::count-1;
+        Colors::next(i); TESTeq(i, 0);
+        Colors::prev(i); TESTeq(i, Colors::count-1);
+    }
+    { // Every color contrasts with a color in the list
+        bool ok = true;
+        for(int i=0; i<Colors::count; i++)
+        {
+            int c = Colors::contrasts(i);
+            if((c < 0) || (c >= Colors::count)) ok = false;
+        }
+        TEST(ok);
     }
 }
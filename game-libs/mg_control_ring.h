@@ -0,0 +1,118 @@
+#ifndef __MG_CONTROL_RING_H__
+#define __MG_CONTROL_RING_H__
+
+#include <atomic>
+
+namespace ControlRing
+{ // Timestamped control values from UI thread to audio thread (include SDL.h first)
+    /* *************DOC***************
+     * The UI thread push()es a Point for every input sample (e.g. every mouse motion
+     * event), stamped with the event time. The audio thread reads them back as a
+     * smooth curve: next() gives the value at the current audio time, interpolated
+     * between the two points on either side. So control changes land at the right
+     * sample, not once per frame or once per audio block.
+     *
+     * Audio time runs DELAY_MS behind the wall clock, so the points it needs are
+     * already in the ring by the time it gets there. While no newer point is in the
+     * ring, the curve holds the last value (input is idle), so the next point ramps
+     * from when input resumed, not from when it stopped.
+     *
+     * In the first DELAY_MS of SDL ticks audio time is negative. Every point is
+     * after it, so the curve holds its initial values until time reaches 0.
+     *
+     *      UI thread                      audio thread
+     *      push({t, v})  --> Ring -->     begin(&curve, SDL_GetTicks());
+     *                                     for each sample : next(&curve, &ring, v);
+     *
+     * The Ring is single-producer single-consumer: one atomic index each. If the
+     * audio thread stops reading (device paused), push() drops points instead of
+     * blocking.
+     * *******************************/
+    constexpr Uint32 SIZE = 1<<10;                      // Points in ring
+    constexpr Uint32 MASK = SIZE-1;
+    constexpr int NUM_VALUES = 2;                       // Control values per point
+    struct Point
+    {
+        Uint32 t_ms{};                                  // Event time (SDL_GetTicks)
+        float v[NUM_VALUES]{};
+    };
+    struct Ring
+    {
+        Point buf[SIZE]{};
+        std::atomic<Uint32> head{0};                    // Next write (UI thread)
+        std::atomic<Uint32> tail{0};                    // Next read (audio thread)
+        Uint32 dropped{};                               // Points lost to a full ring
+    };
+    bool push(Ring* r, const Point& p)
+    { // UI thread : add a point. False (and dropped) if ring is full.
+        Uint32 h = r->head.load(std::memory_order_relaxed);
+        if(h - r->tail.load(std::memory_order_acquire) >= SIZE) { r->dropped++; return false; }
+        r->buf[h&MASK] = p;
+        r->head.store(h+1, std::memory_order_release);
+        return true;
+    }
+    bool pop(Ring* r, Point* p)
+    { // Audio thread : take the oldest point. False if ring is empty.
+        Uint32 t = r->tail.load(std::memory_order_relaxed);
+        if(t == r->head.load(std::memory_order_acquire)) return false;
+        *p = r->buf[t&MASK];
+        r->tail.store(t+1, std::memory_order_release);
+        return true;
+    }
+
+    ////////////////
+    // CURVE
+    ////////////////
+    constexpr double DELAY_MS = 10;                     // Audio time lags wall clock by this
+    constexpr double RESYNC_MS = 50;                    // Jump audio time if it drifts this far
+    struct Curve
+    { // Audio thread state
+        Point prev{};                                   // Last point at or before t
+        Point next{};                                   // First point after t
+        bool has_next{};
+        double t{};                                     // Audio time in ms (< 0 at startup)
+        double ms_per_sample{};
+        bool started{};                                 // begin() has set t
+    };
+    void init(Curve* c, int sample_rate, const float* v)
+    { // Start holding values v
+        c->ms_per_sample = 1000.0/sample_rate;
+        for(int i=0; i<NUM_VALUES; i++) c->prev.v[i] = v[i];
+        c->has_next = false;
+        c->t = 0; c->started = false;
+    }
+    void begin(Curve* c, Uint32 now_ms)
+    { // Call once per audio block. Keeps audio time continuous unless it drifted.
+        double want = now_ms - DELAY_MS;
+        double drift = c->t - want;
+        if(!c->started || (drift > RESYNC_MS) || (drift < -RESYNC_MS)) c->t = want;
+        c->started = true;
+    }
+    void next(Curve* c, Ring* r, float* v)
+    { // Values at audio time, then advance audio time one sample
+        for(;;)
+        { // Move past every point at or before t
+            if(!c->has_next)
+            {
+                if(!pop(r, &c->next)) break;
+                c->has_next = true;
+            }
+            if(c->next.t_ms > c->t) break;
+            c->prev = c->next; c->has_next = false;
+        }
+        if(c->has_next && (c->next.t_ms > c->prev.t_ms))
+        { // Between two points : interpolate
+            float a = static_cast<float>((c->t - c->prev.t_ms)/(c->next.t_ms - c->prev.t_ms));
+            if(a < 0) a = 0;                            // prev is from before a resync
+            for(int i=0; i<NUM_VALUES; i++) v[i] = c->prev.v[i] + a*(c->next.v[i] - c->prev.v[i]);
+        }
+        else
+        { // No newer point yet : hold, and remember prev was still true at t
+            for(int i=0; i<NUM_VALUES; i++) v[i] = c->prev.v[i];
+            if(!c->has_next) c->prev.t_ms = (c->t > 0) ? static_cast<Uint32>(c->t) : 0;
+        }
+        c->t += c->ms_per_sample;
+    }
+}
+
+#endif // __MG_CONTROL_RING_H__
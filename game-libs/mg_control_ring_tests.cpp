@@ -0,0 +1,98 @@
+#include <cstdio>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_control_ring.h"
+
+void run_tests_for_mg_control_ring()
+{
+    constexpr int RATE = 44100;
+    const double ms_per_sample = 1000.0/RATE;
+    const float zero[ControlRing::NUM_VALUES] = {0, 0};
+    float v[ControlRing::NUM_VALUES];
+    { // A control change lands on the sample at its timestamp (within one sample)
+        static ControlRing::Ring r; ControlRing::Curve c;
+        ControlRing::init(&c, RATE, zero);
+        ControlRing::begin(&c, 1000);                   // Audio time : 1000 - DELAY_MS
+        TESTnear(c.t, 1000 - ControlRing::DELAY_MS, 1e-9);
+        for(int i=0; i<44; i++) ControlRing::next(&c, &r, v);   // Idle : hold 0
+        TESTeq(v[0], 0.0f);
+        double t_idle = c.t;
+        ControlRing::push(&r, ControlRing::Point{1000, {1, 0.5f}});
+        int first = -1; bool rising = true; float last = 0;
+        for(int i=0; i<2*RATE/100; i++)
+        { // 20ms of samples
+            ControlRing::next(&c, &r, v);
+            if(v[0] < last) rising = false;
+            last = v[0];
+            if((first < 0) && (v[0] == 1)) first = i;
+        }
+        int want = static_cast<int>(SDL_ceil((1000 - t_idle)/ms_per_sample));
+        TEST(first >= 0);
+        TEST((first >= want-1) && (first <= want+1));
+        if((first < want-1) || (first > want+1)) Tests::note("change at sample %d, want %d", first, want);
+        TEST(rising);                                   // Ramps up, never overshoots
+        TESTeq(v[0], 1.0f); TESTeq(v[1], 0.5f);         // Holds the last point
+    }
+    { // Between two points : straight line
+        static ControlRing::Ring r; ControlRing::Curve c;
+        ControlRing::init(&c, RATE, zero);
+        ControlRing::begin(&c, 2000);                   // Audio time 1990
+        ControlRing::push(&r, ControlRing::Point{1990, {0, 0}});
+        ControlRing::push(&r, ControlRing::Point{2000, {1, 0}});
+        float max_err = 0;
+        for(int i=0; i<RATE/100; i++)
+        { // 10ms : the whole ramp
+            double t = c.t;
+            ControlRing::next(&c, &r, v);
+            float want = static_cast<float>((t - 1990)/10);
+            float err = (v[0] > want) ? v[0]-want : want-v[0];
+            if(err > max_err) max_err = err;
+        }
+        TESTnear(max_err, 0, 1e-4);
+    }
+    { // Points older than audio time apply on the next sample
+        static ControlRing::Ring r; ControlRing::Curve c;
+        ControlRing::init(&c, RATE, zero);
+        ControlRing::begin(&c, 5000);
+        ControlRing::push(&r, ControlRing::Point{100, {0.25f, 0.75f}});
+        ControlRing::next(&c, &r, v);
+        TESTeq(v[0], 0.25f); TESTeq(v[1], 0.75f);
+    }
+    { // Audio time is continuous across blocks, jumps only if it drifts too far
+        ControlRing::Curve c;
+        ControlRing::init(&c, RATE, zero);
+        ControlRing::begin(&c, 1000);
+        c.t += 512*ms_per_sample;                       // One block of samples later
+        double t = c.t;
+        ControlRing::begin(&c, 1013);                   // Callback a little late : keep going
+        TESTeq(c.t, t);
+        ControlRing::begin(&c, 1013 + 2*ControlRing::RESYNC_MS); // Device stalled : resync
+        TESTnear(c.t, 1013 + 2*ControlRing::RESYNC_MS - ControlRing::DELAY_MS, 1e-9);
+    }
+    { // First DELAY_MS of ticks : audio time is negative, hold, then ramp to the first point
+        static ControlRing::Ring r; ControlRing::Curve c;
+        const float start[ControlRing::NUM_VALUES] = {0.5f, 0.5f};
+        ControlRing::init(&c, RATE, start);
+        ControlRing::begin(&c, 0);                      // Callback right at SDL_Init
+        TESTnear(c.t, -ControlRing::DELAY_MS, 1e-9);
+        for(int i=0; i<RATE/200; i++) ControlRing::next(&c, &r, v);    // 5ms, all before 0
+        TESTeq(v[0], 0.5f);
+        TESTeq(c.prev.t_ms, 0);                         // Held since 0, not a wrapped negative
+        ControlRing::begin(&c, 5);                      // Next block : time carries on
+        TESTnear(c.t, -5, ms_per_sample);
+        ControlRing::push(&r, ControlRing::Point{10, {1, 1}});
+        for(int i=0; i<RATE/100; i++) ControlRing::next(&c, &r, v);    // Up to t = 5
+        TEST((v[0] > 0.5f) && (v[0] < 1));              // Ramping from 0 toward the point at 10
+        TESTnear(v[0], 0.75f, 0.01);
+    }
+    { // Full ring drops new points instead of blocking
+        static ControlRing::Ring r;
+        bool ok = true;
+        for(Uint32 i=0; i<ControlRing::SIZE; i++) ok = ok && ControlRing::push(&r, ControlRing::Point{i, {0, 0}});
+        TEST(ok);
+        TEST(!ControlRing::push(&r, ControlRing::Point{0, {0, 0}}));
+        TESTeq(r.dropped, 1);
+        ControlRing::Point p;
+        TEST(ControlRing::pop(&r, &p)); TESTeq(p.t_ms, 0);   // Oldest first
+    }
+}
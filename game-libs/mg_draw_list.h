@@ -0,0 +1,168 @@
+#ifndef __MG_DRAW_LIST_H__
+#define __MG_DRAW_LIST_H__
+
+namespace DrawList
+{ // Record lines and rects as quads, draw them all with one call (include SDL.h first)
+    /* *************DOC***************
+     * Every SDL_SetRenderDrawColor + SDL_RenderDrawLine pair is a separate trip through
+     * the renderer. With thousands of primitives per frame, that adds up.
+     *
+     * A DrawList::List records every primitive as a quad (4 vertices, 6 indices) with
+     * the color stored per vertex. Nothing is drawn until flush(), which sends the whole
+     * list in one SDL_RenderGeometry call.
+     *
+     * One call only works if everything in it uses the same texture and blend mode.
+     * set_state() flushes whatever is recorded before switching.
+     *
+     *      DrawList::List dl;
+     *      DrawList::init(&dl, 1<<12);                 // Allocate once at startup
+     *      ...every frame...
+     *      DrawList::begin(&dl, ren, SDL_BLENDMODE_ADD);
+     *      DrawList::line(&dl, 0,0, 10,10, Colors::lime);
+     *      DrawList::fill_rect(&dl, SDL_Rect{1,2,3,4}, Colors::tardis);
+     *      DrawList::flush(&dl);                       // Draw it all
+     *      ...at shutdown...
+     *      DrawList::destroy(&dl);
+     *
+     * Coordinates are pixel coordinates, same as SDL_RenderDrawLine etc.:
+     * - line() covers the pixels from x0,y0 to x1,y1 (both ends included)
+     * - fill_rect() covers r.w x r.h pixels
+     * - rect() covers the 1-pixel border of r, corners drawn once
+     * *******************************/
+    struct List
+    {
+        SDL_Vertex* verts{};                            // 4 per quad, allocated in init()
+        int* indices{};                                 // 6 per quad, allocated in init()
+        int max_quads{};
+        int num_quads{};
+        SDL_Renderer* ren{};
+        SDL_Texture* tex{};                             // NULL : untextured
+        SDL_BlendMode blend{SDL_BLENDMODE_BLEND};
+        int num_calls{};                                // SDL_RenderGeometry calls since begin()
+    };
+
+    bool init(List* dl, int max_quads)
+    { // Allocate room for max_quads quads. Return false if out of memory.
+        dl->verts = (SDL_Vertex*)malloc(4*max_quads*sizeof(SDL_Vertex));
+        dl->indices = (int*)malloc(6*max_quads*sizeof(int));
+        if((dl->verts == NULL) || (dl->indices == NULL))
+        { // Free whichever one did allocate
+            free(dl->verts); dl->verts = NULL;
+            free(dl->indices); dl->indices = NULL;
+            return false;
+        }
+        dl->max_quads = max_quads;
+        for(int q=0; q<max_quads; q++)
+        { // Index pattern never changes, fill it once
+            int* i = &dl->indices[6*q];
+            i[0] = 4*q+0; i[1] = 4*q+1; i[2] = 4*q+2;
+            i[3] = 4*q+0; i[4] = 4*q+2; i[5] = 4*q+3;
+        }
+        return true;
+    }
+    void destroy(List* dl)
+    {
+        free(dl->verts); dl->verts = NULL;
+        free(dl->indices); dl->indices = NULL;
+        dl->max_quads = 0;
+    }
+    void flush(List* dl)
+    { // Draw everything recorded so far in one call
+        if(dl->num_quads == 0) return;
+        if(dl->tex == NULL) SDL_SetRenderDrawBlendMode(dl->ren, dl->blend);
+        else                SDL_SetTextureBlendMode(dl->tex, dl->blend);
+        SDL_RenderGeometry(dl->ren, dl->tex, dl->verts, 4*dl->num_quads,
+                dl->indices, 6*dl->num_quads);
+        dl->num_quads = 0;
+        dl->num_calls++;
+    }
+    void set_state(List* dl, SDL_Texture* tex, SDL_BlendMode blend)
+    { // Change texture/blend mode, flushing first if it is different
+        if((tex == dl->tex) && (blend == dl->blend)) return;
+        flush(dl);
+        dl->tex = tex;
+        dl->blend = blend;
+    }
+    void begin(List* dl, SDL_Renderer* ren, SDL_BlendMode blend)
+    { // Start recording (untextured) for this renderer
+        dl->ren = ren;
+        dl->tex = NULL;
+        dl->blend = blend;
+        dl->num_quads = 0;
+        dl->num_calls = 0;
+    }
+
+    ////////////////
+    // QUADS
+    ////////////////
+    void quad(List* dl, const SDL_FPoint p[4], const SDL_Color c[4])
+    { // Record one quad, corners in order around the edge, one color per corner
+        if(dl->num_quads == dl->max_quads) flush(dl);   // Full : draw what I have
+        SDL_Vertex* v = &dl->verts[4*dl->num_quads++];
+        for(int i=0; i<4; i++) v[i] = SDL_Vertex{p[i], c[i], SDL_FPoint{0,0}};
+    }
+    void quad(List* dl, const SDL_FPoint p[4], const SDL_FPoint uv[4], SDL_Color c)
+    { // Record one textured quad, one color for all corners
+        if(dl->num_quads == dl->max_quads) flush(dl);
+        SDL_Vertex* v = &dl->verts[4*dl->num_quads++];
+        for(int i=0; i<4; i++) v[i] = SDL_Vertex{p[i], c, uv[i]};
+    }
+    void fill_rect(List* dl, float x, float y, float w, float h, SDL_Color c)
+    {
+        if(dl->num_quads == dl->max_quads) flush(dl);
+        SDL_Vertex* v = &dl->verts[4*dl->num_quads++];
+        v[0] = SDL_Vertex{SDL_FPoint{x,   y  }, c, SDL_FPoint{0,0}};
+        v[1] = SDL_Vertex{SDL_FPoint{x+w, y  }, c, SDL_FPoint{0,0}};
+        v[2] = SDL_Vertex{SDL_FPoint{x+w, y+h}, c, SDL_FPoint{0,0}};
+        v[3] = SDL_Vertex{SDL_FPoint{x,   y+h}, c, SDL_FPoint{0,0}};
+    }
+    void fill_rect(List* dl, SDL_Rect r, SDL_Color c)
+    {
+        fill_rect(dl, static_cast<float>(r.x), static_cast<float>(r.y),
+                static_cast<float>(r.w), static_cast<float>(r.h), c);
+    }
+    void rect(List* dl, SDL_Rect r, SDL_Color c)
+    { // 1-pixel outline : top and bottom full width, sides between them
+        if((r.w <= 0) || (r.h <= 0)) return;
+        if((r.w <= 2) || (r.h <= 2)) { fill_rect(dl, r, c); return; }
+        fill_rect(dl, SDL_Rect{r.x,       r.y,       r.w, 1    }, c);
+        fill_rect(dl, SDL_Rect{r.x,       r.y+r.h-1, r.w, 1    }, c);
+        fill_rect(dl, SDL_Rect{r.x,       r.y+1,     1,   r.h-2}, c);
+        fill_rect(dl, SDL_Rect{r.x+r.w-1, r.y+1,     1,   r.h-2}, c);
+    }
+    void line(List* dl, float x0, float y0, float x1, float y1, SDL_Color c0, SDL_Color c1)
+    { // 1-pixel wide line from pixel x0,y0 to pixel x1,y1, color fades c0 to c1
+        /* *************DOC***************
+         * Run the line through pixel centers (+0.5) and extend half a pixel past each
+         * end so the end pixels are covered, like SDL_RenderDrawLine.
+         *
+         *      n : unit normal * 0.5 (half the line width)
+         *      d : unit direction * 0.5
+         *
+         *      0 ──────────────────────── 1
+         *      │ p0-d          ──→     p1+d│
+         *      3 ──────────────────────── 2
+         * *******************************/
+        float ax = x0 + 0.5f; float ay = y0 + 0.5f;
+        float bx = x1 + 0.5f; float by = y1 + 0.5f;
+        float dx = bx - ax;   float dy = by - ay;
+        float len = SDL_sqrtf(dx*dx + dy*dy);
+        if(len < 0.5f) { fill_rect(dl, x0, y0, 1, 1, c0); return; } // Just a dot
+        dx *= 0.5f/len; dy *= 0.5f/len;
+        float nx = -dy; float ny = dx;
+        SDL_FPoint p[4] = {
+            {ax - dx + nx, ay - dy + ny},
+            {bx + dx + nx, by + dy + ny},
+            {bx + dx - nx, by + dy - ny},
+            {ax - dx - nx, ay - dy - ny}};
+        SDL_Color c[4] = {c0, c1, c1, c0};
+        quad(dl, p, c);
+    }
+    void line(List* dl, int x0, int y0, int x1, int y1, SDL_Color c)
+    {
+        line(dl, static_cast<float>(x0), static_cast<float>(y0),
+                static_cast<float>(x1), static_cast<float>(y1), c, c);
+    }
+}
+
+#endif // __MG_DRAW_LIST_H__
@@ -0,0 +1,142 @@
+#ifndef __MG_FFT_H__
+#define __MG_FFT_H__
+
+namespace FFT
+{ // Real-input FFT, radix-2, precomputed tables (include SDL.h first)
+    /* *************DOC***************
+     * Spectrum of N real samples (N a power of two).
+     *
+     * Trick: pack the N real samples into N/2 complex samples
+     *
+     *      z[k] = x[2k] + i*x[2k+1]          k = 0 : N/2-1
+     *
+     * do one complex FFT of size M = N/2, then untangle the even and odd halves:
+     *
+     *      E[k] = (Z[k] + conj(Z[M-k]))/2
+     *      O[k] = (Z[k] - conj(Z[M-k]))/2i
+     *      X[k] = E[k] + W^k * O[k]          W = e^(-2*pi*i/N),  k = 0 : M
+     *
+     * That is half the work of a complex FFT of size N.
+     *
+     * Everything that does not depend on the samples is computed once in init():
+     *  - twiddles W^k for k = 0 : M-1 (the size-M FFT uses every other one)
+     *  - bit-reversal permutation for size M
+     *  - Hann window
+     *
+     *      FFT::Plan plan;
+     *      FFT::init(&plan, 4096);
+     *      FFT::magnitude(&plan, samples, mag);        // mag has N/2+1 bins
+     *      FFT::destroy(&plan);
+     *
+     * Bin k is frequency k*SAMPLE_RATE/N.
+     * *******************************/
+    struct Plan
+    {
+        int n{};                                        // Number of real samples
+        float* tw_re{}; float* tw_im{};                 // W^k, k = 0 : n/2-1
+        int* bitrev{};                                  // Size n/2 permutation
+        float* window{};                                // Hann, n samples
+        float* re{}; float* im{};                       // Work buffers, n/2 each
+        float* spec_re{}; float* spec_im{};             // Spectrum for magnitude(), n/2+1 each
+    };
+    bool init(Plan* p, int n)
+    { // n must be a power of two >= 4. Return false if out of memory.
+        SDL_assert((n >= 4) && ((n & (n-1)) == 0));
+        const int m = n/2;
+        p->n = n;
+        p->tw_re = (float*)malloc(m*sizeof(float));
+        p->tw_im = (float*)malloc(m*sizeof(float));
+        p->bitrev = (int*)malloc(m*sizeof(int));
+        p->window = (float*)malloc(n*sizeof(float));
+        p->re = (float*)malloc(m*sizeof(float));
+        p->im = (float*)malloc(m*sizeof(float));
+        p->spec_re = (float*)malloc((m+1)*sizeof(float));
+        p->spec_im = (float*)malloc((m+1)*sizeof(float));
+        if(  !p->tw_re || !p->tw_im || !p->bitrev || !p->window || !p->re || !p->im
+          || !p->spec_re || !p->spec_im) return false;
+        constexpr double PI = 3.14159265358979323846;
+        for(int k=0; k<m; k++)
+        {
+            p->tw_re[k] = static_cast<float>(SDL_cos(-2*PI*k/n));
+            p->tw_im[k] = static_cast<float>(SDL_sin(-2*PI*k/n));
+        }
+        int bits = 0; while((1<<bits) < m) bits++;
+        for(int k=0; k<m; k++)
+        {
+            int r = 0;
+            for(int b=0; b<bits; b++) if(k & (1<<b)) r |= 1<<(bits-1-b);
+            p->bitrev[k] = r;
+        }
+        for(int k=0; k<n; k++) p->window[k] = static_cast<float>(0.5 - 0.5*SDL_cos(2*PI*k/(n-1)));
+        return true;
+    }
+    void destroy(Plan* p)
+    {
+        free(p->tw_re); free(p->tw_im); free(p->bitrev); free(p->window); free(p->re); free(p->im);
+        free(p->spec_re); free(p->spec_im);
+        p->tw_re = p->tw_im = p->window = p->re = p->im = p->spec_re = p->spec_im = NULL;
+        p->bitrev = NULL;
+    }
+    void complex_fft(const Plan* p, float* re, float* im)
+    { // In-place size n/2 complex FFT, input already in bit-reversed order
+        const int m = p->n/2;
+        for(int len=2; len<=m; len<<=1)
+        {
+            const int half = len/2;
+            const int step = 2*(m/len);                 // Size-m twiddle j is W^(2*j*m/len)
+            for(int i=0; i<m; i+=len)
+            {
+                for(int j=0; j<half; j++)
+                {
+                    float wr = p->tw_re[j*step]; float wi = p->tw_im[j*step];
+                    int a = i+j; int b = a+half;
+                    float tr = re[b]*wr - im[b]*wi;
+                    float ti = re[b]*wi + im[b]*wr;
+                    re[b] = re[a] - tr; im[b] = im[a] - ti;
+                    re[a] += tr;        im[a] += ti;
+                }
+            }
+        }
+    }
+    void forward(Plan* p, const float* x, float* out_re, float* out_im, bool use_window)
+    { // Spectrum of n real samples x. Output has n/2+1 bins.
+        const int m = p->n/2;
+        float* re = p->re; float* im = p->im;
+        for(int k=0; k<m; k++)
+        { // Pack pairs of real samples as complex, in bit-reversed order
+            int r = p->bitrev[k];
+            float w0 = use_window ? p->window[2*k]   : 1;
+            float w1 = use_window ? p->window[2*k+1] : 1;
+            re[r] = x[2*k]*w0;
+            im[r] = x[2*k+1]*w1;
+        }
+        complex_fft(p, re, im);
+        for(int k=0; k<=m; k++)
+        { // Untangle even and odd samples
+            int a = (k == m) ? 0 : k;                   // Z[M] = Z[0]
+            int b = (k == 0) ? 0 : m-k;
+            float zr = re[a], zi = im[a];               // Z[k]
+            float cr = re[b], ci = -im[b];              // conj(Z[M-k])
+            float er = 0.5f*(zr + cr); float ei = 0.5f*(zi + ci);
+            float dr = 0.5f*(zr - cr); float di = 0.5f*(zi - ci);
+            float orr = di; float oi = -dr;             // O = d/i = -i*d
+            float wr, wi;
+            if(k < m) { wr = p->tw_re[k]; wi = p->tw_im[k]; }
+            else      { wr = -1; wi = 0; }              // W^M = e^(-i*pi)
+            out_re[k] = er + (wr*orr - wi*oi);
+            out_im[k] = ei + (wr*oi + wi*orr);
+        }
+    }
+    void magnitude(Plan* p, const float* x, float* mag)
+    { // |X[k]| of Hann-windowed x, scaled so a sine of amplitude 1 peaks near 1
+        forward(p, x, p->spec_re, p->spec_im, true);
+        const float scale = 4.0f/p->n;                  // 2/N, and 2x for Hann window loss
+        for(int k=0; k<=p->n/2; k++)
+        {
+            float re = p->spec_re[k]; float im = p->spec_im[k];
+            mag[k] = scale*SDL_sqrtf(re*re + im*im);
+        }
+    }
+}
+
+#endif // __MG_FFT_H__
@@ -0,0 +1,240 @@
+#ifndef __MG_FLAC_H__
+#define __MG_FLAC_H__
+
+#include <cstring>
+
+namespace Flac
+{ // Minimal FLAC encoder : 16-bit mono, fixed predictors, Rice-coded residuals (include SDL.h first)
+    /* *************DOC***************
+     * A FLAC file is "fLaC", a STREAMINFO block, then one frame per block of
+     * samples:
+     *
+     *      Uint8 head[Flac::HEADER_BYTES];
+     *      Flac::header(head, 44100, 0);                   // total unknown : patch it later
+     *      fwrite(head, 1, sizeof(head), f);
+     *      Uint8 out[Flac::max_frame_bytes(n)];
+     *      size_t len = Flac::frame(out, samples, n, frame_number++, 44100);
+     *      fwrite(out, 1, len, f);
+     *      ...at the end : header() again with the sample count, rewrite it at 0...
+     *
+     * Each frame tries the five fixed predictors (order 0 : 4) and keeps the one
+     * with the smallest Rice-coded residual, or stores the samples verbatim if
+     * that is smaller. Silence is one CONSTANT subframe. That is most of the gain
+     * of a full encoder (no LPC, no stereo decorrelation : the synth is mono).
+     *
+     * Every frame is in the FLAC "subset" (block size <= MAX_BLOCK) and carries
+     * its own CRCs, so any decoder can seek and play it. MD5 is left at 0
+     * (allowed : "not computed").
+     * *******************************/
+    constexpr int MAX_BLOCK = 4608;                     // Samples per frame (subset limit)
+    constexpr int HEADER_BYTES = 4 + 4 + 34;            // "fLaC", block header, STREAMINFO
+    constexpr size_t max_frame_bytes(int n) { return static_cast<size_t>(2*n) + 32; }  // Verbatim + headers
+
+    ////////////////
+    // BITS
+    ////////////////
+    struct Bits
+    { // MSB-first bit writer
+        Uint8* out;
+        size_t len;                                     // Whole bytes written
+        Uint64 acc;                                     // Bits not written yet (low n bits)
+        int n;
+    };
+    void put(Bits* b, Uint32 v, int count)
+    { // Low count bits of v (count <= 32)
+        b->acc = (b->acc << count) | (v & ((1ull << count) - 1));
+        b->n += count;
+        while(b->n >= 8) { b->n -= 8; b->out[b->len++] = static_cast<Uint8>(b->acc >> b->n); }
+    }
+    void align(Bits* b) { if(b->n) put(b, 0, 8 - b->n); }
+
+    ////////////////
+    // CRC
+    ////////////////
+    struct Crc8Table { Uint8 v[256]; };
+    struct Crc16Table { Uint16 v[256]; };
+    constexpr Crc8Table make_crc8(void)
+    { // Polynomial x^8 + x^2 + x + 1
+        Crc8Table t{};
+        for(int i=0; i<256; i++)
+        {
+            Uint8 c = static_cast<Uint8>(i);
+            for(int k=0; k<8; k++) c = static_cast<Uint8>((c & 0x80) ? (c << 1) ^ 0x07 : c << 1);
+            t.v[i] = c;
+        }
+        return t;
+    }
+    constexpr Crc16Table make_crc16(void)
+    { // Polynomial x^16 + x^15 + x^2 + 1
+        Crc16Table t{};
+        for(int i=0; i<256; i++)
+        {
+            Uint16 c = static_cast<Uint16>(i << 8);
+            for(int k=0; k<8; k++) c = static_cast<Uint16>((c & 0x8000) ? (c << 1) ^ 0x8005 : c << 1);
+            t.v[i] = c;
+        }
+        return t;
+    }
+    constexpr Crc8Table CRC8 = make_crc8();
+    constexpr Crc16Table CRC16 = make_crc16();
+    Uint8 crc8(const Uint8* p, size_t len)
+    {
+        Uint8 c = 0;
+        for(size_t i=0; i<len; i++) c = CRC8.v[c ^ p[i]];
+        return c;
+    }
+    Uint16 crc16(const Uint8* p, size_t len)
+    {
+        Uint16 c = 0;
+        for(size_t i=0; i<len; i++) c = static_cast<Uint16>((c << 8) ^ CRC16.v[(c >> 8) ^ p[i]]);
+        return c;
+    }
+
+    ////////////////
+    // STREAM
+    ////////////////
+    void header(Uint8* out, int sample_rate, Uint64 total_samples)
+    { // HEADER_BYTES : "fLaC" and STREAMINFO. total_samples 0 : unknown.
+        Bits b{out, 0, 0, 0};
+        put(&b, 0x664C6143, 32);                        // "fLaC"
+        put(&b, 1, 1); put(&b, 0, 7); put(&b, 34, 24);  // Last metadata block, STREAMINFO, 34 bytes
+        put(&b, 16, 16);                                // Min block size (a short last frame is allowed)
+        put(&b, MAX_BLOCK, 16);
+        put(&b, 0, 24); put(&b, 0, 24);                 // Min, max frame bytes : unknown
+        put(&b, static_cast<Uint32>(sample_rate), 20);
+        put(&b, 0, 3);                                  // Channels - 1
+        put(&b, 15, 5);                                 // Bits per sample - 1
+        put(&b, static_cast<Uint32>(total_samples >> 32) & 0xF, 4);
+        put(&b, static_cast<Uint32>(total_samples), 32);
+        for(int i=0; i<4; i++) put(&b, 0, 32);          // MD5 : not computed
+    }
+
+    ////////////////
+    // FRAME
+    ////////////////
+    void residual(const Sint16* x, int n, int order, Sint32* r)
+    { // r[i] for i = order : n-1, fixed predictor of this order
+        for(int i=order; i<n; i++)
+        {
+            switch(order)
+            {
+                case 0:  r[i] = x[i]; break;
+                case 1:  r[i] = x[i] - x[i-1]; break;
+                case 2:  r[i] = x[i] - 2*x[i-1] + x[i-2]; break;
+                case 3:  r[i] = x[i] - 3*x[i-1] + 3*x[i-2] - x[i-3]; break;
+                default: r[i] = x[i] - 4*x[i-1] + 6*x[i-2] - 4*x[i-3] + x[i-4]; break;
+            }
+        }
+    }
+    Uint32 zigzag(Sint32 r) { return (static_cast<Uint32>(r) << 1) ^ static_cast<Uint32>(r >> 31); }
+    constexpr int MAX_RICE = 14;                        // 15 is the escape code
+    constexpr int MAX_PARTITION_ORDER = 6;
+    struct Rice
+    {
+        int partition_order;
+        int k[1 << MAX_PARTITION_ORDER];                // Rice parameter per partition
+        Uint64 bits;                                    // Residual section, all partitions
+    };
+    Uint64 rice_bits(const Uint32* u, int count, int* best_k)
+    { // Fewest bits for count values with one Rice parameter, and that parameter
+        Uint64 best = ~0ull;
+        for(int k=0; k<=MAX_RICE; k++)
+        {
+            Uint64 bits = static_cast<Uint64>(count)*(k+1);
+            for(int i=0; i<count; i++) bits += u[i] >> k;
+            if(bits < best) { best = bits; *best_k = k; }
+        }
+        return best + 4;                                // Parameter
+    }
+    void plan_rice(const Uint32* u, int n, int order, Rice* best)
+    { // u[order : n-1]. Try each partition order, keep the smallest.
+        best->bits = ~0ull;
+        for(int p=0; p<=MAX_PARTITION_ORDER; p++)
+        {
+            int size = n >> p;
+            if(((n & ((1 << p) - 1)) != 0) || (size <= order)) break;
+            Rice r; r.partition_order = p; r.bits = 2 + 4; // Coding method, partition order
+            for(int part=0; part<(1 << p); part++)
+            {
+                int start = (part == 0) ? order : part*size;
+                r.bits += rice_bits(u + start, (part+1)*size - start, &r.k[part]);
+            }
+            if(r.bits < best->bits) *best = r;
+        }
+    }
+    void put_utf8(Bits* b, Uint32 v)
+    { // Frame number, coded like UTF-8 (up to 31 bits)
+        if(v < 0x80) { put(b, v, 8); return; }
+        int extra = (v < 0x800) ? 1 : (v < 0x10000) ? 2 : (v < 0x200000) ? 3 : (v < 0x4000000) ? 4 : 5;
+        put(b, ((0xFF00u >> (extra+1)) & 0xFF) | (v >> (6*extra)), 8);
+        for(int i=extra-1; i>=0; i--) put(b, 0x80 | ((v >> (6*i)) & 0x3F), 8);
+    }
+    size_t frame(Uint8* out, const Sint16* x, int n, Uint32 frame_number, int sample_rate)
+    { // One frame of n samples (1 <= n <= MAX_BLOCK) into out (max_frame_bytes(n)). Return its bytes.
+        Bits b{out, 0, 0, 0};
+        { // Frame header
+            put(&b, 0x3FFE, 14); put(&b, 0, 1);         // Sync, reserved
+            put(&b, 0, 1);                              // Fixed block size
+            put(&b, (n == 4096) ? 12 : 7, 4);           // 4096, or 16-bit size at the end of the header
+            put(&b, (sample_rate == 44100) ? 9 : (sample_rate == 48000) ? 10 : 0, 4); // 0 : see STREAMINFO
+            put(&b, 0, 4);                              // Mono
+            put(&b, 4, 3); put(&b, 0, 1);               // 16 bits per sample, reserved
+            put_utf8(&b, frame_number);
+            if(n != 4096) put(&b, static_cast<Uint32>(n-1), 16);
+            put(&b, crc8(out, b.len), 8);
+        }
+        bool constant = true;
+        for(int i=1; i<n; i++) constant = constant && (x[i] == x[0]);
+        if(constant)
+        { // Silence : one value
+            put(&b, 0, 8);                              // Pad, CONSTANT, no wasted bits
+            put(&b, static_cast<Uint16>(x[0]), 16);
+        }
+        else
+        {
+            Sint32 r[MAX_BLOCK]; Uint32 u[MAX_BLOCK];
+            int best_order = -1; Rice best; best.bits = ~0ull;
+            for(int order=0; (order<=4) && (order<n); order++)
+            {
+                residual(x, n, order, r);
+                for(int i=order; i<n; i++) u[i] = zigzag(r[i]);
+                Rice rice; plan_rice(u, n, order, &rice);
+                if(rice.bits + 16ull*order < best.bits + 16ull*(best_order < 0 ? 0 : best_order))
+                {
+                    best = rice; best_order = order;
+                }
+            }
+            if((best_order < 0) || (best.bits + 16ull*best_order >= 16ull*n))
+            { // Noise-like : store samples
+                put(&b, 0x02, 8);                       // Pad, VERBATIM, no wasted bits
+                for(int i=0; i<n; i++) put(&b, static_cast<Uint16>(x[i]), 16);
+            }
+            else
+            {
+                put(&b, (0x08 | best_order) << 1, 8);   // Pad, FIXED order, no wasted bits
+                for(int i=0; i<best_order; i++) put(&b, static_cast<Uint16>(x[i]), 16);   // Warm-up
+                residual(x, n, best_order, r);
+                put(&b, 0, 2); put(&b, static_cast<Uint32>(best.partition_order), 4);   // Rice, 4-bit parameters
+                int size = n >> best.partition_order;
+                for(int part=0; part<(1 << best.partition_order); part++)
+                {
+                    int k = best.k[part];
+                    put(&b, static_cast<Uint32>(k), 4);
+                    for(int i=(part == 0) ? best_order : part*size; i<(part+1)*size; i++)
+                    {
+                        Uint32 v = zigzag(r[i]);
+                        for(Uint32 q = v >> k; q; ) { Uint32 z = (q > 32) ? 32 : q; put(&b, 0, static_cast<int>(z)); q -= z; }
+                        put(&b, 1, 1);                  // End of unary quotient
+                        if(k) put(&b, v, k);
+                    }
+                }
+            }
+        }
+        align(&b);
+        Uint16 crc = crc16(out, b.len);
+        put(&b, crc, 16);
+        return b.len;
+    }
+}
+
+#endif // __MG_FLAC_H__
@@ -0,0 +1,169 @@
+#ifndef __MG_GLYPH_ATLAS_H__
+#define __MG_GLYPH_ATLAS_H__
+
+namespace GlyphAtlas
+{ // Rasterize a font once, then draw text as quads (include SDL.h and SDL_ttf.h first)
+    /* *************DOC***************
+     * TTF_RenderText_* rasterizes the whole string and I upload it as a new texture.
+     * Doing that every frame is slow.
+     *
+     * Instead:
+     *  - At startup, GlyphAtlas::build() renders every printable ASCII glyph once
+     *    (white) into one texture, the atlas.
+     *  - GlyphAtlas::layout() turns a string into a list of quads (two triangles per
+     *    glyph) that sample the atlas. Vertex color tints the white glyphs.
+     *    x,y is the top-left of the text.
+     *  - GlyphAtlas::draw() sends all quads in one SDL_RenderGeometry call.
+     *
+     * Text caches its quads. layout() only redoes the work if the string, position,
+     * wrap width or color changed. Only the first MAX_CHARS-1 characters are laid
+     * out, so they are all the cache compares.
+     *
+     *      GlyphAtlas::Atlas atlas;
+     *      GlyphAtlas::build(&atlas, ren, ttf);
+     *      GlyphAtlas::Text text;
+     *      ...every frame...
+     *      GlyphAtlas::layout(&text, &atlas, "hello", x, y, wrap_w, Colors::snow);
+     *      GlyphAtlas::draw(ren, &atlas, &text);
+     * *******************************/
+    constexpr int FIRST = ' ';                          // First glyph in atlas
+    constexpr int LAST = '~';                           // Last glyph in atlas
+    constexpr int COUNT = LAST - FIRST + 1;
+    constexpr int MAX_CHARS = 1024;                     // Max glyphs in one Text
+
+    struct Glyph
+    {
+        SDL_Rect src;                                   // Glyph cell in atlas
+        int advance;                                    // Pen advance in pixels
+    };
+    struct Atlas
+    {
+        SDL_Texture* tex{};
+        int w{}, h{};                                   // Atlas texture size
+        int line_skip{};                                // Pixels from line to line
+        Glyph glyph[COUNT]{};
+    };
+    struct Text
+    { // Cached layout of one string
+        char str[MAX_CHARS]{};
+        int len{};                                      // Characters in str
+        int x{}, y{};                                   // Top-left of text
+        int wrap_w{-1};                                 // -1 : nothing laid out yet
+        SDL_Color color{};
+        int num_quads{};
+        int w{}, h{};                                   // Size of laid out text
+        SDL_Vertex verts[4*MAX_CHARS];
+        int indices[6*MAX_CHARS];
+    };
+
+    bool build(Atlas* a, SDL_Renderer* ren, TTF_Font* ttf)
+    { // Render all glyphs into one texture. Return false on SDL error.
+        constexpr int COLS = 16;                        // Glyph cells per atlas row
+        constexpr int ROWS = (COUNT+COLS-1)/COLS;
+        int cell_w = 0;
+        int cell_h = TTF_FontHeight(ttf);
+        for(int i=0; i<COUNT; i++)
+        { // Cell size is the widest glyph
+            int advance;
+            if(TTF_GlyphMetrics(ttf, FIRST+i, NULL, NULL, NULL, NULL, &advance) < 0) return false;
+            a->glyph[i].advance = advance;
+            if(advance > cell_w) cell_w = advance;
+        }
+        a->line_skip = TTF_FontLineSkip(ttf);
+        a->w = COLS*cell_w;
+        a->h = ROWS*cell_h;
+        SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, a->w, a->h, 32, SDL_PIXELFORMAT_RGBA32);
+        if(atlas == NULL) return false;
+        SDL_FillRect(atlas, NULL, 0);                   // Transparent
+        for(int i=0; i<COUNT; i++)
+        { // Copy each glyph into its cell
+            SDL_Rect* dst = &a->glyph[i].src;
+            *dst = SDL_Rect{(i%COLS)*cell_w, (i/COLS)*cell_h, cell_w, cell_h};
+            SDL_Surface* g = TTF_RenderGlyph_Blended(ttf, FIRST+i, SDL_Color{255,255,255,255});
+            if(g == NULL) continue;                     // No glyph : leave cell empty
+            SDL_SetSurfaceBlendMode(g, SDL_BLENDMODE_NONE); // Copy alpha as-is
+            SDL_Rect cell = *dst;                       // SDL_BlitSurface clips dst rect
+            SDL_BlitSurface(g, NULL, atlas, &cell);
+            dst->w = (g->w < cell_w) ? g->w : cell_w;
+            dst->h = (g->h < cell_h) ? g->h : cell_h;
+            SDL_FreeSurface(g);
+        }
+        a->tex = SDL_CreateTextureFromSurface(ren, atlas);
+        SDL_FreeSurface(atlas);
+        if(a->tex == NULL) return false;
+        SDL_SetTextureBlendMode(a->tex, SDL_BLENDMODE_BLEND);
+        return true;
+    }
+    void destroy(Atlas* a)
+    {
+        if(a->tex) SDL_DestroyTexture(a->tex);
+        a->tex = NULL;
+    }
+
+    int word_w(const Atlas* a, const char* c)
+    { // Pixel width of the word starting at c
+        int w = 0;
+        for(; *c && (*c != ' ') && (*c != '\n'); c++)
+        {
+            if((*c >= FIRST) && (*c <= LAST)) w += a->glyph[*c-FIRST].advance;
+        }
+        return w;
+    }
+    bool layout(Text* t, const Atlas* a, const char* str, int x0, int y0, int wrap_w, SDL_Color color)
+    { // Build quads for str at x0,y0, wrap at wrap_w pixels. Return false if cache was good.
+        int len = 0;
+        while((len < MAX_CHARS-1) && str[len]) len++;  // Longer : the rest is not laid out
+        if(  (t->wrap_w == wrap_w) && (t->x == x0) && (t->y == y0)
+          && (t->color.r == color.r) && (t->color.g == color.g)
+          && (t->color.b == color.b) && (t->color.a == color.a)
+          && (t->len == len) && (memcmp(t->str, str, len) == 0)
+          ) return false;
+        memcpy(t->str, str, len); t->str[len] = '\0';
+        t->len = len;
+        t->x = x0; t->y = y0;
+        t->wrap_w = wrap_w;
+        t->color = color;
+        t->num_quads = 0;
+        t->w = 0;
+        const float tw = static_cast<float>(a->w);
+        const float th = static_cast<float>(a->h);
+        int x = 0; int y = 0;
+        for(const char* c = t->str; *c; c++)
+        {
+            if(*c == '\n') { x = 0; y += a->line_skip; continue; }
+            if((*c < FIRST) || (*c > LAST)) continue;   // Skip what atlas does not have
+            if((c == t->str) || (c[-1] == ' '))
+            { // Start of a word : wrap if the whole word does not fit
+                if((x > 0) && (x + word_w(a, c) > wrap_w)) { x = 0; y += a->line_skip; }
+            }
+            const Glyph* g = &a->glyph[*c-FIRST];
+            if(*c != ' ')
+            { // Two triangles per glyph
+                int q = t->num_quads++;
+                float l = static_cast<float>(x0+x);     float top = static_cast<float>(y0+y);
+                float r = l + g->src.w;                 float bot = top + g->src.h;
+                float u0 = g->src.x/tw;                 float v0 = g->src.y/th;
+                float u1 = (g->src.x+g->src.w)/tw;      float v1 = (g->src.y+g->src.h)/th;
+                SDL_Vertex* v = &t->verts[4*q];
+                v[0] = SDL_Vertex{{l,top}, color, {u0,v0}};
+                v[1] = SDL_Vertex{{r,top}, color, {u1,v0}};
+                v[2] = SDL_Vertex{{r,bot}, color, {u1,v1}};
+                v[3] = SDL_Vertex{{l,bot}, color, {u0,v1}};
+                int* i = &t->indices[6*q];
+                i[0] = 4*q+0; i[1] = 4*q+1; i[2] = 4*q+2;
+                i[3] = 4*q+0; i[4] = 4*q+2; i[5] = 4*q+3;
+            }
+            x += g->advance;
+            if(x > t->w) t->w = x;
+        }
+        t->h = y + a->line_skip;
+        return true;
+    }
+    void draw(SDL_Renderer* ren, const Atlas* a, const Text* t)
+    { // Draw all glyphs in one call
+        if(t->num_quads == 0) return;
+        SDL_RenderGeometry(ren, a->tex, t->verts, 4*t->num_quads, t->indices, 6*t->num_quads);
+    }
+}
+
+#endif // __MG_GLYPH_ATLAS_H__
@@ -0,0 +1,61 @@
+#ifndef __MG_GTOW_H__
+#define __MG_GTOW_H__
+
+namespace GtoW
+{ // Coordinate transform from GameArt coordinates to Window coordinates (include SDL.h first)
+    /* *************DOC***************
+     * W = (k*G) + Offset
+     * G = (W - Offset)/k
+     * Offset = W - (k*G)
+     *
+     * k is GtoW::scale, a whole number so game art pixels stay square.
+     * fit() picks k and Offset whenever the window size changes.
+    *******************************/
+    namespace Offset
+    {
+        int x=0;
+        int y=0;
+    }
+    int scale = 1;
+    void fit(int game_w, int game_h, int win_w, int win_h)
+    { // Largest scale that fits game in window, centered
+        { // Resize game art to fit window
+            /* *************Resize***************
+             * Use largest pixel size for GameArt to fit in Window.
+             * If window is smaller than GameArt, use GameArt w x h and let it clip.
+             * *******************************/
+            if((win_w<game_w)||(win_h<game_h)) scale = 1;
+            else
+            {
+                int ratio_w = win_w/game_w;
+                int ratio_h = win_h/game_h;
+                // Use the smaller of the two ratios as the scaling factor
+                scale = (ratio_w > ratio_h) ? ratio_h : ratio_w;
+            }
+        }
+        { // Recenter game art in window
+            /* *************Recenter***************
+             * If window is bigger, recenter game art.
+             * If window is smaller, pin game art topleft to window topleft.
+             * *******************************/
+            int w = scale*game_w; int h = scale*game_h;
+            if(win_w>w) Offset::x = (win_w-w)/2;
+            else Offset::x = 0;
+            if(win_h>h) Offset::y = (win_h-h)/2;
+            else Offset::y = 0;
+        }
+    }
+    float to_win_x(float game_x) { return scale*game_x + Offset::x; }
+    float to_win_y(float game_y) { return scale*game_y + Offset::y; }
+    void to_game(Sint32 win_x, Sint32 win_y, int game_w, int game_h, float* xf, float* yf)
+    { // Window to GameArt coordinates, clamped to game art
+        *xf = (win_x - Offset::x)/static_cast<float>(scale);
+        *yf = (win_y - Offset::y)/static_cast<float>(scale);
+        if(*xf < 0) *xf = 0;
+        if(*yf < 0) *yf = 0;
+        if(*xf > game_w) *xf = static_cast<float>(game_w);
+        if(*yf > game_h) *yf = static_cast<float>(game_h);
+    }
+}
+
+#endif // __MG_GTOW_H__
@@ -0,0 +1,85 @@
+#include <cstdio>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_gtow.h"
+
+void run_tests_for_mg_gtow()
+{
+    struct Size { int w, h; };
+    const Size games[] = {{320,180}, {16,9}};           // GameArt size, smallest 16:9
+    for(Size g : games)
+    {
+        { // Window bigger than game : biggest whole scale that fits, centered
+            bool ok = true;
+            for(int k=1; (k<=8) && ok; k++)
+            {
+                const Size extras[] = {{0,0}, {1,1}, {7,0}, {0,7}, {g.w-1,g.h-1}};
+                for(Size e : extras)
+                {
+                    int win_w = k*g.w + e.w; int win_h = k*g.h + e.h;
+                    GtoW::fit(g.w, g.h, win_w, win_h);
+                    if((GtoW::scale != k) || (GtoW::Offset::x != e.w/2) || (GtoW::Offset::y != e.h/2))
+                    {
+                        ok = false;
+                        Tests::note("game %dx%d window %dx%d : scale %d offset %d,%d",
+                                g.w, g.h, win_w, win_h, GtoW::scale, GtoW::Offset::x, GtoW::Offset::y);
+                        break;
+                    }
+                }
+            }
+            TEST(ok);
+        }
+        { // Window smaller than game : scale 1, pinned top-left on the side that is too small
+            GtoW::fit(g.w, g.h, g.w-1, g.h-1);
+            TESTeq(GtoW::scale, 1); TESTeq(GtoW::Offset::x, 0); TESTeq(GtoW::Offset::y, 0);
+            GtoW::fit(g.w, g.h, g.w-1, 2*g.h);
+            TESTeq(GtoW::scale, 1); TESTeq(GtoW::Offset::x, 0); TESTeq(GtoW::Offset::y, g.h/2);
+        }
+        { // Every game pixel goes to the window and back, at every scale
+            bool ok = true;
+            for(int k=1; (k<=8) && ok; k++)
+            {
+                GtoW::fit(g.w, g.h, k*g.w + 5, k*g.h + 3);
+                for(int y=0; (y<=g.h) && ok; y++)
+                    for(int x=0; (x<=g.w) && ok; x++)
+                    {
+                        float wx = GtoW::to_win_x(static_cast<float>(x));
+                        float wy = GtoW::to_win_y(static_cast<float>(y));
+                        float gx, gy;
+                        GtoW::to_game(static_cast<Sint32>(wx), static_cast<Sint32>(wy), g.w, g.h, &gx, &gy);
+                        if((gx != x) || (gy != y))
+                        {
+                            ok = false;
+                            Tests::note("scale %d : game %d,%d -> window %g,%g -> game %g,%g", k, x, y, wx, wy, gx, gy);
+                        }
+                    }
+            }
+            TEST(ok);
+        }
+        { // Every window pixel lands in the game pixel it covers, or clamps to the edge
+            bool ok = true;
+            for(int k=1; (k<=8) && ok; k++)
+            {
+                int win_w = k*g.w + 5; int win_h = k*g.h + 3;
+                GtoW::fit(g.w, g.h, win_w, win_h);
+                for(int wy=0; (wy<win_h) && ok; wy++)
+                    for(int wx=0; (wx<win_w) && ok; wx++)
+                    {
+                        float gx, gy;
+                        GtoW::to_game(wx, wy, g.w, g.h, &gx, &gy);
+                        int dx = wx - GtoW::Offset::x; int dy = wy - GtoW::Offset::y;
+                        // Pixel covered (floor division), clamped like to_game()
+                        int px = (dx < 0) ? 0 : ((dx/k > g.w) ? g.w : dx/k);
+                        int py = (dy < 0) ? 0 : ((dy/k > g.h) ? g.h : dy/k);
+                        if(  (static_cast<int>(gx) != px) || (static_cast<int>(gy) != py)
+                          || (gx < 0) || (gy < 0) || (gx > g.w) || (gy > g.h))
+                        {
+                            ok = false;
+                            Tests::note("scale %d : window %d,%d -> game %g,%g, want pixel %d,%d", k, wx, wy, gx, gy, px, py);
+                        }
+                    }
+            }
+            TEST(ok);
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef __MG_HOT_H__
+#define __MG_HOT_H__
+
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+#include <sys/stat.h>
+
+namespace Hot
+{ // Watch a shared library, load each new build of it while the program runs (include SDL.h first)
+    /* *************DOC***************
+     * UI thread, once per frame:
+     *
+     *      Hot::Library lib;
+     *      Hot::watch(&lib, "build/libfoo.so");            // At startup
+     *      ...
+     *      if(Hot::changed(&lib, SDL_GetTicks()))
+     *      {
+     *          void* h = Hot::open(&lib);                  // NULL : see lib.error
+     *          Api* api = (Api*)Hot::symbol(h, "foo_api");
+     *          if(!api ...bad...) Hot::close(h);
+     *          else { ...point callers at api... Hot::swap(&lib, h); }
+     *      }
+     *      if(lib.old && ...nobody runs old code...) Hot::release_old(&lib);
+     *
+     * The file present at watch() is not loaded : it may be older than the
+     * program. Only builds written after that count as changed, and only once the
+     * file has stopped changing for SETTLE_MS (the linker is done).
+     *
+     * open() loads a copy of the file : dlopen() returns the library it already
+     * has for a path it has seen, and the build must be free to overwrite the
+     * file while the copy is in use. The copy is deleted once loaded (the
+     * mapping stays valid).
+     *
+     * Code in the old library may still be running (another thread, a function
+     * pointer in a table). swap() keeps it loaded as lib.old until the caller
+     * knows it is unused and calls release_old(). Until then changed() waits.
+     *
+     * Linux/BSD (dlopen). Globals are shared with the program only if it exports
+     * them (link with -rdynamic) and the library binds its own functions
+     * (-Wl,-Bsymbolic-functions), see `make synth`.
+     * *******************************/
+    constexpr int PATH_LEN = 256;
+    constexpr Uint32 SETTLE_MS = 100;
+    struct Library
+    {
+        char path[PATH_LEN]{};                          // File the build writes
+        time_t mtime{}; off_t size{}; ino_t inode{};    // Last seen (0 : missing)
+        Uint32 changed_at{};                            // Ticks when the file last changed
+        bool dirty{};                                   // Changed since last open()
+        int generation{};                               // Copies opened so far
+        void* live{};                                   // Newest library swapped in
+        void* old{};                                    // Previous one, until release_old()
+        char error[PATH_LEN+32]{};                      // Why the last open() failed
+    };
+    void stat_file(Library* lib)
+    { // inode : a build renamed into place is a new file, even in the same second at the same size
+        struct stat st;
+        if(stat(lib->path, &st) == 0) { lib->mtime = st.st_mtime; lib->size = st.st_size; lib->inode = st.st_ino; }
+        else { lib->mtime = 0; lib->size = 0; lib->inode = 0; }
+    }
+    void watch(Library* lib, const char* path)
+    {
+        *lib = Library{};
+        snprintf(lib->path, PATH_LEN, "%s", path);
+        stat_file(lib);
+    }
+    bool changed(Library* lib, Uint32 now)
+    { // True once the file has a new build that is done being written, and lib.old is released
+        time_t mtime = lib->mtime; off_t size = lib->size; ino_t inode = lib->inode;
+        stat_file(lib);
+        if((mtime != lib->mtime) || (size != lib->size) || (inode != lib->inode))
+        {
+            lib->changed_at = now;
+            lib->dirty = (lib->size > 0);
+        }
+        return lib->dirty && (lib->old == NULL) && (now - lib->changed_at >= SETTLE_MS);
+    }
+    void* open(Library* lib)
+    { // Load a copy of the file. NULL (reason in lib.error) if it is not a library.
+        lib->dirty = false;                             // Try each build once
+        char copy[PATH_LEN+16];
+        snprintf(copy, sizeof(copy), "%s.%d", lib->path, ++lib->generation);
+        bool copied = false;
+        if(FILE* in = fopen(lib->path, "rb"))
+        {
+            if(FILE* out = fopen(copy, "wb"))
+            {
+                char buf[1<<16]; size_t n; copied = true;
+                while((n = fread(buf, 1, sizeof(buf), in)) > 0) copied = copied && (fwrite(buf, 1, n, out) == n);
+                copied = (fclose(out) == 0) && copied;
+            }
+            fclose(in);
+        }
+        if(!copied)
+        {
+            snprintf(lib->error, sizeof(lib->error), "cannot copy %s", lib->path);
+            remove(copy);
+            return NULL;
+        }
+        void* h = dlopen(copy, RTLD_NOW | RTLD_LOCAL);
+        if(h == NULL) snprintf(lib->error, sizeof(lib->error), "%s", dlerror());
+        remove(copy);
+        return h;
+    }
+    void* symbol(void* h, const char* name) { return h ? dlsym(h, name) : NULL; }
+    void close(void* h) { if(h) dlclose(h); }
+    void swap(Library* lib, void* h)
+    { // h is in use now. The previous library stays loaded until release_old().
+        lib->old = lib->live;
+        lib->live = h;
+    }
+    void release_old(Library* lib) { close(lib->old); lib->old = NULL; }
+    void unload(Library* lib)
+    { // Shutdown : nothing runs code from either library any more
+        release_old(lib);
+        close(lib->live); lib->live = NULL;
+    }
+}
+
+#endif // __MG_HOT_H__
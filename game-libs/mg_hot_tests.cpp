@@ -0,0 +1,50 @@
+#include <cstdio>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_hot.h"
+
+namespace HotTests
+{
+    const char* PATH = "mg_hot_tests.so";               // Not a library : removed when done
+    bool write(const char* text)
+    { // New file renamed into place, like `make synth`
+        FILE* f = fopen("mg_hot_tests.tmp", "w");
+        if(f == NULL) return false;
+        fputs(text, f);
+        return (fclose(f) == 0) && (rename("mg_hot_tests.tmp", PATH) == 0);
+    }
+}
+
+void run_tests_for_mg_hot()
+{
+    using namespace HotTests;
+    Hot::Library lib;
+    TEST(write("old build"));
+    Hot::watch(&lib, PATH);
+    TEST(!Hot::changed(&lib, 0));                       // File at startup is not a change
+    { // New build : changed once it settles
+        TEST(write("new build"));                       // Same size, same second : new inode
+        TEST(!Hot::changed(&lib, 1000));
+        TEST(!Hot::changed(&lib, 1000 + Hot::SETTLE_MS-1));
+        TEST(Hot::changed(&lib, 1000 + Hot::SETTLE_MS));
+    }
+    { // Not a library : open() fails with a reason, and that build is not tried again
+        void* h = Hot::open(&lib);
+        TEST(h == NULL);
+        TEST(lib.error[0] != '\0');
+        TEST(!Hot::changed(&lib, 2000));
+        TEST(Hot::symbol(h, "anything") == NULL);
+    }
+    { // Old library still in use : the next build waits for release_old()
+        TEST(write("next build"));
+        lib.old = &lib;                                 // Stand-in, never closed
+        TEST(!Hot::changed(&lib, 3000));
+        TEST(!Hot::changed(&lib, 3000 + Hot::SETTLE_MS));
+        lib.old = NULL;
+        TEST(Hot::changed(&lib, 3000 + Hot::SETTLE_MS));
+    }
+    { // File removed : not a change to load
+        remove(PATH);
+        TEST(!Hot::changed(&lib, 4000 + Hot::SETTLE_MS));
+    }
+}
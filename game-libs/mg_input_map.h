@@ -0,0 +1,153 @@
+#ifndef __MG_INPUT_MAP_H__
+#define __MG_INPUT_MAP_H__
+
+#include <cstdio>
+#include <cstring>
+
+namespace InputMap
+{ // Keys -> actions -> handlers, bindings from a table (include SDL.h first)
+    /* *************DOC***************
+     * Three tables instead of one switch case and one flag per key:
+     *
+     *      keycode --action[shift][slot]--> action id --handler[id]--> function
+     *
+     * A keycode becomes a table slot with no search:
+     *  - ASCII keycodes (SDLK_a, SDLK_1, SDLK_SPACE, ...) are slots 0 : 127
+     *  - every other keycode is SDLK_SCANCODE_MASK | scancode -> slot 128 + scancode
+     *
+     * key_down() only queues the action. dispatch() calls each queued handler once,
+     * in the order the actions were first queued, then clears the queue. So mashing a
+     * key five times between dispatches runs its handler once.
+     *
+     * Bindings with Shift go in their own layer. If Shift is held and the key has no
+     * Shift binding, the plain binding is used.
+     *
+     *      InputMap::Map keys;
+     *      InputMap::define(&keys, QUIT, "quit", on_quit);
+     *      InputMap::bind(&keys, SDLK_q, false, QUIT);
+     *      InputMap::load(&keys, "data/keys.cfg");     // Optional : rebind from file
+     *      ...on SDL_KEYDOWN...
+     *      InputMap::key_down(&keys, e.key.keysym.sym, e.key.keysym.mod);
+     *      ...once per update...
+     *      InputMap::dispatch(&keys);
+     *
+     * Config file, one binding per line, # starts a comment:
+     *
+     *      quit = Q
+     *      voice_down = Shift+Space
+     *
+     * Key names are SDL key names (see SDL_GetKeyName).
+     * *******************************/
+    constexpr int NONE = 0;                             // Action id 0 : key not bound
+    constexpr int MAX_ACTIONS = 256;                    // Action ids are Uint8
+    constexpr int NUM_SLOTS = 128 + SDL_NUM_SCANCODES;
+    typedef void (*Handler)(int action);
+    struct Map
+    {
+        Uint8 action[2][NUM_SLOTS]{};                   // [shift][slot] -> action id
+        Handler handler[MAX_ACTIONS]{};                 // action id -> handler
+        const char* name[MAX_ACTIONS]{};                // action id -> name in config file
+        bool queued[MAX_ACTIONS]{};                     // Action is in queue
+        Uint8 queue[MAX_ACTIONS]{};                     // Actions to dispatch, oldest first
+        int num_queued{};
+    };
+
+    int slot(SDL_Keycode key)
+    { // Table slot for key, -1 if key cannot be bound
+        if((key >= 0) && (key < 128)) return key;
+        if(!(key & SDLK_SCANCODE_MASK)) return -1;      // Non-ASCII character key
+        int scancode = key & ~SDLK_SCANCODE_MASK;
+        if(scancode >= SDL_NUM_SCANCODES) return -1;
+        return 128 + scancode;
+    }
+    void define(Map* m, int action, const char* name, Handler h)
+    { // Give action a handler and a name for the config file
+        SDL_assert((action > NONE) && (action < MAX_ACTIONS));
+        m->handler[action] = h;
+        m->name[action] = name;
+    }
+    bool bind(Map* m, SDL_Keycode key, bool shift, int action)
+    { // key (with Shift if shift) does action. Bind to NONE to unbind. False if bad key.
+        int s = slot(key);
+        if(s < 0) return false;
+        m->action[shift ? 1 : 0][s] = static_cast<Uint8>(action);
+        return true;
+    }
+    int lookup(const Map* m, SDL_Keycode key, Uint16 mod)
+    { // Action for key with modifiers mod, NONE if not bound
+        int s = slot(key);
+        if(s < 0) return NONE;
+        if(mod & KMOD_SHIFT)
+        {
+            int a = m->action[1][s];
+            if(a != NONE) return a;
+        }
+        return m->action[0][s];
+    }
+    bool key_down(Map* m, SDL_Keycode key, Uint16 mod)
+    { // Queue the action for key. False if key is not bound.
+        int a = lookup(m, key, mod);
+        if(a == NONE) return false;
+        if(!m->queued[a])
+        { // Repeats before the next dispatch collapse into one
+            m->queued[a] = true;
+            m->queue[m->num_queued++] = static_cast<Uint8>(a);
+        }
+        return true;
+    }
+    void dispatch(Map* m)
+    { // Run each queued action's handler once, then clear the queue
+        for(int i=0; i<m->num_queued; i++)
+        {
+            int a = m->queue[i];
+            m->queued[a] = false;
+            if(m->handler[a]) m->handler[a](a);
+        }
+        m->num_queued = 0;
+    }
+
+    ////////////////
+    // CONFIG FILE
+    ////////////////
+    int find(const Map* m, const char* name)
+    { // Action id with this name, NONE if no action has it
+        if(strcmp(name, "none") == 0) return NONE;
+        for(int a=1; a<MAX_ACTIONS; a++) if(m->name[a] && (strcmp(m->name[a], name) == 0)) return a;
+        return -1;
+    }
+    char* trim(char* s)
+    { // Skip leading whitespace, cut trailing whitespace
+        while((*s == ' ') || (*s == '\t')) s++;
+        char* end = s + strlen(s);
+        while((end > s) && ((end[-1] == ' ') || (end[-1] == '\t') || (end[-1] == '\n') || (end[-1] == '\r'))) end--;
+        *end = '\0';
+        return s;
+    }
+    int load(Map* m, const char* path)
+    { // Apply bindings in file at path. Return bindings applied, -1 if no file.
+        FILE* f = fopen(path, "r");
+        if(f == NULL) return -1;
+        int applied = 0;
+        char line[128];
+        for(int n=1; fgets(line, sizeof(line), f); n++)
+        {
+            char* hash = strchr(line, '#'); if(hash) *hash = '\0';
+            char* eq = strchr(line, '=');
+            if(eq == NULL) { if(*trim(line)) printf("%s:%d : expected \"action = key\"\n", path, n); continue; }
+            *eq = '\0';
+            char* name = trim(line); char* key_name = trim(eq+1);
+            bool shift = false;
+            if(strncmp(key_name, "Shift+", 6) == 0) { shift = true; key_name += 6; }
+            int a = find(m, name);
+            SDL_Keycode key = SDL_GetKeyFromName(key_name);
+            if(a < 0)                 { printf("%s:%d : unknown action \"%s\"\n", path, n, name); continue; }
+            if(key == SDLK_UNKNOWN)   { printf("%s:%d : unknown key \"%s\"\n", path, n, key_name); continue; }
+            if(!bind(m, key, shift, a)) { printf("%s:%d : cannot bind key \"%s\"\n", path, n, key_name); continue; }
+            applied++;
+        }
+        fclose(f);
+        return applied;
+    }
+}
+
+#endif // __MG_INPUT_MAP_H__
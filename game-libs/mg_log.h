@@ -0,0 +1,161 @@
+#ifndef __MG_LOG_H__
+#define __MG_LOG_H__
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+
+/* *************Build flags***************
+ * MG_LOG_LEVEL      : lowest level that is compiled in (Log::Level, default INFO)
+ * MG_LOG_CATEGORIES : bitmask of categories compiled in (Log::Category, default all)
+ *
+ *      make LOG_LEVEL=0                # Everything (TRACE and up)
+ *      make LOG_LEVEL=0 LOG_CATEGORIES=4   # Everything from AUDIO only
+ * *******************************/
+#ifndef MG_LOG_LEVEL
+#define MG_LOG_LEVEL 2
+#endif
+#ifndef MG_LOG_CATEGORIES
+#define MG_LOG_CATEGORIES 0xF
+#endif
+
+namespace Log
+{ // Levelled, category-filtered logging that never blocks the caller (include SDL.h first)
+    /* *************DOC***************
+     * LOG(level, category, fmt, ...) is printf to stdout, except:
+     *  - a level/category that is not compiled in is an empty statement : the
+     *    arguments are not even evaluated
+     *  - otherwise the caller formats into a slot in a ring and returns : no stdout,
+     *    no lock, no syscall, safe in the audio callback
+     *  - a drain thread (started by Log::start()) prints the ring and flushes stdout
+     *
+     *      LOG(DEBUG, AUDIO, "Audio device buffer size is %d bytes", size);
+     *      LOG(TRACE, UI, "Mouse x,y : %.3f,%.3f", x, y);
+     *
+     * Lines print in the order they were logged. If the ring is full the line is
+     * dropped and counted; the drain thread reports how many.
+     *
+     * The ring takes any number of writers (UI thread, audio thread) and one reader.
+     * Each slot has a sequence number that says whose turn it is:
+     *      seq == pos       : slot is free for the writer that claimed pos
+     *      seq == pos + 1   : slot has a message for the reader at pos
+     *
+     * Slot k stores seq - k, so an all-zero ring is the starting state (seq == k).
+     * The ring needs no constructor : it is ready before any code runs, and a
+     * library that includes this header (see SynthModule) cannot reset it.
+     * *******************************/
+    enum Level { TRACE, DEBUG, INFO, WARN, ERROR, OFF };
+    enum Category { APP = 1<<0, UI = 1<<1, AUDIO = 1<<2, RENDER = 1<<3 };
+    constexpr bool enabled(Level level, Category category)
+    { // Compile-time filter
+        return (level >= MG_LOG_LEVEL) && (level < OFF) && (category & MG_LOG_CATEGORIES);
+    }
+
+    constexpr Uint32 SIZE = 1<<10;                      // Messages in ring
+    constexpr Uint32 MASK = SIZE-1;
+    constexpr int MSG_LEN = 120;                        // Longer messages are cut off
+    struct Slot
+    {
+        std::atomic<Uint32> seq;                        // Minus slot index, see DOC
+        Uint8 level, category;
+        char msg[MSG_LEN];
+    };
+    struct Ring
+    {
+        Slot slot[SIZE]{};
+        std::atomic<Uint32> head{0};                    // Next position to write (writers)
+        Uint32 tail{};                                  // Next position to read (drain thread)
+        std::atomic<Uint32> dropped{0};
+    };
+    Ring ring;
+    SDL_Thread* thread{};
+    std::atomic<bool> stop{false};
+
+    __attribute__((format(printf, 3, 4)))
+    void write(Level level, Category category, const char* fmt, ...)
+    { // Format into the ring. Use LOG() instead.
+        Uint32 pos = ring.head.load(std::memory_order_relaxed);
+        Slot* s;
+        for(;;)
+        { // Claim a free slot
+            s = &ring.slot[pos&MASK];
+            Uint32 seq = s->seq.load(std::memory_order_acquire) + (pos&MASK);
+            if(seq == pos)
+            {
+                if(ring.head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) break;
+            }
+            else if(static_cast<Sint32>(seq - pos) < 0)
+            { // Ring is full
+                ring.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else pos = ring.head.load(std::memory_order_relaxed);
+        }
+        s->level = static_cast<Uint8>(level); s->category = static_cast<Uint8>(category);
+        va_list args; va_start(args, fmt);
+        vsnprintf(s->msg, MSG_LEN, fmt, args);
+        va_end(args);
+        s->seq.store(pos+1 - (pos&MASK), std::memory_order_release);
+    }
+    const char* name(Uint8 category)
+    {
+        switch(category)
+        {
+            case APP:    return "app";
+            case UI:     return "ui";
+            case AUDIO:  return "audio";
+            case RENDER: return "render";
+            default:     return "?";
+        }
+    }
+    int drain(void)
+    { // Print every message in the ring. Return number printed.
+        int n = 0;
+        for(;;)
+        {
+            Uint32 k = ring.tail&MASK;
+            Slot* s = &ring.slot[k];
+            if(s->seq.load(std::memory_order_acquire) + k != ring.tail+1) break;
+            constexpr const char* LEVEL[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+            printf("%-5s %-6s| %s\n", LEVEL[s->level], name(s->category), s->msg);
+            s->seq.store(ring.tail+SIZE - k, std::memory_order_release);
+            ring.tail++; n++;
+        }
+        Uint32 dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+        if(dropped) printf("WARN  log   | %u messages dropped (ring full)\n", dropped);
+        if(n || dropped) fflush(stdout);
+        return n;
+    }
+    int SDLCALL drain_thread(void*)
+    {
+        while(!stop.load(std::memory_order_acquire))
+        {
+            drain();
+            SDL_Delay(5);
+        }
+        drain();
+        return 0;
+    }
+    void start(void)
+    { // Start the drain thread. Without it, call drain() yourself.
+        stop.store(false, std::memory_order_release);
+        thread = SDL_CreateThread(drain_thread, "log", NULL);
+    }
+    void finish(void)
+    { // Stop the drain thread and print whatever is left
+        if(thread)
+        {
+            stop.store(true, std::memory_order_release);
+            SDL_WaitThread(thread, NULL);
+            thread = NULL;
+        }
+        drain();
+    }
+}
+
+#define LOG(level, category, ...) do { \
+    if constexpr(Log::enabled(Log::level, Log::category)) \
+        Log::write(Log::level, Log::category, __VA_ARGS__); \
+} while(0)
+
+#endif // __MG_LOG_H__
@@ -0,0 +1,252 @@
+#ifndef __MG_MOD_H__
+#define __MG_MOD_H__
+
+#include <atomic>
+#include <cmath>
+
+namespace Mod
+{ // LFOs, envelopes and a modulation matrix at control rate, ramped to audio rate (include SDL.h first)
+    /* *************DOC***************
+     * Sources (LFOs, envelopes, external control signals) are evaluated once every
+     * Config::rate samples (a control tick). At each tick every destination is:
+     *
+     *      dest = base[dest] + sum of depth*source, over routes to dest
+     *
+     * clamped to [lo, hi]. Between ticks each destination ramps linearly from its
+     * last value to the new one, so the output is smooth at audio rate but the
+     * matrix costs one pass over the routes per tick, not per sample.
+     *
+     * UI thread : fill a Config and publish() it
+     *
+     *      Mod::Config c{};
+     *      c.rate = 32;
+     *      c.sources[0] = {Mod::LFO_SINE, 5};              // 5Hz
+     *      c.num_sources = 1;
+     *      c.dests[PITCH] = {0, 0, 1};                     // base 0, range 0:1
+     *      c.num_dests = NUM_DESTS;
+     *      Mod::route(&c, 0, PITCH, 0.01f);
+     *      Mod::publish(&matrix, &c);
+     *
+     * Audio thread : once per block
+     *
+     *      float out[NUM_DESTS][BLOCK];
+     *      Mod::run(&matrix, &out[0][0], BLOCK, frames);   // out[dest][i] for i < frames
+     *
+     * Configs are triple-buffered like Patch plans : run() takes the newest one at
+     * the start of its block, nobody waits. LFO phase and envelope stage live in
+     * the Matrix, not the Config, so a new Config does not restart them. fade and
+     * take_fade work like they do for Patch plans.
+     *
+     * EXTERNAL sources read a per-sample array the caller fills for the block
+     * (Source::ext), sampled at each tick. ENV is an attack-release envelope
+     * started by trigger() (any thread).
+     * *******************************/
+    constexpr int MAX_SOURCES = 16;
+    constexpr int MAX_DESTS = 8;
+    constexpr int MAX_ROUTES = 256;
+    enum Type { LFO_SINE, LFO_TRIANGLE, LFO_SAW, LFO_SQUARE, ENV, EXTERNAL };
+    struct Source
+    {
+        Type type;
+        float a;                                        // LFO : Hz. ENV : attack seconds.
+        float b;                                        // ENV : release seconds
+        const float* ext;                               // EXTERNAL : value at each sample of the block
+    };
+    struct Dest { float base, lo, hi; };
+    struct Route { int src, dest; float depth; };
+    struct Config
+    {
+        int rate;                                       // Samples per control tick
+        int sample_rate;
+        Source sources[MAX_SOURCES]; int num_sources;
+        Dest dests[MAX_DESTS]; int num_dests;
+        Route routes[MAX_ROUTES]; int num_routes;
+    };
+    bool route(Config* c, int src, int dest, float depth)
+    { // Add a route. False if the matrix is full or src/dest is bad.
+        if((c->num_routes == MAX_ROUTES) || (src < 0) || (src >= c->num_sources)
+            || (dest < 0) || (dest >= c->num_dests)) return false;
+        c->routes[c->num_routes++] = Route{src, dest, depth};
+        return true;
+    }
+
+    ////////////////
+    // MATRIX
+    ////////////////
+    enum Stage { IDLE, ATTACK, RELEASE };
+    struct Matrix
+    {
+        Config configs[3]{};                            // live, pending, and one for the UI to write
+        std::atomic<int> pending{-1};
+        std::atomic<int> live{-1};
+        std::atomic<Uint32> triggers[MAX_SOURCES]{};    // ENV : trigger() count
+        // Audio thread only
+        Uint32 seen[MAX_SOURCES]{};                     // ENV : triggers already started
+        Uint32 phase[MAX_SOURCES]{};                    // LFO : 2^32 is one period
+        float env[MAX_SOURCES]{};                       // ENV : level 0:1
+        Stage stage[MAX_SOURCES]{};
+        float value[MAX_SOURCES]{};                     // Source values at the last tick
+        float now[MAX_DESTS]{};                         // Dest values at the current sample
+        float step[MAX_DESTS]{};                        // Ramp per sample to the next tick
+        int countdown{};                                // Samples to the next tick
+    };
+    constexpr int SLOT_MASK = 0xFF;                     // pending : slot, plus FADE flag
+    constexpr int FADE = 1<<8;
+    bool check_source(int type, float a, float b, int rate, int sample_rate)
+    { // Type in range, rates finite and usable. NaN fails every compare.
+        if((type < LFO_SINE) || (type > EXTERNAL)) return false;
+        if(type == EXTERNAL) return true;               // a, b unused
+        if(type == ENV) return (a >= 0) && (b >= 0) && std::isfinite(a) && std::isfinite(b);
+        // LFO : phase step a*dt is converted to Uint32, so less than one cycle per tick
+        return (a >= 0) && (a < static_cast<float>(sample_rate)/static_cast<float>(rate));
+    }
+    bool check_dest(const Dest& d)
+    { // Finite, and lo <= hi (base may be outside : run() clamps it)
+        return std::isfinite(d.base) && std::isfinite(d.lo) && std::isfinite(d.hi) && (d.lo <= d.hi);
+    }
+    bool check(const Config* c)
+    { // Every count, type and route is in range, every rate and range usable
+        if((c->rate < 1) || (c->sample_rate < 1)
+            || (c->num_sources < 0) || (c->num_sources > MAX_SOURCES)
+            || (c->num_dests < 0) || (c->num_dests > MAX_DESTS)
+            || (c->num_routes < 0) || (c->num_routes > MAX_ROUTES)) return false;
+        for(int s=0; s<c->num_sources; s++)
+        {
+            const Source& src = c->sources[s];
+            if(!check_source(src.type, src.a, src.b, c->rate, c->sample_rate)) return false;
+        }
+        for(int d=0; d<c->num_dests; d++) if(!check_dest(c->dests[d])) return false;
+        for(int r=0; r<c->num_routes; r++)
+        {
+            const Route& route = c->routes[r];
+            if((route.src < 0) || (route.src >= c->num_sources) || (route.dest < 0) || (route.dest >= c->num_dests)
+                || !std::isfinite(route.depth))
+                return false;
+        }
+        return true;
+    }
+    bool publish(Matrix* m, const Config* c, bool fade=false)
+    { // UI thread : offer c to the audio thread. False if c is bad (see check).
+        if(!check(c)) return false;
+        // Read pending first : only the audio thread can change live, and only to pending
+        int pending = m->pending.load(std::memory_order_acquire);
+        int live = m->live.load(std::memory_order_acquire);
+        int pending_slot = (pending >= 0) ? (pending & SLOT_MASK) : -1;
+        int slot = 0;
+        while((slot == pending_slot) || (slot == live)) slot++;
+        m->configs[slot] = *c;
+        if((pending >= 0) && (pending & FADE)) fade = true; // Still fade to what it replaces
+        m->pending.store(slot | (fade ? FADE : 0), std::memory_order_release);
+        return true;
+    }
+    bool fade_pending(const Matrix* m)
+    { // A config published with fade=true is waiting
+        int p = m->pending.load(std::memory_order_acquire);
+        return (p >= 0) && (p & FADE);
+    }
+    void trigger(Matrix* m, int src)
+    { // Any thread : start ENV source src from 0
+        if((src >= 0) && (src < MAX_SOURCES)) m->triggers[src].fetch_add(1, std::memory_order_release);
+    }
+    float lfo(Type type, Uint32 phase)
+    { // -1 : 1
+        constexpr float TWO_PI = 6.28318530717958647692f;
+        float p = phase/4294967296.0f;                  // 0 : 1
+        switch(type)
+        {
+            case LFO_SINE:     return SDL_sinf(TWO_PI*p);
+            case LFO_TRIANGLE: return (p < 0.5f) ? 4*p-1 : 3-4*p;
+            case LFO_SAW:      return 2*p-1;
+            default:           return (p < 0.5f) ? 1.0f : -1.0f;  // LFO_SQUARE
+        }
+    }
+    void tick(Matrix* m, const Config* c, int i)
+    { // Sources at sample i of the block, then ramp every dest to its new value
+        const float dt = static_cast<float>(c->rate)/c->sample_rate; // Seconds per tick
+        for(int s=0; s<c->num_sources; s++)
+        {
+            const Source& src = c->sources[s];
+            switch(src.type)
+            {
+                case ENV:
+                {
+                    Uint32 t = m->triggers[s].load(std::memory_order_acquire);
+                    if(t != m->seen[s]) { m->seen[s] = t; m->stage[s] = ATTACK; m->env[s] = 0; }
+                    if(m->stage[s] == ATTACK)
+                    {
+                        m->env[s] += (src.a > 0) ? dt/src.a : 1;
+                        if(m->env[s] >= 1) { m->env[s] = 1; m->stage[s] = RELEASE; }
+                    }
+                    else if(m->stage[s] == RELEASE)
+                    {
+                        m->env[s] -= (src.b > 0) ? dt/src.b : 1;
+                        if(m->env[s] <= 0) { m->env[s] = 0; m->stage[s] = IDLE; }
+                    }
+                    m->value[s] = m->env[s];
+                    break;
+                }
+                case EXTERNAL:
+                    m->value[s] = src.ext ? src.ext[i] : 0;
+                    break;
+                default:
+                    m->value[s] = lfo(src.type, m->phase[s]);
+                    m->phase[s] += static_cast<Uint32>(src.a*dt*4294967296.0 + 0.5);
+                    break;
+            }
+        }
+        float target[MAX_DESTS];
+        for(int d=0; d<c->num_dests; d++) target[d] = c->dests[d].base;
+        for(int r=0; r<c->num_routes; r++)
+        {
+            const Route& route = c->routes[r];
+            target[route.dest] += route.depth*m->value[route.src];
+        }
+        for(int d=0; d<c->num_dests; d++)
+        {
+            const Dest& dest = c->dests[d];
+            if(target[d] < dest.lo) target[d] = dest.lo;
+            if(target[d] > dest.hi) target[d] = dest.hi;
+            m->step[d] = (target[d] - m->now[d])/c->rate;
+        }
+        m->countdown = c->rate;
+    }
+    const Config* acquire(Matrix* m, bool take_fade=true)
+    { // Audio thread, start of block : switch to the newest config. NULL if none yet.
+      // take_fade false : a config published with fade=true stays pending.
+        int p = m->pending.load(std::memory_order_acquire);
+        if((p >= 0) && (take_fade || !(p & FADE))
+            && m->pending.compare_exchange_strong(p, -1, std::memory_order_acq_rel))
+        {
+            p &= SLOT_MASK;
+            if(m->live.load(std::memory_order_relaxed) < 0)
+            { // First config : start at base values, not ramping up from 0
+                for(int d=0; d<m->configs[p].num_dests; d++) m->now[d] = m->configs[p].dests[d].base;
+            }
+            m->live.store(p, std::memory_order_release);
+        }
+        int live = m->live.load(std::memory_order_relaxed);
+        return (live >= 0) ? &m->configs[live] : NULL;
+    }
+    bool run(Matrix* m, float* out, int stride, int frames, bool take_fade=true)
+    { // Audio thread : fill out[dest*stride + 0 : frames). False (out untouched) if nothing published yet.
+        const Config* c = acquire(m, take_fade);
+        if(c == NULL) return false;
+        for(int i=0; i<frames; )
+        { // One stretch between ticks at a time
+            if(m->countdown <= 0) tick(m, c, i);
+            int n = frames - i;
+            if(n > m->countdown) n = m->countdown;
+            for(int d=0; d<c->num_dests; d++)
+            {
+                float v = m->now[d], step = m->step[d];
+                float* o = out + d*stride + i;
+                for(int k=0; k<n; k++) { o[k] = v; v += step; }
+                m->now[d] = v;
+            }
+            m->countdown -= n; i += n;
+        }
+        return true;
+    }
+}
+
+#endif // __MG_MOD_H__
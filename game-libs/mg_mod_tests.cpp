@@ -0,0 +1,128 @@
+#include <cstdio>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_mod.h"
+
+namespace ModTests
+{
+    constexpr int N = 256;                              // Samples per run
+    constexpr int SAMPLE_RATE = 3200;                   // 100 ticks a second at rate 32
+    float ext[N];
+    float out[2][N];
+    Mod::Config config(int rate)
+    { // One external source, one LFO, one envelope. Dest 0 : 0:1, dest 1 : -1:1.
+        Mod::Config c{};
+        c.rate = rate; c.sample_rate = SAMPLE_RATE;
+        c.sources[0] = {Mod::EXTERNAL, 0, 0, ext};
+        c.sources[1] = {Mod::LFO_TRIANGLE, 1, 0, NULL}; // 1Hz
+        c.sources[2] = {Mod::ENV, 0.1f, 0.2f, NULL};    // 10 ticks up, 20 ticks down
+        c.num_sources = 3;
+        c.dests[0] = {0, 0, 1};
+        c.dests[1] = {0, -1, 1};
+        c.num_dests = 2;
+        return c;
+    }
+}
+
+void run_tests_for_mg_mod()
+{
+    using namespace ModTests;
+    { // Nothing published : out untouched
+        static Mod::Matrix m;
+        TEST(!Mod::run(&m, &out[0][0], N, N));
+    }
+    { // Step at a tick ramps linearly over the next rate samples, then holds
+        static Mod::Matrix m;
+        for(float& v : ext) v = 1;
+        Mod::Config c = config(32);
+        Mod::route(&c, 0, 0, 1);
+        TEST(Mod::publish(&m, &c));
+        TEST(Mod::run(&m, &out[0][0], N, N));
+        bool ok = true;
+        for(int i=0; i<N; i++)
+        {
+            float want = (i < 32) ? i/32.0f : 1.0f;
+            if(SDL_fabsf(out[0][i] - want) > 1e-5f) { Tests::note("sample %d : %f, want %f", i, out[0][i], want); ok = false; break; }
+        }
+        TEST(ok);
+    }
+    { // Routes to one dest add up, then clamp
+        static Mod::Matrix m;
+        for(float& v : ext) v = 1;
+        Mod::Config c = config(32);
+        Mod::route(&c, 0, 1, 0.5f);
+        Mod::route(&c, 0, 1, 0.25f);
+        Mod::publish(&m, &c);
+        Mod::run(&m, &out[0][0], N, N);
+        TESTnear(out[1][N-1], 0.75, 1e-5);
+        Mod::route(&c, 0, 1, 0.5f);                     // 1.25 : over hi
+        Mod::publish(&m, &c);
+        Mod::run(&m, &out[0][0], N, N);
+        TESTnear(out[1][N-1], 1, 1e-5);
+    }
+    { // LFO : one period per second, whatever the block size
+        static Mod::Matrix m;
+        Mod::Config c = config(32);
+        Mod::route(&c, 1, 1, 1);
+        Mod::publish(&m, &c);
+        // Each tick's value is reached at the next tick : sample 32 has tick 0's value
+        Mod::run(&m, &out[0][0], N, 33);
+        float start = out[1][32];
+        TESTnear(start, -1, 1e-5);                      // Triangle starts at -1
+        int done = 33;
+        const int blocks[] = {7, 64, 1, 100, 256};
+        for(int k=0; done < SAMPLE_RATE+32; k++)
+        { // Odd block sizes : ticks land mid-block
+            int n = blocks[k%5];
+            if(n > SAMPLE_RATE+32 - done) n = SAMPLE_RATE+32 - done;
+            Mod::run(&m, &out[0][0], N, n);
+            done += n;
+        }
+        Mod::run(&m, &out[0][0], N, 1);                 // Sample 3232 : tick 100's value
+        TESTnear(out[1][0], start, 1e-3);               // Back where it started
+    }
+    { // Envelope : up in attack, down in release, then holds at 0
+        static Mod::Matrix m;
+        Mod::Config c = config(32);
+        Mod::route(&c, 2, 0, 1);
+        Mod::publish(&m, &c);
+        Mod::run(&m, &out[0][0], N, N);
+        TESTeq(out[0][N-1], 0);                         // Not triggered yet
+        Mod::trigger(&m, 2);
+        float peak = 0; int peak_at = 0;
+        for(int b=0; b<4; b++)
+        { // 4*256 samples : 32 ticks
+            Mod::run(&m, &out[0][0], N, N);
+            for(int i=0; i<N; i++) if(out[0][i] > peak) { peak = out[0][i]; peak_at = b*N + i; }
+        }
+        TESTnear(peak, 1, 1e-5);
+        TEST((peak_at >= 10*32) && (peak_at <= 11*32)); // Reached 1 at tick 10, ramped there over tick 10
+        TESTeq(out[0][N-1], 0);                         // 10 ticks up + 20 down < 32 ticks
+    }
+    { // New rate takes effect : ticks every 8 samples
+        static Mod::Matrix m;
+        for(int i=0; i<N; i++) ext[i] = static_cast<float>(i)/N;
+        Mod::Config c = config(8);
+        Mod::route(&c, 0, 0, 1);
+        Mod::publish(&m, &c);
+        Mod::run(&m, &out[0][0], N, N);
+        // At tick k (sample 8k) the target is ext[8k], reached at sample 8k+8
+        TESTnear(out[0][8*10+8], ext[8*10], 1e-5);
+    }
+    { // publish() refuses rates and ranges run() cannot use
+        static Mod::Matrix m;
+        Mod::Config c = config(32);
+        TEST(Mod::check(&c));
+        c = config(32); c.sources[1].a = -1;
+        TEST(!Mod::publish(&m, &c));                    // Negative LFO rate : phase step would be negative
+        c = config(32); c.sources[1].a = static_cast<float>(SAMPLE_RATE)/32;
+        TEST(!Mod::publish(&m, &c));                    // One cycle per tick
+        c = config(32); c.sources[2].b = -0.5f;
+        TEST(!Mod::publish(&m, &c));
+        c = config(32); c.dests[1].lo = 1; c.dests[1].hi = -1;
+        TEST(!Mod::publish(&m, &c));                    // lo > hi
+        c = config(32); c.dests[0].base = SDL_sqrtf(-1.0f);
+        TEST(!Mod::publish(&m, &c));                    // NaN
+        TEST(!Mod::run(&m, &out[0][0], N, N));          // Nothing was published
+    }
+}
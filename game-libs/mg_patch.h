@@ -0,0 +1,255 @@
+#ifndef __MG_PATCH_H__
+#define __MG_PATCH_H__
+
+#include <atomic>
+#include <cstring>
+
+namespace Patch
+{ // Node graph compiled to a flat, sorted list of steps for the audio thread (include SDL.h first)
+    /* *************DOC***************
+     * UI thread : edit a Graph, then publish() it
+     *
+     *      Patch::Graph g; Patch::clear(&g, kinds, NUM_KINDS);
+     *      int osc = Patch::add(&g, SAW);
+     *      int amp = Patch::add(&g, MUL);
+     *      Patch::connect(&g, osc, amp, 0);                // osc out -> amp input 0
+     *      Patch::connect(&g, env, amp, 1);
+     *      g.output = amp;
+     *      if(!Patch::publish(&engine, &g)) ...cycle : audio keeps the old plan...
+     *
+     * Audio thread : once per block, take the newest plan, then run it
+     *
+     *      const Patch::Plan* plan = Patch::acquire(&engine);
+     *      const float* out = Patch::run(&engine, plan, frames); // NULL : no plan yet
+     *
+     * compile() keeps only nodes the output depends on, puts them in dependency
+     * order (Kahn's algorithm : a node is ready when every node feeding it is
+     * placed), and gives each step its own block buffer. Running a plan is one
+     * loop over its steps : no pointers to chase, no allocation.
+     *
+     * A Kind is one type of node (oscillator, mixer, ...) : how many inputs it
+     * reads, and the process() that fills its out buffer. Kinds are defined by
+     * the user of this lib (see Nodes in src/synth.h).
+     *
+     * Node state (oscillator phase, filter memory) lives in the Engine, one State
+     * per node id, so it survives recompiles : editing the patch does not reset
+     * the oscillators that are still in it.
+     *
+     * Plans are triple-buffered. The UI writes a slot the audio thread is not
+     * using and has not been offered, then offers it (pending). The audio
+     * thread swaps to the pending plan at the start of its next block. Neither
+     * side ever waits on the other.
+     *
+     * publish(..., fade=true) marks the offer : the caller wants to fade out
+     * before switching to it (a preset change). acquire(..., take_fade=false)
+     * leaves a marked offer pending, so the audio thread can fade out first and
+     * take it once it is silent. fade_pending() says if one is waiting.
+     * *******************************/
+    constexpr int MAX_NODES = 32;
+    constexpr int MAX_INPUTS = 4;
+    constexpr int MAX_PARAMS = 4;
+    constexpr int BLOCK = 64;                           // Max frames per run()
+    constexpr int NO_NODE = -1;
+    constexpr int ZERO_BUF = MAX_NODES;                 // Unconnected inputs read zeros
+
+    struct State { Uint32 phase; float z[4]; };         // Per node, kept across plans
+    struct Step;
+    using Process = void (*)(const Step& s, State* state, const float* const* in, float* out, int frames);
+    struct Kind
+    {
+        const char* name;
+        int num_inputs;
+        Process process;
+    };
+
+    ////////////////
+    // GRAPH (UI thread)
+    ////////////////
+    struct Node
+    {
+        bool used;
+        int kind;                                       // Index in Graph::kinds
+        int in[MAX_INPUTS];                             // Node feeding each input, or NO_NODE
+        float param[MAX_PARAMS];                        // Meaning depends on kind
+    };
+    struct Graph
+    {
+        const Kind* kinds{}; int num_kinds{};
+        Node nodes[MAX_NODES]{};
+        int output{NO_NODE};                            // Node whose out buffer is the result
+    };
+    void clear(Graph* g, const Kind* kinds, int num_kinds)
+    {
+        *g = Graph{};
+        g->kinds = kinds; g->num_kinds = num_kinds;
+    }
+    int add(Graph* g, int kind, float p0=0, float p1=0, float p2=0, float p3=0)
+    { // Add a node with no inputs connected. Return its id, NO_NODE if graph is full.
+        if((kind < 0) || (kind >= g->num_kinds)) return NO_NODE;
+        for(int id=0; id<MAX_NODES; id++)
+        {
+            Node* n = &g->nodes[id];
+            if(n->used) continue;
+            n->used = true; n->kind = kind;
+            for(int i=0; i<MAX_INPUTS; i++) n->in[i] = NO_NODE;
+            n->param[0] = p0; n->param[1] = p1; n->param[2] = p2; n->param[3] = p3;
+            return id;
+        }
+        return NO_NODE;
+    }
+    bool valid(const Graph* g, int id) { return (id >= 0) && (id < MAX_NODES) && g->nodes[id].used; }
+    bool connect(Graph* g, int from, int to, int input)
+    { // from's out buffer feeds input of to. False if either node or input is bad.
+        if(!valid(g, from) || !valid(g, to)) return false;
+        if((input < 0) || (input >= g->kinds[g->nodes[to].kind].num_inputs)) return false;
+        g->nodes[to].in[input] = from;
+        return true;
+    }
+    void disconnect(Graph* g, int to, int input)
+    {
+        if(valid(g, to) && (input >= 0) && (input < MAX_INPUTS)) g->nodes[to].in[input] = NO_NODE;
+    }
+    void remove(Graph* g, int id)
+    { // Remove node and every connection from it
+        if(!valid(g, id)) return;
+        g->nodes[id].used = false;
+        for(Node& n : g->nodes)
+            for(int i=0; i<MAX_INPUTS; i++) if(n.in[i] == id) n.in[i] = NO_NODE;
+        if(g->output == id) g->output = NO_NODE;
+    }
+
+    ////////////////
+    // PLAN
+    ////////////////
+    struct Step
+    {
+        Process process;
+        int node;                                       // Node id : index of its State
+        int in_buf[MAX_INPUTS];                         // Buffer index per input (ZERO_BUF if none)
+        int out_buf;
+        float param[MAX_PARAMS];
+    };
+    struct Plan
+    {
+        Step steps[MAX_NODES];
+        int num_steps;
+        int out_buf;                                    // Result
+    };
+    bool compile(const Graph* g, Plan* p)
+    { // Sorted steps for the nodes output depends on. False (p unchanged) if they form a cycle
+      // or one has a bad kind.
+        if(!valid(g, g->output)) return false;
+        bool needed[MAX_NODES]{};
+        { // Walk inputs back from the output
+            int stack[MAX_NODES]; int top = 0;
+            needed[g->output] = true; stack[top++] = g->output;
+            while(top)
+            {
+                const Node& n = g->nodes[stack[--top]];
+                for(int i=0; i<MAX_INPUTS; i++)
+                {
+                    int from = n.in[i];
+                    if(!valid(g, from) || needed[from]) continue;
+                    needed[from] = true; stack[top++] = from;
+                }
+            }
+        }
+        int waiting[MAX_NODES]{};                       // Per node : inputs not placed yet
+        int ready[MAX_NODES]; int num_ready = 0;
+        int num_needed = 0;
+        for(int id=0; id<MAX_NODES; id++)
+        {
+            if(!needed[id]) continue;
+            if((g->nodes[id].kind < 0) || (g->nodes[id].kind >= g->num_kinds)) return false;
+            num_needed++;
+            for(int i=0; i<MAX_INPUTS; i++) if(valid(g, g->nodes[id].in[i])) waiting[id]++;
+            if(waiting[id] == 0) ready[num_ready++] = id;
+        }
+        int order[MAX_NODES]; int num_order = 0;
+        while(num_ready)
+        { // Kahn : place a ready node, then every input it feeds is one closer to ready
+            int id = ready[--num_ready];
+            order[num_order++] = id;
+            for(int to=0; to<MAX_NODES; to++)
+            {
+                if(!needed[to]) continue;
+                for(int i=0; i<MAX_INPUTS; i++)
+                    if((g->nodes[to].in[i] == id) && (--waiting[to] == 0)) ready[num_ready++] = to;
+            }
+        }
+        if(num_order < num_needed) return false;        // Cycle : some node never got ready
+        int buf_of[MAX_NODES];
+        for(int k=0; k<num_order; k++)
+        {
+            const Node& n = g->nodes[order[k]];
+            Step* s = &p->steps[k];
+            s->process = g->kinds[n.kind].process;
+            s->node = order[k];
+            s->out_buf = k; buf_of[order[k]] = k;       // One buffer per step
+            for(int i=0; i<MAX_INPUTS; i++) s->in_buf[i] = valid(g, n.in[i]) ? buf_of[n.in[i]] : ZERO_BUF;
+            memcpy(s->param, n.param, sizeof(s->param));
+        }
+        p->num_steps = num_order;
+        p->out_buf = buf_of[g->output];
+        return true;
+    }
+
+    ////////////////
+    // ENGINE
+    ////////////////
+    constexpr int SLOT_MASK = 0xFF;                     // pending : slot, plus FADE flag
+    constexpr int FADE = 1<<8;
+    struct Engine
+    {
+        Plan plans[3]{};                                // live, pending, and one for the UI to write
+        std::atomic<int> pending{-1};                   // Plan offered to audio thread (-1 : none)
+        std::atomic<int> live{-1};                      // Plan audio thread is running (-1 : none)
+        State state[MAX_NODES]{};                       // Audio thread only
+        alignas(64) float buf[MAX_NODES+1][BLOCK]{};    // Step outputs, then ZERO_BUF
+    };
+    bool publish(Engine* e, const Graph* g, bool fade=false)
+    { // UI thread : compile g and offer it to the audio thread. False if g has a cycle.
+        // Read pending first : only the audio thread can change live, and only to pending
+        int pending = e->pending.load(std::memory_order_acquire);
+        int live = e->live.load(std::memory_order_acquire);
+        int pending_slot = (pending >= 0) ? (pending & SLOT_MASK) : -1;
+        int slot = 0;
+        while((slot == pending_slot) || (slot == live)) slot++;
+        if(!compile(g, &e->plans[slot])) return false;
+        if((pending >= 0) && (pending & FADE)) fade = true; // Still fade to what it replaces
+        // Replaces an offer not taken yet
+        e->pending.store(slot | (fade ? FADE : 0), std::memory_order_release);
+        return true;
+    }
+    bool fade_pending(const Engine* e)
+    { // An offer made with fade=true is waiting
+        int p = e->pending.load(std::memory_order_acquire);
+        return (p >= 0) && (p & FADE);
+    }
+    const Plan* acquire(Engine* e, bool take_fade=true)
+    { // Audio thread, start of block : switch to the newest plan. NULL if none yet.
+      // take_fade false : an offer made with fade=true stays pending.
+        int p = e->pending.load(std::memory_order_acquire);
+        if((p >= 0) && (take_fade || !(p & FADE))
+            && e->pending.compare_exchange_strong(p, -1, std::memory_order_acq_rel))
+        { // (UI replaced the offer if the exchange failed : take that one next block)
+            e->live.store(p & SLOT_MASK, std::memory_order_release);
+        }
+        int live = e->live.load(std::memory_order_relaxed);
+        return (live >= 0) ? &e->plans[live] : NULL;
+    }
+    float* run(Engine* e, const Plan* p, int frames)
+    { // Audio thread : run every step for frames (<= BLOCK). Return output buffer, NULL if no plan.
+        if(p == NULL) return NULL;
+        for(int k=0; k<p->num_steps; k++)
+        {
+            const Step& s = p->steps[k];
+            const float* in[MAX_INPUTS];
+            for(int i=0; i<MAX_INPUTS; i++) in[i] = e->buf[s.in_buf[i]];
+            s.process(s, &e->state[s.node], in, e->buf[s.out_buf], frames);
+        }
+        return e->buf[p->out_buf];
+    }
+}
+
+#endif // __MG_PATCH_H__
@@ -0,0 +1,107 @@
+#include <cstdio>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_patch.h"
+
+namespace PatchTests
+{ // Tiny node kinds with outputs easy to predict
+    enum { CONST, ADD, COUNT, NUM_KINDS };
+    void constant(const Patch::Step& s, Patch::State*, const float* const*, float* out, int frames)
+    {
+        for(int i=0; i<frames; i++) out[i] = s.param[0];
+    }
+    void add(const Patch::Step&, Patch::State*, const float* const* in, float* out, int frames)
+    {
+        for(int i=0; i<frames; i++) out[i] = in[0][i] + in[1][i];
+    }
+    void count(const Patch::Step&, Patch::State* st, const float* const*, float* out, int frames)
+    { // Samples run so far : shows whether state survived a new plan
+        for(int i=0; i<frames; i++) out[i] = static_cast<float>(st->phase++);
+    }
+    constexpr Patch::Kind KINDS[NUM_KINDS] = {{"const", 0, constant}, {"add", 2, add}, {"count", 0, count}};
+    Patch::Engine engine;
+    float run(int frames=1)
+    { // Last sample of one block, -1 if no plan
+        const float* out = Patch::run(&engine, Patch::acquire(&engine), frames);
+        return out ? out[frames-1] : -1;
+    }
+}
+
+void run_tests_for_mg_patch()
+{
+    using namespace PatchTests;
+    Patch::Graph g;
+    Patch::clear(&g, KINDS, NUM_KINDS);
+    TESTeq(run(), -1);                                  // Nothing published : no plan
+    // sum = (a + b) + c, added in an order that is not the dependency order
+    int sum = Patch::add(&g, ADD);
+    int ab  = Patch::add(&g, ADD);
+    int c   = Patch::add(&g, CONST, 100);
+    int a   = Patch::add(&g, CONST, 1);
+    int b   = Patch::add(&g, CONST, 10);
+    int spare = Patch::add(&g, CONST, 1000);            // Not connected to the output
+    TEST(Patch::connect(&g, a, ab, 0) && Patch::connect(&g, b, ab, 1));
+    TEST(Patch::connect(&g, ab, sum, 0) && Patch::connect(&g, c, sum, 1));
+    TEST(!Patch::connect(&g, a, c, 0));                 // CONST has no inputs
+    g.output = sum;
+    { // Compiled in dependency order, without the spare node
+        Patch::Plan p;
+        TEST(Patch::compile(&g, &p));
+        TESTeq(p.num_steps, 5);
+        int step_of[Patch::MAX_NODES];
+        for(int& k : step_of) k = -1;
+        for(int k=0; k<p.num_steps; k++) step_of[p.steps[k].node] = k;
+        TESTeq(step_of[spare], -1);
+        TEST((step_of[a] < step_of[ab]) && (step_of[b] < step_of[ab]) && (step_of[ab] < step_of[sum]) && (step_of[c] < step_of[sum]));
+    }
+    TEST(Patch::publish(&engine, &g));
+    TESTeq(run(Patch::BLOCK), 111);
+    { // Unconnected input reads zeros
+        Patch::disconnect(&g, sum, 1);
+        TEST(Patch::publish(&engine, &g));
+        TESTeq(run(), 11);
+    }
+    { // Cycle : not published, audio keeps playing the last good plan
+        Patch::connect(&g, sum, ab, 1);                 // ab -> sum -> ab
+        TEST(!Patch::publish(&engine, &g));
+        TESTeq(run(), 11);
+        Patch::connect(&g, b, ab, 1);
+    }
+    { // Node state survives a new plan
+        int n = Patch::add(&g, COUNT);
+        Patch::connect(&g, n, sum, 1);
+        TEST(Patch::publish(&engine, &g));
+        TESTeq(run(4), 11+3);                           // Counts 0 : 3
+        TEST(Patch::publish(&engine, &g));
+        TESTeq(run(4), 11+7);                           // Same node : counts on
+    }
+    { // Two edits before the audio thread takes one : newest wins, live plan never written
+        Patch::Graph g2 = g;
+        g2.output = a;
+        TEST(Patch::publish(&engine, &g2));
+        int first = engine.pending.load();
+        g2.output = b;
+        TEST(Patch::publish(&engine, &g2));
+        TEST(engine.pending.load() != first);
+        TEST(engine.pending.load() != engine.live.load());
+        TESTeq(run(), 10);
+    }
+    { // fade=true : offer waits for acquire(take_fade=true), a plain edit on top still waits
+        Patch::Graph g2 = g;
+        g2.output = c;
+        TEST(Patch::publish(&engine, &g2, true));
+        int live = engine.live.load();
+        Patch::acquire(&engine, false);
+        TESTeq(engine.live.load(), live);
+        TEST(Patch::publish(&engine, &g2));
+        TEST(Patch::fade_pending(&engine));
+        TESTeq(run(), 100);
+        TEST(!Patch::fade_pending(&engine));
+    }
+    { // remove() disconnects the node everywhere
+        Patch::remove(&g, a);
+        TESTeq(g.nodes[ab].in[0], Patch::NO_NODE);
+        TEST(Patch::publish(&engine, &g));
+        TESTeq(run(4), 10+11);                          // b + counter (counts 8 : 11)
+    }
+}
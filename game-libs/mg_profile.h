@@ -0,0 +1,246 @@
+#ifndef __MG_PROFILE_H__
+#define __MG_PROFILE_H__
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+/* *************Build flags***************
+ * MG_PROFILE : 1 (default) zones are timed, 0 zones do nothing
+ * *******************************/
+#ifndef MG_PROFILE
+#define MG_PROFILE 1
+#endif
+
+namespace Profile
+{ // Scoped timing zones per thread, per-frame totals, Chrome trace export (include SDL.h first)
+    /* *************DOC***************
+     * PROFILE_ZONE("name") times the rest of the enclosing block:
+     *
+     *      { // Physics
+     *          PROFILE_ZONE("physics");
+     *          ...
+     *      }
+     *
+     * Or, for code that is not its own block:
+     *
+     *      Profile::Zone events("events");
+     *      while(SDL_PollEvent(&e)) { ... }
+     *      events.end();
+     *
+     * Each thread has its own Track, a ring of finished zones (name, start, end,
+     * nesting depth) on the SDL_GetPerformanceCounter clock. A thread gets a Track
+     * the first time it enters a zone; only that thread writes to it, so there is
+     * no lock. A new thread that calls name_thread() with the name of an existing
+     * track takes that track over: SDL starts a new audio thread every time the
+     * audio device is reopened, and each would otherwise take one of the
+     * MAX_TRACKS. Only one live thread may have a given name.
+     *
+     * Other threads read a Track like a SnapshotRing: copy, then check the writer
+     * did not lap what was copied (see copy()).
+     *
+     * Timeline: call end_frame() once per rendered frame. It sums the depth-0 zones
+     * every thread finished since the last call, by name, into one stacked bar.
+     *
+     * export_chrome() writes every zone still in the rings as Chrome trace-event
+     * JSON (open in chrome://tracing or https://ui.perfetto.dev).
+     * *******************************/
+    constexpr int MAX_TRACKS = 4;                       // Threads that can have zones
+    constexpr Uint32 SIZE = 1<<14;                      // Zones per track
+    constexpr Uint32 MASK = SIZE-1;
+    struct Event
+    {
+        const char* name;
+        Uint64 t0, t1;                                  // SDL_GetPerformanceCounter
+        int depth;                                      // 0 : not inside another zone
+    };
+    struct Track
+    {
+        Event buf[SIZE]{};
+        std::atomic<Uint32> head{0};                    // Zones written (wraps)
+        std::atomic<const char*> name{};                // Thread name for the trace
+        int depth{};                                    // Zones open right now
+    };
+    Track tracks[MAX_TRACKS];
+    std::atomic<int> num_tracks{0};
+    thread_local Track* my_track{};
+
+    Track* track(void)
+    { // This thread's track, NULL if every track is taken
+        if(my_track) return my_track;
+        int i = num_tracks.load(std::memory_order_relaxed);
+        if(i >= MAX_TRACKS) return NULL;
+        i = num_tracks.fetch_add(1, std::memory_order_relaxed);
+        if(i >= MAX_TRACKS) return NULL;
+        my_track = &tracks[i];
+        return my_track;
+    }
+    void name_thread(const char* name)
+    { // Name this thread in the trace, reuse the track of a thread of that name that is gone
+        if(!my_track)
+        {
+            int n = num_tracks.load(std::memory_order_acquire);
+            if(n > MAX_TRACKS) n = MAX_TRACKS;
+            for(int k=0; k<n; k++)
+            {
+                const char* had = tracks[k].name.load(std::memory_order_acquire);
+                if(had && (strcmp(had, name) == 0)) { my_track = &tracks[k]; return; }
+            }
+        }
+        Track* t = track();
+        if(t) t->name.store(name, std::memory_order_release);
+    }
+    void push(Track* t, const Event& e)
+    { // Owner thread only
+        Uint32 h = t->head.load(std::memory_order_relaxed);
+        t->buf[h&MASK] = e;
+        t->head.store(h+1, std::memory_order_release);
+    }
+    struct Zone
+    { // RAII : time from constructor to end() or destructor
+        Track* t;
+        const char* name;
+        Uint64 t0;
+        int depth;
+        Zone(const char* name) : t(MG_PROFILE ? track() : NULL), name(name)
+        {
+            depth = t ? t->depth++ : 0;
+            t0 = t ? SDL_GetPerformanceCounter() : 0;
+        }
+        void end(void)
+        { // Zone ends here instead of at end of scope
+            if(!t) return;
+            Uint64 t1 = SDL_GetPerformanceCounter();
+            t->depth--;
+            push(t, Event{name, t0, t1, depth});
+            t = NULL;
+        }
+        ~Zone() { end(); }
+    };
+    int copy(const Track* t, Uint32 from, Uint32 n, Event* out)
+    { // Any thread : copy zones [from : from+n) (already written), oldest first.
+      // Return number copied : zones the writer lapped while copying are left out.
+        for(Uint32 i=0; i<n; i++) out[i] = t->buf[(from+i)&MASK];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        Uint32 h = t->head.load(std::memory_order_relaxed);
+        // The writer may be overwriting zone h - SIZE now : zones before that are gone
+        Uint32 lapped = (h + 1 - SIZE) - from;
+        if(static_cast<Sint32>(lapped) > 0)
+        {
+            if(lapped > n) lapped = n;
+            memmove(out, out+lapped, (n-lapped)*sizeof(Event));
+            n -= lapped;
+        }
+        return static_cast<int>(n);
+    }
+
+    ////////////////
+    // TIMELINE
+    ////////////////
+    constexpr int FRAMES = 120;                         // Frames in timeline
+    constexpr int MAX_NAMES = 12;                       // Zone names in timeline
+    constexpr int BATCH = 256;                          // Zones copied per read
+    struct Timeline
+    {
+        const char* names[MAX_NAMES]{};                 // Names to sum (others are ignored)
+        int num_names{};
+        float ms[FRAMES][MAX_NAMES]{};                  // ms per name per frame
+        int newest{-1};                                 // Index of newest frame in ms
+        Uint32 read[MAX_TRACKS]{};                      // Per track : zones already summed
+    };
+    int add_name(Timeline* tl, const char* name)
+    { // Sum zones with this name. Return its index (color, legend order).
+        if(tl->num_names == MAX_NAMES) return -1;
+        tl->names[tl->num_names] = name;
+        return tl->num_names++;
+    }
+    int find(const Timeline* tl, const char* name)
+    {
+        for(int i=0; i<tl->num_names; i++) if(tl->names[i] == name) return i;
+        for(int i=0; i<tl->num_names; i++) if(strcmp(tl->names[i], name) == 0) return i;
+        return -1;
+    }
+    void end_frame(Timeline* tl)
+    { // Sum depth-0 zones finished since last call into a new frame
+        tl->newest = (tl->newest+1) % FRAMES;
+        float* ms = tl->ms[tl->newest];
+        for(int i=0; i<MAX_NAMES; i++) ms[i] = 0;
+        const double ms_per_tick = 1000.0/SDL_GetPerformanceFrequency();
+        int n_tracks = num_tracks.load(std::memory_order_acquire);
+        if(n_tracks > MAX_TRACKS) n_tracks = MAX_TRACKS;
+        Event batch[BATCH];
+        for(int k=0; k<n_tracks; k++)
+        {
+            Uint32 head = tracks[k].head.load(std::memory_order_acquire);
+            if(head - tl->read[k] > SIZE) tl->read[k] = head - SIZE; // Fell behind
+            while(tl->read[k] != head)
+            { // Oldest first, one batch at a time
+                Uint32 n = head - tl->read[k];
+                if(n > BATCH) n = BATCH;
+                int copied = copy(&tracks[k], tl->read[k], n, batch);
+                for(int i=0; i<copied; i++)
+                {
+                    if(batch[i].depth != 0) continue;
+                    int j = find(tl, batch[i].name);
+                    if(j >= 0) ms[j] += static_cast<float>((batch[i].t1 - batch[i].t0)*ms_per_tick);
+                }
+                tl->read[k] += n;
+            }
+        }
+    }
+
+    ////////////////
+    // EXPORT
+    ////////////////
+    bool export_chrome(const char* path)
+    { // Write every zone in every track as Chrome trace-event JSON. False if no file.
+        FILE* f = fopen(path, "w");
+        if(f == NULL) return false;
+        const double us_per_tick = 1e6/SDL_GetPerformanceFrequency();
+        int n_tracks = num_tracks.load(std::memory_order_acquire);
+        if(n_tracks > MAX_TRACKS) n_tracks = MAX_TRACKS;
+        Event* events = (Event*)malloc(SIZE*sizeof(Event));
+        if(events == NULL) { fclose(f); return false; }
+        auto copy_all = [events](const Track* t)
+        { // Everything still in the ring
+            Uint32 head = t->head.load(std::memory_order_acquire);
+            Uint32 n = (head < SIZE) ? head : SIZE;
+            return copy(t, head - n, n, events);
+        };
+        Uint64 base = 0;                                // Earliest start : ts = 0
+        for(int k=0; k<n_tracks; k++)
+        {
+            int n = copy_all(&tracks[k]);
+            for(int i=0; i<n; i++) if((base == 0) || (events[i].t0 < base)) base = events[i].t0;
+        }
+        fprintf(f, "{\"traceEvents\":[\n");
+        bool first = true;
+        for(int k=0; k<n_tracks; k++)
+        {
+            const char* name = tracks[k].name.load(std::memory_order_acquire);
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                    "\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", k,
+                    name ? name : "thread");
+            first = false;
+            int n = copy_all(&tracks[k]);
+            for(int i=0; i<n; i++)
+            {
+                const Event& e = events[i];
+                if(e.t0 < base) continue;               // Pushed after base was found
+                fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                        "\"ts\":%.3f,\"dur\":%.3f}", e.name, k,
+                        (e.t0 - base)*us_per_tick, (e.t1 - e.t0)*us_per_tick);
+            }
+        }
+        fprintf(f, "\n]}\n");
+        free(events);
+        fclose(f);
+        return true;
+    }
+}
+
+#define PROFILE_CAT2(a, b) a##b
+#define PROFILE_CAT(a, b) PROFILE_CAT2(a, b)
+#define PROFILE_ZONE(name) Profile::Zone PROFILE_CAT(profile_zone_, __LINE__)(name)
+
+#endif // __MG_PROFILE_H__
@@ -0,0 +1,340 @@
+#ifndef __MG_RASTER_H__
+#define __MG_RASTER_H__
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Raster
+{ // Draw into a CPU pixel buffer, upload only what changed (include SDL.h first)
+    /* *************DOC***************
+     * A Raster::Canvas is a w x h buffer of SDL_PIXELFORMAT_RGBA8888 pixels in memory.
+     * Drawing is plain C++ on that buffer:
+     *  - spans (horizontal runs of pixels) are filled 4 pixels at a time with SSE2
+     *  - lines are Bresenham, one pixel at a time
+     *  - images (sprites) are blit() from an RGBA8888 buffer, clear pixels skipped
+     *
+     * Blend modes match the SDL renderer:
+     *  - SDL_BLENDMODE_NONE  : dst = src
+     *  - SDL_BLENDMODE_ADD   : dst.rgb = dst.rgb + src.rgb*src.a (saturate at 255)
+     *  - SDL_BLENDMODE_BLEND : dst.rgb = src.rgb*src.a + dst.rgb*(1-src.a)
+     *
+     * Every draw marks the pixels it touched as dirty, as a span [x0:x1) per row.
+     * Code that writes px directly calls mark() for what it wrote.
+     *
+     * clear() with the same color as last time only refills (and marks dirty) the
+     * pixels drawn since that clear. Everything else already is the clear color, so a
+     * frame that redraws a few sprites on a cleared background sends a few rows.
+     * upload() compares dirty rows against what was uploaded last time and sends only
+     * the rows that really changed to a SDL_TEXTUREACCESS_STREAMING texture, one
+     * SDL_UpdateTexture call per band of changed rows.
+     *
+     * send_changes() does the same walk but hands each band to a callback, for
+     * destinations other than a texture of the same size (see mg_upscale.h).
+     *
+     *      Raster::Canvas cv;
+     *      Raster::init(&cv, GameArt::w, GameArt::h);
+     *      ...every frame...
+     *      Raster::clear(&cv, Colors::darkgravel);
+     *      cv.blend = SDL_BLENDMODE_ADD;
+     *      Raster::line(&cv, 0,0, 10,10, Colors::lime);
+     *      Raster::upload(&cv, tex);
+     * *******************************/
+    struct Canvas
+    {
+        Uint32* px{};                                   // w*h pixels, RGBA8888
+        Uint32* shadow{};                               // What the texture has now
+        int w{}, h{};
+        SDL_BlendMode blend{SDL_BLENDMODE_BLEND};       // Blend mode for draws
+        Sint32* dirty_x0{};                             // Per row : first dirty pixel
+        Sint32* dirty_x1{};                             // Per row : one past last dirty pixel
+        Sint32* drawn_x0{};                             // Per row : pixels drawn since clear()
+        Sint32* drawn_x1{};
+        Uint32 clear_v{};                               // Color of the last clear()
+        bool cleared{};                                 // Pixels outside drawn spans are clear_v
+        bool upload_all{true};                          // Destination has garbage : send all
+        int rows_uploaded{};                            // Rows sent in last upload()
+    };
+
+    bool init(Canvas* cv, int w, int h)
+    { // Allocate buffers. Return false if out of memory.
+        cv->w = w; cv->h = h;
+        cv->px = (Uint32*)malloc(w*h*sizeof(Uint32));
+        cv->shadow = (Uint32*)malloc(w*h*sizeof(Uint32));
+        cv->dirty_x0 = (Sint32*)malloc(h*sizeof(Sint32));
+        cv->dirty_x1 = (Sint32*)malloc(h*sizeof(Sint32));
+        cv->drawn_x0 = (Sint32*)malloc(h*sizeof(Sint32));
+        cv->drawn_x1 = (Sint32*)malloc(h*sizeof(Sint32));
+        if(!cv->px || !cv->shadow || !cv->dirty_x0 || !cv->dirty_x1 || !cv->drawn_x0 || !cv->drawn_x1) return false;
+        memset(cv->px, 0, w*h*sizeof(Uint32));
+        for(int y=0; y<h; y++) { cv->dirty_x0[y] = cv->drawn_x0[y] = w; cv->dirty_x1[y] = cv->drawn_x1[y] = 0; }
+        cv->cleared = false;
+        cv->upload_all = true;
+        return true;
+    }
+    void destroy(Canvas* cv)
+    {
+        free(cv->px); free(cv->shadow); free(cv->dirty_x0); free(cv->dirty_x1);
+        free(cv->drawn_x0); free(cv->drawn_x1);
+        cv->px = cv->shadow = NULL; cv->dirty_x0 = cv->dirty_x1 = NULL;
+        cv->drawn_x0 = cv->drawn_x1 = NULL;
+    }
+
+    ////////////////
+    // PIXELS
+    ////////////////
+    Uint32 pack(SDL_Color c)
+    { // SDL_PIXELFORMAT_RGBA8888 : 0xRRGGBBAA
+        return (Uint32(c.r)<<24) | (Uint32(c.g)<<16) | (Uint32(c.b)<<8) | Uint32(c.a);
+    }
+    Uint32 premultiply_rgb(SDL_Color c)
+    { // rgb*a with alpha byte zero (ADD leaves dst alpha alone)
+        return pack(SDL_Color{
+                static_cast<Uint8>((c.r*c.a + 127)/255),
+                static_cast<Uint8>((c.g*c.a + 127)/255),
+                static_cast<Uint8>((c.b*c.a + 127)/255),
+                0});
+    }
+    Uint32 add_sat(Uint32 dst, Uint32 src)
+    { // Per-byte saturating add
+        Uint32 out = 0;
+        for(int shift=0; shift<32; shift+=8)
+        {
+            Uint32 s = ((dst>>shift)&0xFF) + ((src>>shift)&0xFF);
+            out |= ((s > 0xFF) ? 0xFF : s) << shift;
+        }
+        return out;
+    }
+    Uint32 blend_over(Uint32 dst, SDL_Color c)
+    { // dst.rgb = src.rgb*a + dst.rgb*(1-a), dst.a = a + dst.a*(1-a)
+        Uint32 a = c.a; Uint32 ia = 255 - a;
+        Uint32 r = (c.r*a + ((dst>>24)&0xFF)*ia + 127)/255;
+        Uint32 g = (c.g*a + ((dst>>16)&0xFF)*ia + 127)/255;
+        Uint32 b = (c.b*a + ((dst>> 8)&0xFF)*ia + 127)/255;
+        Uint32 da = a + ((dst&0xFF)*ia + 127)/255;
+        return (r<<24) | (g<<16) | (b<<8) | da;
+    }
+
+    void mark(Canvas* cv, int y, int x0, int x1)
+    { // Mark pixels [x0:x1) on row y dirty (already clipped)
+        if(x0 < cv->dirty_x0[y]) cv->dirty_x0[y] = x0;
+        if(x1 > cv->dirty_x1[y]) cv->dirty_x1[y] = x1;
+        if(x0 < cv->drawn_x0[y]) cv->drawn_x0[y] = x0;
+        if(x1 > cv->drawn_x1[y]) cv->drawn_x1[y] = x1;
+    }
+
+    ////////////////
+    // SPANS
+    ////////////////
+    void span_copy(Uint32* p, int n, Uint32 v)
+    { // p[0:n) = v
+        int i = 0;
+#if defined(__SSE2__)
+        __m128i v4 = _mm_set1_epi32(static_cast<int>(v));
+        for(; i+4<=n; i+=4) _mm_storeu_si128((__m128i*)(p+i), v4);
+#endif
+        for(; i<n; i++) p[i] = v;
+    }
+    void span_add(Uint32* p, int n, Uint32 v)
+    { // p[0:n) += v, per byte, saturating
+        int i = 0;
+#if defined(__SSE2__)
+        __m128i v4 = _mm_set1_epi32(static_cast<int>(v));
+        for(; i+4<=n; i+=4)
+        {
+            __m128i d = _mm_loadu_si128((__m128i*)(p+i));
+            _mm_storeu_si128((__m128i*)(p+i), _mm_adds_epu8(d, v4));
+        }
+#endif
+        for(; i<n; i++) p[i] = add_sat(p[i], v);
+    }
+    void span_blend(Uint32* p, int n, SDL_Color c)
+    { // p[0:n) = blend_over(p, c)
+        /* *************DOC***************
+         * blend_over() is (src*a + dst*(255-a) + 127)/255 on all four bytes, with
+         * src = a*255 for the alpha byte. SSE2 does it on 16-bit lanes, two pixels per
+         * register, and divides by 255 with (t + 1 + (t>>8)) >> 8, which is exact for
+         * every t this can make (t <= 255*255 + 127). Same result as the scalar loop.
+         * *******************************/
+        int i = 0;
+#if defined(__SSE2__)
+        const Uint32 a = c.a; const Uint32 ia = 255 - a;
+        // Bytes in memory : a, b, g, r (RGBA8888 is 0xRRGGBBAA, little-endian)
+        const __m128i src = _mm_setr_epi16(
+                static_cast<short>(a*255 + 127), static_cast<short>(c.b*a + 127),
+                static_cast<short>(c.g*a + 127), static_cast<short>(c.r*a + 127),
+                static_cast<short>(a*255 + 127), static_cast<short>(c.b*a + 127),
+                static_cast<short>(c.g*a + 127), static_cast<short>(c.r*a + 127));
+        const __m128i ia8 = _mm_set1_epi16(static_cast<short>(ia));
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i zero = _mm_setzero_si128();
+        for(; i+4<=n; i+=4)
+        {
+            __m128i d = _mm_loadu_si128((__m128i*)(p+i));
+            __m128i lo = _mm_add_epi16(src, _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia8));
+            __m128i hi = _mm_add_epi16(src, _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ia8));
+            lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+            _mm_storeu_si128((__m128i*)(p+i), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for(; i<n; i++) p[i] = blend_over(p[i], c);
+    }
+    void span(Canvas* cv, int y, int x0, int x1, SDL_Color c)
+    { // Fill [x0:x1) on row y with the canvas blend mode (clips)
+        if((y < 0) || (y >= cv->h)) return;
+        if(x0 < 0) x0 = 0;
+        if(x1 > cv->w) x1 = cv->w;
+        if(x0 >= x1) return;
+        Uint32* p = cv->px + y*cv->w + x0;
+        switch(cv->blend)
+        {
+            case SDL_BLENDMODE_NONE: span_copy(p, x1-x0, pack(c)); break;
+            case SDL_BLENDMODE_ADD:  span_add(p, x1-x0, premultiply_rgb(c)); break;
+            default:                 span_blend(p, x1-x0, c); break;
+        }
+        mark(cv, y, x0, x1);
+    }
+
+    ////////////////
+    // PRIMITIVES
+    ////////////////
+    void clear(Canvas* cv, SDL_Color c)
+    { // Every pixel = c, ignores blend mode (like SDL_RenderClear)
+        Uint32 v = pack(c);
+        const bool same = cv->cleared && (v == cv->clear_v);
+        for(int y=0; y<cv->h; y++)
+        { // Same color : only the pixels drawn since the last clear need it
+            int x0 = same ? cv->drawn_x0[y] : 0;
+            int x1 = same ? cv->drawn_x1[y] : cv->w;
+            if(x0 < x1) { span_copy(cv->px + y*cv->w + x0, x1-x0, v); mark(cv, y, x0, x1); }
+            cv->drawn_x0[y] = cv->w; cv->drawn_x1[y] = 0;
+        }
+        cv->clear_v = v;
+        cv->cleared = true;
+    }
+    void fill_rect(Canvas* cv, SDL_Rect r, SDL_Color c)
+    {
+        for(int y=r.y; y<r.y+r.h; y++) span(cv, y, r.x, r.x+r.w, c);
+    }
+    void rect(Canvas* cv, SDL_Rect r, SDL_Color c)
+    { // 1-pixel outline, corners drawn once
+        if((r.w <= 0) || (r.h <= 0)) return;
+        if((r.w <= 2) || (r.h <= 2)) { fill_rect(cv, r, c); return; }
+        span(cv, r.y,       r.x, r.x+r.w, c);
+        span(cv, r.y+r.h-1, r.x, r.x+r.w, c);
+        for(int y=r.y+1; y<r.y+r.h-1; y++)
+        {
+            span(cv, y, r.x,       r.x+1,   c);
+            span(cv, y, r.x+r.w-1, r.x+r.w, c);
+        }
+    }
+    void line(Canvas* cv, int x0, int y0, int x1, int y1, SDL_Color c)
+    { // Bresenham : both end pixels included, like SDL_RenderDrawLine
+        int dx =  ((x1>x0) ? x1-x0 : x0-x1); int sx = (x0<x1) ? 1 : -1;
+        int dy = -((y1>y0) ? y1-y0 : y0-y1); int sy = (y0<y1) ? 1 : -1;
+        int err = dx + dy;
+        for(;;)
+        {
+            span(cv, y0, x0, x0+1, c);                  // span() clips
+            if((x0 == x1) && (y0 == y1)) break;
+            int e2 = 2*err;
+            if(e2 >= dy) { err += dy; x0 += sx; }
+            if(e2 <= dx) { err += dx; y0 += sy; }
+        }
+    }
+
+    ////////////////
+    // IMAGES
+    ////////////////
+    Uint32 modulate(Uint32 p, SDL_Color c)
+    { // Per-channel p*c/255, like a texture's color mod (vertex color)
+        Uint32 r = (((p>>24)&0xFF)*c.r + 127)/255;
+        Uint32 g = (((p>>16)&0xFF)*c.g + 127)/255;
+        Uint32 b = (((p>> 8)&0xFF)*c.b + 127)/255;
+        Uint32 a = (( p     &0xFF)*c.a + 127)/255;
+        return (r<<24) | (g<<16) | (b<<8) | a;
+    }
+    void blit(Canvas* cv, const Uint32* src, int src_pitch, SDL_Rect s, int x, int y, SDL_Color tint)
+    { // Draw s from src (RGBA8888, src_pitch pixels per row) at x,y, like SDL_BLENDMODE_BLEND
+        /* *************DOC***************
+         * Sprites are pixel art : most pixels are either clear (skipped) or opaque
+         * (copied). Only the rest pay for blend_over(). tint multiplies every pixel.
+         * *******************************/
+        if(x < 0) { s.x -= x; s.w += x; x = 0; }
+        if(y < 0) { s.y -= y; s.h += y; y = 0; }
+        if(x + s.w > cv->w) s.w = cv->w - x;
+        if(y + s.h > cv->h) s.h = cv->h - y;
+        if((s.w <= 0) || (s.h <= 0)) return;
+        const bool tinted = (tint.r != 255) || (tint.g != 255) || (tint.b != 255) || (tint.a != 255);
+        for(int row=0; row<s.h; row++)
+        {
+            const Uint32* sp = src + (s.y+row)*src_pitch + s.x;
+            Uint32* dp = cv->px + (y+row)*cv->w + x;
+            for(int i=0; i<s.w; i++)
+            {
+                Uint32 p = tinted ? modulate(sp[i], tint) : sp[i];
+                Uint32 a = p & 0xFF;
+                if(a == 0xFF) dp[i] = p;
+                else if(a) dp[i] = blend_over(dp[i], SDL_Color{
+                        static_cast<Uint8>(p>>24), static_cast<Uint8>(p>>16),
+                        static_cast<Uint8>(p>>8), static_cast<Uint8>(a)});
+            }
+            mark(cv, y+row, x, x+s.w);
+        }
+    }
+
+    ////////////////
+    // UPLOAD
+    ////////////////
+    bool row_changed(const Canvas* cv, int y)
+    { // Dirty span on row y differs from what the texture has
+        int x0 = cv->dirty_x0[y]; int x1 = cv->dirty_x1[y];
+        if(x0 >= x1) return false;
+        return memcmp(cv->px + y*cv->w + x0, cv->shadow + y*cv->w + x0,
+                (x1-x0)*sizeof(Uint32)) != 0;
+    }
+    template<typename Send>
+    int send_changes(Canvas* cv, Send send)
+    { // Call send(SDL_Rect band) for each band of changed rows. Return rows sent.
+        /* *************DOC***************
+         * Walk the rows. Consecutive changed rows form a band. The band rect covers the
+         * union of the dirty spans in the band. After send(), the destination has
+         * these pixels, so copy them into the shadow buffer.
+         * *******************************/
+        int sent = 0;
+        int y = 0;
+        while(y < cv->h)
+        {
+            if(!(cv->upload_all || row_changed(cv, y))) { y++; continue; }
+            int y0 = y; int x0 = cv->w; int x1 = 0;
+            if(cv->upload_all) { y = cv->h; x0 = 0; x1 = cv->w; }
+            else for(; (y < cv->h) && row_changed(cv, y); y++)
+            { // Grow band while rows keep changing
+                if(cv->dirty_x0[y] < x0) x0 = cv->dirty_x0[y];
+                if(cv->dirty_x1[y] > x1) x1 = cv->dirty_x1[y];
+            }
+            SDL_Rect band{x0, y0, x1-x0, y-y0};
+            send(band);
+            for(int row=y0; row<y; row++)
+            { // Destination has these pixels now
+                memcpy(cv->shadow + row*cv->w + x0, cv->px + row*cv->w + x0,
+                        (x1-x0)*sizeof(Uint32));
+            }
+            sent += y-y0;
+        }
+        for(int row=0; row<cv->h; row++) { cv->dirty_x0[row] = cv->w; cv->dirty_x1[row] = 0; }
+        cv->upload_all = false;
+        cv->rows_uploaded = sent;
+        return sent;
+    }
+    int upload(Canvas* cv, SDL_Texture* tex)
+    { // Send changed rows to tex (RGBA8888 streaming, same size). Return rows sent.
+        return send_changes(cv, [cv, tex](SDL_Rect band)
+        {
+            SDL_UpdateTexture(tex, &band, cv->px + band.y*cv->w + band.x, cv->w*sizeof(Uint32));
+        });
+    }
+}
+
+#endif // __MG_RASTER_H__
@@ -0,0 +1,41 @@
+#include <cstdio>
+#include <cstring>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_raster.h"
+
+void run_tests_for_mg_raster()
+{
+    { // clear() with the same color only dirties what was drawn since the last clear
+        Raster::Canvas cv; TEST(Raster::init(&cv, 16, 8));
+        const SDL_Color bg{10,20,30,255};
+        auto none = [](SDL_Rect){};
+        Raster::clear(&cv, bg);
+        TESTeq(Raster::send_changes(&cv, none), 8);     // First upload : everything
+        Raster::clear(&cv, bg);
+        TESTeq(Raster::send_changes(&cv, none), 0);     // Nothing drawn : nothing to send
+        Raster::fill_rect(&cv, SDL_Rect{2,3,4,2}, SDL_Color{0,255,0,255});
+        TESTeq(Raster::send_changes(&cv, none), 2);
+        Raster::clear(&cv, bg);
+        TESTeq(cv.dirty_x0[3], 2); TESTeq(cv.dirty_x1[3], 6);  // Only the rect is refilled
+        TESTeq(cv.dirty_x0[0], 16);                     // Untouched row stays clean
+        TESTeq(cv.px[3*16 + 2], Raster::pack(bg));
+        TESTeq(Raster::send_changes(&cv, none), 2);     // The rect goes away
+        Raster::clear(&cv, SDL_Color{0,0,0,255});
+        TESTeq(Raster::send_changes(&cv, none), 8);     // New color : every row
+        Raster::destroy(&cv);
+    }
+    { // span_blend() (SSE2 where there is SSE2) matches blend_over() on every pixel
+        Uint32 p[7]; int bad = 0;
+        for(int a=0; a<256; a+=17)
+        for(int d=0; d<256; d+=5)
+        {
+            const SDL_Color c{static_cast<Uint8>(255-d), static_cast<Uint8>(d), 200, static_cast<Uint8>(a)};
+            for(int i=0; i<7; i++) p[i] = 0x01010101u*static_cast<Uint32>(d) ^ (0x3F000000u>>i);
+            Uint32 want[7]; for(int i=0; i<7; i++) want[i] = Raster::blend_over(p[i], c);
+            Raster::span_blend(p, 7, c);
+            if(memcmp(p, want, sizeof(p)) != 0) bad++;
+        }
+        TESTeq(bad, 0);
+    }
+}
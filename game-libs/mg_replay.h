@@ -0,0 +1,241 @@
+#ifndef __MG_REPLAY_H__
+#define __MG_REPLAY_H__
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace Replay
+{ // Record input events to a file, play them back through the same event loop (include SDL.h first)
+    /* *************DOC***************
+     * Replay::poll() replaces SDL_PollEvent() in the event loop:
+     *
+     *      Replay::Session replay;
+     *      Replay::record(&replay, "session.mgr", win);  // or Replay::play(...)
+     *      ...once per loop...
+     *      Replay::tick(&replay, frame_ms);
+     *      SDL_Event e; while(Replay::poll(&replay, &e)) { ...same handling... }
+     *      ...on quit...
+     *      Replay::finish(&replay);
+     *
+     * RECORD : every input event poll() returns is also written to the file, with
+     * the time SDL queued it (since recording started). Events taken off the queue some other way
+     * (SDL_PeepEvents) must be passed to Replay::input() to be recorded.
+     *
+     * PLAY : live keyboard and mouse events are ignored (SDL_EventState). poll()
+     * returns each recorded event once its time comes, as if SDL had just queued
+     * it. The window is resized to match the recording. At the end of the
+     * recording poll() returns SDL_QUIT. Closing the window still quits.
+     *
+     * Time during PLAY:
+     *  - real time   : recorded times are wall-clock times since play() started
+     *  - fast        : each tick() moves the replay clock by frame_ms, so each loop
+     *                  is one frame no matter how long it took (the caller should
+     *                  also step its own clock by frame_ms and not wait for vsync)
+     *
+     * File : a Header, then one Event per input event, little-endian (x86/ARM).
+     * 20 bytes an event, not the 56 of an SDL_Event: only fields the game uses.
+     * *******************************/
+    constexpr Uint32 MAGIC = 0x52474D;                  // "MGR\0" little-endian
+    constexpr Uint32 VERSION = 1;
+    enum Mode { OFF, RECORD, PLAY };
+    enum Type : Uint32 { KEY_DOWN, KEY_UP, MOTION, BUTTON_DOWN, BUTTON_UP, WHEEL, RESIZE, END };
+    struct Header
+    {
+        Uint32 magic, version;
+        Sint32 win_w, win_h;                            // Window size when recording started
+    };
+    struct Event
+    { // Meaning of a, b, c depends on type:
+      // KEY_*    : sym, scancode, mod | repeat<<16
+      // MOTION   : x, y, button state
+      // BUTTON_* : x, y, button | clicks<<8
+      // WHEEL    : x, y, direction
+      // RESIZE   : w, h, -
+        Uint32 t_ms;                                    // Since recording started
+        Uint32 type;
+        Sint32 a, b, c;
+    };
+    struct Session
+    {
+        Mode mode{};
+        bool fast{};                                    // PLAY : fixed time per tick
+        SDL_Window* win{};
+        Uint32 start_ms{};                              // SDL_GetTicks at start
+        FILE* f{};                                      // RECORD : output file
+        Uint32 count{};                                 // Events written or played
+        Event* events{}; Uint32 num_events{};           // PLAY : whole recording
+        double t_ms{};                                  // PLAY : replay clock
+        Sint32 last_x{}, last_y{};                      // PLAY : for motion xrel, yrel
+    };
+    bool fast(const Session* s) { return (s->mode == PLAY) && s->fast; }
+
+    ////////////////
+    // RECORD
+    ////////////////
+    bool to_event(const SDL_Event& e, Uint32 t_ms, Event* out)
+    { // Pack an SDL event. False if it is not an input event.
+        out->t_ms = t_ms; out->a = out->b = out->c = 0;
+        switch(e.type)
+        {
+            case SDL_KEYDOWN:
+            case SDL_KEYUP:
+                out->type = (e.type == SDL_KEYDOWN) ? KEY_DOWN : KEY_UP;
+                out->a = e.key.keysym.sym; out->b = e.key.keysym.scancode;
+                out->c = e.key.keysym.mod | (e.key.repeat<<16);
+                return true;
+            case SDL_MOUSEMOTION:
+                out->type = MOTION;
+                out->a = e.motion.x; out->b = e.motion.y; out->c = static_cast<Sint32>(e.motion.state);
+                return true;
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+                out->type = (e.type == SDL_MOUSEBUTTONDOWN) ? BUTTON_DOWN : BUTTON_UP;
+                out->a = e.button.x; out->b = e.button.y; out->c = e.button.button | (e.button.clicks<<8);
+                return true;
+            case SDL_MOUSEWHEEL:
+                out->type = WHEEL;
+                out->a = e.wheel.x; out->b = e.wheel.y; out->c = static_cast<Sint32>(e.wheel.direction);
+                return true;
+            case SDL_WINDOWEVENT:
+                if(e.window.event != SDL_WINDOWEVENT_SIZE_CHANGED) return false;
+                out->type = RESIZE;
+                out->a = e.window.data1; out->b = e.window.data2;
+                return true;
+            default: return false;
+        }
+    }
+    void input(Session* s, const SDL_Event& e)
+    { // RECORD : write e if it is an input event. Other modes : nothing.
+        if(s->mode != RECORD) return;
+        // Time SDL queued it, not now : SDL_PeepEvents drains a burst at once
+        Uint32 t_ms = (e.common.timestamp > s->start_ms) ? e.common.timestamp - s->start_ms : 0;
+        Event ev;
+        if(!to_event(e, t_ms, &ev)) return;
+        fwrite(&ev, sizeof(ev), 1, s->f);               // stdio buffers this
+        s->count++;
+    }
+    bool record(Session* s, const char* path, SDL_Window* win)
+    { // Start recording to path. False if the file cannot be written.
+        s->f = fopen(path, "wb");
+        if(s->f == NULL) return false;
+        Header h{MAGIC, VERSION, 0, 0};
+        SDL_GetWindowSize(win, &h.win_w, &h.win_h);
+        fwrite(&h, sizeof(h), 1, s->f);
+        s->mode = RECORD; s->win = win; s->count = 0;
+        s->start_ms = SDL_GetTicks();
+        return true;
+    }
+
+    ////////////////
+    // PLAY
+    ////////////////
+    bool play(Session* s, const char* path, SDL_Window* win, bool fast)
+    { // Load recording at path and start playing it. False if it is missing or bad.
+        FILE* f = fopen(path, "rb");
+        if(f == NULL) return false;
+        Header h;
+        fseek(f, 0, SEEK_END); long size = ftell(f); fseek(f, 0, SEEK_SET);
+        if(  (size < static_cast<long>(sizeof(h)))
+          || (fread(&h, sizeof(h), 1, f) != 1)
+          || (h.magic != MAGIC) || (h.version != VERSION)
+          ) { fclose(f); return false; }
+        Uint32 n = static_cast<Uint32>((size - sizeof(h))/sizeof(Event));
+        s->events = (Event*)malloc((n ? n : 1)*sizeof(Event));
+        if(s->events == NULL) { fclose(f); return false; }
+        s->num_events = static_cast<Uint32>(fread(s->events, sizeof(Event), n, f));
+        fclose(f);
+        { // Live input would fight the recording
+            const Uint32 ignore[] = {SDL_KEYDOWN, SDL_KEYUP, SDL_TEXTINPUT, SDL_TEXTEDITING,
+                SDL_MOUSEMOTION, SDL_MOUSEBUTTONDOWN, SDL_MOUSEBUTTONUP, SDL_MOUSEWHEEL};
+            for(Uint32 type : ignore) SDL_EventState(type, SDL_IGNORE);
+        }
+        SDL_SetWindowSize(win, h.win_w, h.win_h);       // Mouse x,y are window coordinates
+        s->mode = PLAY; s->fast = fast; s->win = win; s->count = 0;
+        s->t_ms = 0; s->start_ms = SDL_GetTicks();
+        return true;
+    }
+    void tick(Session* s, double frame_ms)
+    { // Call once per loop : move the replay clock
+        if(s->mode != PLAY) return;
+        if(s->fast) s->t_ms += frame_ms;
+        else        s->t_ms = SDL_GetTicks() - s->start_ms;
+    }
+    void to_sdl(Session* s, const Event& ev, SDL_Event* e)
+    { // Unpack a recorded event as if SDL just queued it
+        SDL_zerop(e);
+        Uint32 timestamp = s->fast ? SDL_GetTicks() : s->start_ms + ev.t_ms;
+        Uint32 win_id = SDL_GetWindowID(s->win);
+        switch(ev.type)
+        {
+            case KEY_DOWN:
+            case KEY_UP:
+                e->type = (ev.type == KEY_DOWN) ? SDL_KEYDOWN : SDL_KEYUP;
+                e->key.windowID = win_id;
+                e->key.state = (ev.type == KEY_DOWN) ? SDL_PRESSED : SDL_RELEASED;
+                e->key.repeat = static_cast<Uint8>(ev.c>>16);
+                e->key.keysym.sym = ev.a;
+                e->key.keysym.scancode = static_cast<SDL_Scancode>(ev.b);
+                e->key.keysym.mod = static_cast<Uint16>(ev.c & 0xFFFF);
+                break;
+            case MOTION:
+                e->type = SDL_MOUSEMOTION;
+                e->motion.windowID = win_id;
+                e->motion.state = static_cast<Uint32>(ev.c);
+                e->motion.x = ev.a; e->motion.y = ev.b;
+                e->motion.xrel = ev.a - s->last_x; e->motion.yrel = ev.b - s->last_y;
+                s->last_x = ev.a; s->last_y = ev.b;
+                break;
+            case BUTTON_DOWN:
+            case BUTTON_UP:
+                e->type = (ev.type == BUTTON_DOWN) ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+                e->button.windowID = win_id;
+                e->button.state = (ev.type == BUTTON_DOWN) ? SDL_PRESSED : SDL_RELEASED;
+                e->button.button = static_cast<Uint8>(ev.c & 0xFF);
+                e->button.clicks = static_cast<Uint8>(ev.c>>8);
+                e->button.x = ev.a; e->button.y = ev.b;
+                break;
+            case WHEEL:
+                e->type = SDL_MOUSEWHEEL;
+                e->wheel.windowID = win_id;
+                e->wheel.x = ev.a; e->wheel.y = ev.b;
+                e->wheel.direction = static_cast<Uint32>(ev.c);
+                break;
+            case RESIZE:
+                SDL_SetWindowSize(s->win, ev.a, ev.b);  // Game reads the size back from the window
+                e->type = SDL_WINDOWEVENT;
+                e->window.windowID = win_id;
+                e->window.event = SDL_WINDOWEVENT_SIZE_CHANGED;
+                e->window.data1 = ev.a; e->window.data2 = ev.b;
+                break;
+            default:                                    // END
+                e->type = SDL_QUIT;
+                break;
+        }
+        e->common.timestamp = timestamp;
+    }
+    bool poll(Session* s, SDL_Event* e)
+    { // SDL_PollEvent, plus recording or playback
+        if((s->mode == PLAY) && (s->count < s->num_events) && (s->events[s->count].t_ms <= s->t_ms))
+        { // Next recorded event is due
+            to_sdl(s, s->events[s->count++], e);
+            return true;
+        }
+        if(!SDL_PollEvent(e)) return false;
+        input(s, *e);
+        return true;
+    }
+    void finish(Session* s)
+    { // RECORD : end the recording here and close the file. PLAY : free the recording.
+        if(s->f)
+        {
+            Event end{SDL_GetTicks() - s->start_ms, END, 0, 0, 0};
+            fwrite(&end, sizeof(end), 1, s->f);
+            fclose(s->f);
+            s->f = NULL;
+        }
+        free(s->events); s->events = NULL; s->num_events = 0;
+        s->mode = OFF;
+    }
+}
+
+#endif // __MG_REPLAY_H__
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_replay.h"
+
+namespace ReplayTests
+{
+    const char* PATH = "mg_replay_tests.mgr";           // Removed when done
+    SDL_Event motion(Uint32 timestamp, Sint32 x)
+    {
+        SDL_Event e{};
+        e.type = SDL_MOUSEMOTION;
+        e.common.timestamp = timestamp;
+        e.motion.x = x; e.motion.y = 1;
+        return e;
+    }
+}
+
+void run_tests_for_mg_replay()
+{
+    using namespace ReplayTests;
+    { // Two events drained together (SDL_PeepEvents) keep the times SDL queued them
+        Replay::Session rec;
+        TEST(Replay::record(&rec, PATH, NULL));
+        SDL_Event batch[2] = {motion(rec.start_ms + 10, 5), motion(rec.start_ms + 40, 7)};
+        for(const SDL_Event& e : batch) Replay::input(&rec, e);
+        Replay::input(&rec, motion(rec.start_ms - 1, 3));  // Queued before recording : time 0
+        TESTeq(rec.count, 3u);
+        Replay::finish(&rec);
+
+        Replay::Session play;
+        TEST(Replay::play(&play, PATH, NULL, true));
+        TESTeq(play.num_events, 4u);                    // 3 events and END
+        TESTeq(play.events[0].t_ms, 10u);
+        TESTeq(play.events[1].t_ms, 40u);
+        TESTeq(play.events[2].t_ms, 0u);
+        SDL_Event e;
+        Replay::tick(&play, 16);                        // Frame 1 : only the first is due
+        TEST(Replay::poll(&play, &e));
+        TESTeq(e.motion.x, 5);
+        TESTeq(play.count, 1u);
+        TEST(play.events[play.count].t_ms > play.t_ms);
+        Replay::tick(&play, 16); Replay::tick(&play, 16);   // Frame 3 : 48 ms, second is due
+        TEST(Replay::poll(&play, &e));
+        TESTeq(e.motion.x, 7);
+        TESTeq(e.motion.xrel, 2);
+        Replay::finish(&play);
+        for(Uint32 type : {SDL_KEYDOWN, SDL_KEYUP, SDL_TEXTINPUT, SDL_TEXTEDITING,
+                SDL_MOUSEMOTION, SDL_MOUSEBUTTONDOWN, SDL_MOUSEBUTTONUP, SDL_MOUSEWHEEL})
+            SDL_EventState(type, SDL_ENABLE);           // play() ignored live input
+    }
+    remove(PATH);
+}
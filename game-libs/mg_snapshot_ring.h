@@ -0,0 +1,70 @@
+#ifndef __MG_SNAPSHOT_RING_H__
+#define __MG_SNAPSHOT_RING_H__
+
+#include <atomic>
+
+namespace SnapshotRing
+{ // Audio thread writes samples, UI thread copies the latest N (include SDL.h first)
+    /* *************DOC***************
+     * One writer (audio callback), any number of readers (UI).
+     *
+     * The writer never waits: it publishes how far it is about to write (writing),
+     * copies samples into the ring, then publishes the new total (written). There is
+     * no lock for the audio thread to block on.
+     *
+     * The reader copies the latest n samples, then checks writing. If the writer
+     * lapped the part of the ring the reader was copying, or is in the middle of a
+     * block that reaches it, the copy is torn and read_latest() returns false. The
+     * reader just tries again next frame.
+     *
+     *      written (total samples ever written)
+     *          ↓
+     *      ... [oldest ............ newest] ...
+     *              ↑ written - n
+     *
+     * SIZE must be a power of two and bigger than n + one device buffer of samples,
+     * so the writer can write a whole buffer while the reader is copying.
+     * *******************************/
+    constexpr Uint32 SIZE = 1<<14;                      // Samples in ring
+    constexpr Uint32 MASK = SIZE-1;
+    struct Ring
+    {
+        Sint16 buf[SIZE]{};
+        std::atomic<Uint32> written{0};                 // Total samples written (wraps)
+        std::atomic<Uint32> writing{0};                 // written + the block being copied in
+    };
+
+    Uint32 begin_write(Ring* r, Uint32 n)
+    { // Audio thread : about to write n samples. Return where they go (mask it).
+        Uint32 w = r->written.load(std::memory_order_relaxed);
+        r->writing.store(w+n, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);  // Before any sample of the block
+        return w;
+    }
+    void end_write(Ring* r, Uint32 n)
+    { // Audio thread : the n samples are in
+        r->written.store(r->written.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+    void write_le16(Ring* r, const Uint8* bytes, Uint32 n)
+    { // Audio thread : append n 16-bit little-endian samples
+        Uint32 w = begin_write(r, n);
+        for(Uint32 i=0; i<n; i++)
+        {
+            r->buf[(w+i)&MASK] = static_cast<Sint16>(bytes[2*i] | (bytes[2*i+1]<<8));
+        }
+        end_write(r, n);
+    }
+    bool read_latest(const Ring* r, Sint16* out, Uint32 n)
+    { // UI thread : copy the latest n samples, oldest first. False if torn or not enough yet.
+        SDL_assert(n < SIZE);
+        Uint32 w0 = r->written.load(std::memory_order_acquire);
+        if(w0 < n) return false;                        // Not enough yet (or counter just wrapped)
+        Uint32 start = w0 - n;
+        for(Uint32 i=0; i<n; i++) out[i] = r->buf[(start+i)&MASK];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        Uint32 w1 = r->writing.load(std::memory_order_relaxed);  // Includes a block not yet published
+        return (w1 - w0) <= (SIZE - n);                 // Writer did not reach what I copied
+    }
+}
+
+#endif // __MG_SNAPSHOT_RING_H__
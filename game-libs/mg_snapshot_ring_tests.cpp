@@ -0,0 +1,47 @@
+#include <cstdio>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_snapshot_ring.h"
+
+namespace SnapshotRingTests
+{
+    SnapshotRing::Ring ring;
+    Sint16 out[SnapshotRing::SIZE];
+    Uint8 bytes[2*SnapshotRing::SIZE];
+    void write_ramp(Uint32 n)
+    { // Next n samples of 0, 1, 2, ...
+        static Uint32 next = 0;
+        for(Uint32 i=0; i<n; i++, next++) { bytes[2*i] = static_cast<Uint8>(next & 0xFF); bytes[2*i+1] = static_cast<Uint8>((next>>8) & 0x7F); }
+        SnapshotRing::write_le16(&ring, bytes, n);
+    }
+}
+
+void run_tests_for_mg_snapshot_ring()
+{
+    using namespace SnapshotRingTests;
+    constexpr Uint32 N = 1024;
+    TEST(!SnapshotRing::read_latest(&ring, out, N));    // Not enough yet
+    write_ramp(N + 10);
+    { // Latest N samples, oldest first
+        TEST(SnapshotRing::read_latest(&ring, out, N));
+        TESTeq(out[0], 10);
+        TESTeq(out[N-1], static_cast<Sint16>(N + 9));
+    }
+    { // Block in progress, not yet published, that does not reach what the reader copies
+        SnapshotRing::begin_write(&ring, SnapshotRing::SIZE - N);
+        TEST(SnapshotRing::read_latest(&ring, out, N));
+        SnapshotRing::end_write(&ring, SnapshotRing::SIZE - N);
+    }
+    { // Block in progress that overwrites what the reader copies : torn
+        Uint32 w = SnapshotRing::begin_write(&ring, SnapshotRing::SIZE - N + 1);
+        ring.buf[(w + SnapshotRing::SIZE - N)&SnapshotRing::MASK] = -1;  // Writer got this far
+        TEST(!SnapshotRing::read_latest(&ring, out, N));
+        SnapshotRing::end_write(&ring, SnapshotRing::SIZE - N + 1);
+    }
+    { // Next whole block : reads are good again
+        write_ramp(N);
+        TEST(SnapshotRing::read_latest(&ring, out, N));
+        TESTeq(out[0], static_cast<Sint16>(N + 10));
+        TESTeq(out[N-1], static_cast<Sint16>(2*N + 9));
+    }
+}
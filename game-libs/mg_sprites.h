@@ -0,0 +1,269 @@
+#ifndef __MG_SPRITES_H__
+#define __MG_SPRITES_H__
+
+namespace Sprites
+{ // Sprites and tilemaps from one atlas, one draw call per layer (include SDL.h, mg_draw_list.h, mg_raster.h first)
+    /* *************DOC***************
+     * Sheet : every sprite image packed into one RGBA8888 atlas at load time. A
+     * shelf packer places images left to right on a shelf as tall as its tallest
+     * image, then starts a new shelf underneath. Add images tallest first to waste
+     * less room. The pixels stay in memory for the CPU raster backend; the texture
+     * (make_texture) is for SDL_RenderGeometry.
+     *
+     * Layer : a flat array of Sprite (position, image, tint).
+     * Tilemap : one byte per tile (0 is empty), in chunks of CHUNK x CHUNK tiles.
+     * Each chunk counts its tiles, so empty chunks cost nothing.
+     *
+     * draw() culls against the view (what GameArt shows, in world pixels):
+     *  - tilemap : only chunks that overlap the view
+     *  - layer   : only sprites that overlap the view
+     * With a DrawList painter the whole layer is one SDL_RenderGeometry call (as
+     * long as the list has room). With a Raster::Canvas it is blit() per sprite.
+     *
+     *      Sprites::Sheet sheet; Sprites::init(&sheet, 256, 256);
+     *      int ghost = Sprites::add(&sheet, px, 8, 8, 8);
+     *      sheet.tex = Sprites::make_texture(&sheet, ren);
+     *      Sprites::Layer actors; Sprites::init(&actors, 20000);
+     *      Sprites::add(&actors, ghost, 10, 20);
+     *      ...every frame...
+     *      Sprites::draw(&dl, &sheet, &map, view);     // Background
+     *      Sprites::draw(&dl, &sheet, &actors, view);  // On top
+     * *******************************/
+    constexpr int MAX_IMAGES = 256;
+    constexpr int PAD = 1;                              // Clear pixels between images
+    constexpr int CHUNK = 16;                           // Tiles per chunk side
+    struct Sheet
+    {
+        Uint32* px{};                                   // w*h pixels, RGBA8888
+        int w{}, h{};
+        SDL_Rect image[MAX_IMAGES]{};                   // Where each image is in px
+        SDL_FPoint uv0[MAX_IMAGES]{}, uv1[MAX_IMAGES]{};// Same, as texture coordinates
+        int num{};
+        int shelf_x{}, shelf_y{}, shelf_h{};            // Packer : room left on this shelf
+        SDL_Texture* tex{};                             // DrawList painter draws with this
+    };
+    struct Sprite
+    {
+        float x, y;                                     // Top-left, world pixels
+        Uint16 image;
+        SDL_Color tint;                                 // White : as drawn
+    };
+    struct Layer
+    {
+        Sprite* sprites{};
+        int num{}, max{};
+        int drawn{};                                    // Sprites that passed culling last draw
+    };
+    struct Tilemap
+    {
+        Uint8* tiles{};                                 // w*h, 0 : empty
+        Uint16* chunk_tiles{};                          // Tiles in each chunk
+        int w{}, h{};                                   // Size in tiles
+        int tile_w{}, tile_h{};                         // Tile size in pixels
+        int chunks_w{}, chunks_h{};
+        int tileset[256]{};                             // Tile value : sheet image
+        int drawn{};                                    // Chunks that passed culling last draw
+    };
+
+    ////////////////
+    // SHEET
+    ////////////////
+    bool init(Sheet* s, int w, int h)
+    { // Allocate a clear w x h atlas. Return false if out of memory.
+        *s = Sheet{};
+        s->px = (Uint32*)calloc(w*h, sizeof(Uint32));
+        if(s->px == NULL) return false;
+        s->w = w; s->h = h;
+        return true;
+    }
+    void destroy(Sheet* s)
+    { // Frees the pixels. The texture belongs to whoever made it.
+        free(s->px); s->px = NULL;
+        s->num = 0;
+    }
+    bool pack(Sheet* s, int w, int h, SDL_Rect* r)
+    { // Shelf packer : place w x h on this shelf, or on a new one underneath
+        int x = s->shelf_x; int y = s->shelf_y; int shelf_h = s->shelf_h;
+        if(x + w > s->w) { y += shelf_h + PAD; x = 0; shelf_h = 0; }
+        if((w > s->w) || (y + h > s->h)) return false; // Full : nothing changes
+        *r = SDL_Rect{x, y, w, h};
+        s->shelf_x = x + w + PAD; s->shelf_y = y;
+        s->shelf_h = (h > shelf_h) ? h : shelf_h;
+        return true;
+    }
+    int add(Sheet* s, const Uint32* px, int w, int h, int pitch)
+    { // Copy a w x h image (RGBA8888, pitch pixels per row) into the atlas. Return its id, -1 if full.
+        if(s->num == MAX_IMAGES) return -1;
+        SDL_Rect r;
+        if(!pack(s, w, h, &r)) return -1;
+        for(int y=0; y<h; y++) memcpy(s->px + (r.y+y)*s->w + r.x, px + y*pitch, w*sizeof(Uint32));
+        int id = s->num++;
+        s->image[id] = r;
+        s->uv0[id] = SDL_FPoint{static_cast<float>(r.x)/s->w, static_cast<float>(r.y)/s->h};
+        s->uv1[id] = SDL_FPoint{static_cast<float>(r.x+w)/s->w, static_cast<float>(r.y+h)/s->h};
+        return id;
+    }
+    SDL_Texture* make_texture(const Sheet* s, SDL_Renderer* ren)
+    { // Upload the atlas. NULL on SDL error.
+        SDL_Texture* tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, s->w, s->h);
+        if(tex == NULL) return NULL;
+        if(  (SDL_UpdateTexture(tex, NULL, s->px, s->w*sizeof(Uint32)) < 0)
+          || (SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND) < 0)
+          ) { SDL_DestroyTexture(tex); return NULL; }
+        return tex;
+    }
+
+    ////////////////
+    // LAYER
+    ////////////////
+    bool init(Layer* l, int max)
+    {
+        *l = Layer{};
+        l->sprites = (Sprite*)malloc(max*sizeof(Sprite));
+        if(l->sprites == NULL) return false;
+        l->max = max;
+        return true;
+    }
+    void destroy(Layer* l)
+    {
+        free(l->sprites); l->sprites = NULL;
+        l->num = l->max = 0;
+    }
+    Sprite* add(Layer* l, int image, float x, float y)
+    { // NULL if the layer is full
+        if(l->num == l->max) return NULL;
+        Sprite* sp = &l->sprites[l->num++];
+        *sp = Sprite{x, y, static_cast<Uint16>(image), SDL_Color{255,255,255,255}};
+        return sp;
+    }
+
+    ////////////////
+    // TILEMAP
+    ////////////////
+    void destroy(Tilemap* m)
+    {
+        free(m->tiles); m->tiles = NULL;
+        free(m->chunk_tiles); m->chunk_tiles = NULL;
+    }
+    bool init(Tilemap* m, int w, int h, int tile_w, int tile_h)
+    { // Empty map of w x h tiles. Return false if out of memory.
+        *m = Tilemap{};
+        m->chunks_w = (w+CHUNK-1)/CHUNK; m->chunks_h = (h+CHUNK-1)/CHUNK;
+        m->tiles = (Uint8*)calloc(w*h, 1);
+        m->chunk_tiles = (Uint16*)calloc(m->chunks_w*m->chunks_h, sizeof(Uint16));
+        if((m->tiles == NULL) || (m->chunk_tiles == NULL)) { destroy(m); return false; }
+        m->w = w; m->h = h;
+        m->tile_w = tile_w; m->tile_h = tile_h;
+        return true;
+    }
+    Uint8 get(const Tilemap* m, int x, int y)
+    { // 0 outside the map
+        if((x < 0) || (y < 0) || (x >= m->w) || (y >= m->h)) return 0;
+        return m->tiles[y*m->w + x];
+    }
+    void set(Tilemap* m, int x, int y, Uint8 v)
+    { // Tile value v (0 : empty) at tile x,y
+        if((x < 0) || (y < 0) || (x >= m->w) || (y >= m->h)) return;
+        Uint8* t = &m->tiles[y*m->w + x];
+        Uint16* n = &m->chunk_tiles[(y/CHUNK)*m->chunks_w + x/CHUNK];
+        if(*t && !v) (*n)--;
+        if(!*t && v) (*n)++;
+        *t = v;
+    }
+    int floor_div(int a, int b) { return (a >= 0) ? a/b : -((b-1-a)/b); }
+
+    ////////////////
+    // PAINTERS
+    ////////////////
+    struct Batch
+    { // Painter state to put back after a layer
+        SDL_Texture* tex;
+        SDL_BlendMode blend;
+    };
+    bool layer_begin(DrawList::List* dl, const Sheet* s, Batch* was)
+    { // One batch for the layer : flush what came before, switch to the atlas
+        if(s->tex == NULL) return false;
+        *was = Batch{dl->tex, dl->blend};
+        DrawList::set_state(dl, s->tex, SDL_BLENDMODE_BLEND);
+        return true;
+    }
+    void layer_end(DrawList::List* dl, Batch was)
+    {
+        DrawList::set_state(dl, was.tex, was.blend);    // Draws the layer
+    }
+    void image(DrawList::List* dl, const Sheet* s, int id, int x, int y, SDL_Color tint)
+    {
+        const float l = static_cast<float>(x);  const float r = static_cast<float>(x + s->image[id].w);
+        const float t = static_cast<float>(y);  const float b = static_cast<float>(y + s->image[id].h);
+        const SDL_FPoint u0 = s->uv0[id];       const SDL_FPoint u1 = s->uv1[id];
+        const SDL_FPoint p[4] = {{l,t}, {r,t}, {r,b}, {l,b}};
+        const SDL_FPoint uv[4] = {{u0.x,u0.y}, {u1.x,u0.y}, {u1.x,u1.y}, {u0.x,u1.y}};
+        DrawList::quad(dl, p, uv, tint);
+    }
+    bool layer_begin(Raster::Canvas*, const Sheet* s, Batch*) { return s->px != NULL; }
+    void layer_end(Raster::Canvas*, Batch) {}
+    void image(Raster::Canvas* cv, const Sheet* s, int id, int x, int y, SDL_Color tint)
+    {
+        Raster::blit(cv, s->px, s->w, s->image[id], x, y, tint);
+    }
+
+    ////////////////
+    // DRAW
+    ////////////////
+    template<typename Painter>
+    int draw(Painter* p, const Sheet* s, Layer* l, SDL_Rect view)
+    { // Sprites that overlap view, offset by view x,y. Return sprites drawn.
+        Batch was;
+        l->drawn = 0;
+        if(!layer_begin(p, s, &was)) return 0;
+        for(int i=0; i<l->num; i++)
+        {
+            const Sprite& sp = l->sprites[i];
+            const SDL_Rect& r = s->image[sp.image];
+            // Snap to whole pixels : both painters put the sprite on the same pixels
+            int x = static_cast<int>(SDL_floorf(sp.x)) - view.x;
+            int y = static_cast<int>(SDL_floorf(sp.y)) - view.y;
+            if((x >= view.w) || (y >= view.h) || (x + r.w <= 0) || (y + r.h <= 0)) continue;
+            image(p, s, sp.image, x, y, sp.tint);
+            l->drawn++;
+        }
+        layer_end(p, was);
+        return l->drawn;
+    }
+    template<typename Painter>
+    int draw(Painter* p, const Sheet* s, Tilemap* m, SDL_Rect view)
+    { // Chunks that overlap view and have tiles, offset by view x,y. Return chunks drawn.
+        Batch was;
+        m->drawn = 0;
+        if(!layer_begin(p, s, &was)) return 0;
+        const int cw = CHUNK*m->tile_w; const int ch = CHUNK*m->tile_h;
+        int cx0 = floor_div(view.x, cw);            int cy0 = floor_div(view.y, ch);
+        int cx1 = floor_div(view.x+view.w-1, cw);   int cy1 = floor_div(view.y+view.h-1, ch);
+        if(cx0 < 0) cx0 = 0;
+        if(cy0 < 0) cy0 = 0;
+        if(cx1 >= m->chunks_w) cx1 = m->chunks_w-1;
+        if(cy1 >= m->chunks_h) cy1 = m->chunks_h-1;
+        const SDL_Color white{255,255,255,255};
+        for(int cy=cy0; cy<=cy1; cy++)
+        for(int cx=cx0; cx<=cx1; cx++)
+        {
+            if(m->chunk_tiles[cy*m->chunks_w + cx] == 0) continue;
+            int tx1 = (cx+1)*CHUNK; if(tx1 > m->w) tx1 = m->w;
+            int ty1 = (cy+1)*CHUNK; if(ty1 > m->h) ty1 = m->h;
+            for(int ty=cy*CHUNK; ty<ty1; ty++)
+            {
+                const Uint8* row = m->tiles + ty*m->w;
+                for(int tx=cx*CHUNK; tx<tx1; tx++)
+                {
+                    if(row[tx] == 0) continue;
+                    image(p, s, m->tileset[row[tx]], tx*m->tile_w - view.x, ty*m->tile_h - view.y, white);
+                }
+            }
+            m->drawn++;
+        }
+        layer_end(p, was);
+        return m->drawn;
+    }
+}
+
+#endif // __MG_SPRITES_H__
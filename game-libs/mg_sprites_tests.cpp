@@ -0,0 +1,118 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_draw_list.h"
+#include "mg_raster.h"
+#include "mg_sprites.h"
+
+namespace SpritesTests
+{
+    Uint32 img[8*8];
+    void fill(Uint32 v) { for(Uint32& p : img) p = v; }
+    bool overlap(SDL_Rect a, SDL_Rect b)
+    {
+        return (a.x < b.x+b.w) && (b.x < a.x+a.w) && (a.y < b.y+b.h) && (b.y < a.y+a.h);
+    }
+}
+
+void run_tests_for_mg_sprites()
+{
+    using namespace SpritesTests;
+    { // Shelf packer : left to right, new shelf when the row is full, -1 when the sheet is
+        Sprites::Sheet s; TEST(Sprites::init(&s, 20, 20));
+        fill(0x11223344); TESTeq(Sprites::add(&s, img, 8, 8, 8), 0);
+        fill(0x55667788); TESTeq(Sprites::add(&s, img, 8, 5, 8), 1);
+        TESTeq(Sprites::add(&s, img, 8, 8, 8), 2);      // Shelf 0 is full : new shelf
+        TESTeq(s.image[1].x, 9);
+        TESTeq(s.image[2].y, 9);                        // Under the tallest, plus PAD
+        TESTeq(Sprites::add(&s, img, 12, 3, 12), -1);   // Too wide for what is left, no room below
+        TESTeq(Sprites::add(&s, img, 3, 3, 3), 3);      // Still fits on shelf 1
+        bool apart = true;
+        for(int i=0; i<s.num; i++) for(int j=i+1; j<s.num; j++) apart = apart && !overlap(s.image[i], s.image[j]);
+        TEST(apart);
+        TESTeq(s.px[0], 0x11223344);                    // Pixels copied to their place
+        TESTeq(s.px[4*s.w + 9+7], 0x55667788);
+        TESTeq(s.px[8], 0);                             // PAD stays clear
+        TESTnear(s.uv1[0].x, 8/20.0f, 1e-6f);
+        Sprites::destroy(&s);
+    }
+    { // Raster : clear pixels skipped, opaque copied, partial blended, tint multiplies, clips
+        Raster::Canvas cv; TEST(Raster::init(&cv, 4, 4));
+        Raster::clear(&cv, SDL_Color{0,0,0,255});
+        const Uint32 src[2*2] = {0x00000000, 0xFF0000FF, 0xFFFFFF80, 0x204060FF};
+        Raster::blit(&cv, src, 2, SDL_Rect{0,0,2,2}, 0, 0, SDL_Color{255,255,255,255});
+        TESTeq(cv.px[0], 0x000000FF);                   // Clear : canvas shows through
+        TESTeq(cv.px[1], 0xFF0000FF);
+        TESTeq(cv.px[4] >> 24, 0x80);                   // Half white over black
+        Raster::blit(&cv, src, 2, SDL_Rect{0,0,2,2}, 2, 3, SDL_Color{255,0,255,255});
+        TESTeq(cv.px[15], 0xFF0000FF);                  // Bottom row clipped off
+        Raster::blit(&cv, src, 2, SDL_Rect{0,0,2,2}, -1, 2, SDL_Color{128,128,128,255});
+        TESTeq(cv.px[2*4], 0x800000FF);                 // src x=1 lands at x=0, tinted
+        TESTeq(cv.px[3*4], 0x102030FF);
+        Raster::destroy(&cv);
+    }
+    Sprites::Sheet s; Sprites::init(&s, 32, 32);
+    fill(0xFFFFFFFF); const int tile = Sprites::add(&s, img, 8, 8, 8);
+    { // Tilemap : only chunks in view that have tiles
+        Sprites::Tilemap m; TEST(Sprites::init(&m, 64, 64, 8, 8)); // 4 x 4 chunks of 128 px
+        m.tileset[1] = tile;
+        Sprites::set(&m, 3, 3, 1);
+        Sprites::set(&m, 60, 60, 1);
+        Sprites::set(&m, 61, 60, 1);
+        TESTeq(m.chunk_tiles[0], 1);
+        TESTeq(m.chunk_tiles[15], 2);
+        Sprites::set(&m, 61, 60, 0);
+        Sprites::set(&m, 61, 60, 0);                    // Already empty : count stays
+        TESTeq(m.chunk_tiles[15], 1);
+        TESTeq(Sprites::get(&m, 60, 60), 1);
+        TESTeq(Sprites::get(&m, -1, 60), 0);
+        Raster::Canvas cv; Raster::init(&cv, 320, 180);
+        TESTeq(Sprites::draw(&cv, &s, &m, SDL_Rect{0, 0, 320, 180}), 1);     // 6 chunks in view, 1 has tiles
+        TESTeq(cv.px[3*8*320 + 3*8], 0xFFFFFFFF);
+        TESTeq(Sprites::draw(&cv, &s, &m, SDL_Rect{200, 300, 320, 180}), 1);
+        TESTeq(Sprites::draw(&cv, &s, &m, SDL_Rect{-500, -500, 320, 180}), 0);  // Off the map
+        Sprites::set(&m, 60, 60, 0);
+        TESTeq(Sprites::draw(&cv, &s, &m, SDL_Rect{200, 300, 320, 180}), 0);   // Chunk in view is empty
+        Raster::destroy(&cv);
+        Sprites::destroy(&m);
+    }
+    { // Layer : sprites out of view are skipped
+        Sprites::Layer l; TEST(Sprites::init(&l, 4));
+        Sprites::add(&l, tile, 0, 0);
+        Sprites::add(&l, tile, -7, 10);                 // One pixel column in view
+        Sprites::add(&l, tile, -8, 10);                 // Just out
+        Sprites::add(&l, tile, 320, 0);                 // Just out
+        TEST(Sprites::add(&l, tile, 1, 1) == NULL);     // Full
+        Raster::Canvas cv; Raster::init(&cv, 320, 180);
+        TESTeq(Sprites::draw(&cv, &s, &l, SDL_Rect{0, 0, 320, 180}), 2);
+        TESTeq(Sprites::draw(&cv, &s, &l, SDL_Rect{0, 0, 321, 180}), 3);
+        Raster::destroy(&cv);
+        Sprites::destroy(&l);
+    }
+    { // DrawList : 20k sprites are one SDL_RenderGeometry call, then the painter is as it was
+        SDL_Surface* screen = SDL_CreateRGBSurfaceWithFormat(0, 320, 180, 32, SDL_PIXELFORMAT_RGBA8888);
+        SDL_Renderer* ren = screen ? SDL_CreateSoftwareRenderer(screen) : NULL;
+        s.tex = ren ? Sprites::make_texture(&s, ren) : NULL;
+        if(s.tex == NULL) Tests::note("SKIP mg_sprites DrawList : no software renderer (%s)", SDL_GetError());
+        else
+        {
+            Sprites::Layer l; Sprites::init(&l, 20000);
+            for(int i=0; i<20000; i++) Sprites::add(&l, tile, static_cast<float>(i%312), static_cast<float>(i%172));
+            DrawList::List dl; DrawList::init(&dl, 1<<15);
+            DrawList::begin(&dl, ren, SDL_BLENDMODE_ADD);
+            DrawList::fill_rect(&dl, SDL_Rect{0,0,4,4}, SDL_Color{255,0,0,255});
+            TESTeq(Sprites::draw(&dl, &s, &l, SDL_Rect{0, 0, 320, 180}), 20000);
+            TESTeq(dl.num_calls, 2);                    // What came before, then the layer
+            TEST(dl.tex == NULL);
+            TESTeq(dl.blend, SDL_BLENDMODE_ADD);
+            DrawList::destroy(&dl);
+            Sprites::destroy(&l);
+            SDL_DestroyTexture(s.tex);
+        }
+        if(ren) SDL_DestroyRenderer(ren);
+        if(screen) SDL_FreeSurface(screen);
+    }
+    Sprites::destroy(&s);
+}
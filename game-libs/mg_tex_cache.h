@@ -0,0 +1,150 @@
+#ifndef __MG_TEX_CACHE_H__
+#define __MG_TEX_CACHE_H__
+
+namespace TexCache
+{ // Own every texture the renderer makes, remake them lazily after a reset (include SDL.h first)
+    /* *************DOC***************
+     * Textures are entries, not pointers. Ask for the texture every frame:
+     *
+     *      TexCache::Cache cache; TexCache::init(&cache, ren);
+     *      int art = TexCache::add(&cache, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+     *                  SDL_BLENDMODE_BLEND, w, h);
+     *      int atlas = TexCache::add(&cache, make_atlas, data);     // Built from data
+     *      ...every frame...
+     *      TexCache::size(&cache, art, w, h);      // Only if the size can change
+     *      SDL_Texture* tex = TexCache::get(&cache, art);
+     *      if(TexCache::redraw(&cache, art)) ...contents are gone, draw all of it...
+     *
+     * get() makes the texture if there is none : at first use, after
+     * device_reset(), or when size() outgrew it. NULL if SDL cannot make it.
+     *
+     * Blank textures never shrink. size() only makes a new texture when the size
+     * outgrows the one it has, and then with room to spare (half again, up to the
+     * renderer's max), so dragging a window edge does not make a texture per
+     * frame. Draw into and copy from the top-left w x h.
+     *
+     * SDL events:
+     *  - SDL_RENDER_TARGETS_RESET : render targets lost their contents.
+     *    targets_reset() : redraw() is true once for every TARGET texture.
+     *  - SDL_RENDER_DEVICE_RESET : every texture is gone.
+     *    device_reset() : all of them are remade at the next get().
+     * *******************************/
+    constexpr int MAX_ENTRIES = 16;
+    typedef SDL_Texture* (*Make)(SDL_Renderer* ren, void* data);
+    struct Entry
+    {
+        Make make{};                                    // NULL : blank texture
+        void* data{};                                   // Passed to make
+        Uint32 format{};                                // Blank textures
+        int access{};
+        SDL_BlendMode blend{};
+        int w{}, h{};                                   // Size in use
+        int cap_w{}, cap_h{};                           // Size of tex
+        SDL_Texture* tex{};
+        bool lost{};                                    // Contents gone since the last redraw()
+        int made{};                                     // Textures made so far
+    };
+    struct Cache
+    {
+        SDL_Renderer* ren{};
+        int max_w{}, max_h{};                           // Renderer limits (0 : none)
+        Entry entry[MAX_ENTRIES];
+        int num{};
+        int resets{};                                   // Device resets so far
+    };
+    void init(Cache* c, SDL_Renderer* ren)
+    {
+        c->ren = ren;
+        SDL_RendererInfo info;
+        if(SDL_GetRendererInfo(ren, &info) == 0) { c->max_w = info.max_texture_width; c->max_h = info.max_texture_height; }
+    }
+    int add(Cache* c, Uint32 format, int access, SDL_BlendMode blend, int w, int h)
+    { // Blank texture. Return its id, -1 if the cache is full.
+        if(c->num == MAX_ENTRIES) return -1;
+        Entry* e = &c->entry[c->num];
+        *e = Entry{};
+        e->format = format; e->access = access; e->blend = blend;
+        e->w = w; e->h = h;
+        return c->num++;
+    }
+    int add(Cache* c, Make make, void* data)
+    { // Texture that make() builds (and builds again after a device reset)
+        if(c->num == MAX_ENTRIES) return -1;
+        c->entry[c->num] = Entry{};
+        c->entry[c->num].make = make;
+        c->entry[c->num].data = data;
+        return c->num++;
+    }
+    void drop(Entry* e)
+    { // Destroy the texture, get() makes a new one
+        if(e->tex) SDL_DestroyTexture(e->tex);
+        e->tex = NULL;
+        e->cap_w = 0; e->cap_h = 0;
+    }
+    int grow(int need, int cap, int max)
+    { // Half again what there was, at least need, at most max
+        int n = cap + cap/2;
+        if(n < need) n = need;
+        if((max > 0) && (n > max)) n = (need > max) ? need : max;
+        return n;
+    }
+    void size(Cache* c, int id, int w, int h)
+    { // Blank texture : use w x h from now on
+        Entry* e = &c->entry[id];
+        if((e->w == w) && (e->h == h)) return;
+        e->w = w; e->h = h;
+        e->lost = true;                                 // Old contents are the old size
+        if(e->tex && ((w > e->cap_w) || (h > e->cap_h)))
+        { // Outgrew it : make a bigger one at the next get()
+            int cap_w = (w > e->cap_w) ? grow(w, e->cap_w, c->max_w) : e->cap_w;
+            int cap_h = (h > e->cap_h) ? grow(h, e->cap_h, c->max_h) : e->cap_h;
+            drop(e);
+            e->cap_w = cap_w; e->cap_h = cap_h;
+        }
+    }
+    SDL_Texture* get(Cache* c, int id)
+    { // The texture, made now if there is none. NULL on SDL error.
+        Entry* e = &c->entry[id];
+        if(e->tex) return e->tex;
+        if(e->make) e->tex = e->make(c->ren, e->data);
+        else
+        {
+            if(e->cap_w < e->w) e->cap_w = e->w;
+            if(e->cap_h < e->h) e->cap_h = e->h;
+            e->tex = SDL_CreateTexture(c->ren, e->format, e->access, e->cap_w, e->cap_h);
+            if(e->tex && (SDL_SetTextureBlendMode(e->tex, e->blend) < 0)) drop(e);
+        }
+        if(e->tex) { e->made++; e->lost = true; }
+        return e->tex;
+    }
+    bool redraw(Cache* c, int id)
+    { // True once after the contents were lost (new texture, new size, targets reset)
+        Entry* e = &c->entry[id];
+        bool lost = e->lost;
+        e->lost = false;
+        return lost;
+    }
+    void targets_reset(Cache* c)
+    { // SDL_RENDER_TARGETS_RESET
+        for(int i=0; i<c->num; i++)
+            if(c->entry[i].access == SDL_TEXTUREACCESS_TARGET) c->entry[i].lost = true;
+    }
+    void device_reset(Cache* c)
+    { // SDL_RENDER_DEVICE_RESET : remake everything lazily, at the size in use
+        for(int i=0; i<c->num; i++) { drop(&c->entry[i]); c->entry[i].lost = true; }
+        c->resets++;
+    }
+    int made(const Cache* c)
+    { // Textures made so far, all entries
+        int n = 0;
+        for(int i=0; i<c->num; i++) n += c->entry[i].made;
+        return n;
+    }
+    void destroy(Cache* c)
+    {
+        for(int i=0; i<c->num; i++) drop(&c->entry[i]);
+        c->num = 0;
+    }
+}
+
+#endif // __MG_TEX_CACHE_H__
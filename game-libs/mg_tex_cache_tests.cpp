@@ -0,0 +1,94 @@
+#include <cstdio>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "mg_tex_cache.h"
+
+namespace TexCacheTests
+{
+    int builds{};                                       // Times make() ran
+    SDL_Texture* make(SDL_Renderer* ren, void* data)
+    {
+        builds++;
+        return SDL_CreateTextureFromSurface(ren, static_cast<SDL_Surface*>(data));
+    }
+}
+
+void run_tests_for_mg_tex_cache()
+{
+    using namespace TexCacheTests;
+    SDL_Surface* screen = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_RGBA8888);
+    SDL_Renderer* ren = screen ? SDL_CreateSoftwareRenderer(screen) : NULL;
+    if(ren == NULL)
+    {
+        Tests::note("SKIP mg_tex_cache : no software renderer (%s)", SDL_GetError());
+        if(screen) SDL_FreeSurface(screen);
+        return;
+    }
+    TexCache::Cache c; TexCache::init(&c, ren);
+    c.max_w = 2000; c.max_h = 2000;                     // Whatever the renderer said
+    int art = TexCache::add(&c, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, SDL_BLENDMODE_BLEND, 320, 180);
+    int win = TexCache::add(&c, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, SDL_BLENDMODE_BLEND, 320, 180);
+    int atlas = TexCache::add(&c, make, screen);
+    { // Nothing made until asked for
+        TESTeq(TexCache::made(&c), 0);
+        TEST(TexCache::get(&c, art) != NULL);
+        TEST(TexCache::get(&c, art) != NULL);
+        TEST(TexCache::get(&c, atlas) != NULL);
+        TESTeq(TexCache::made(&c), 2);
+        TEST(TexCache::redraw(&c, art));                // New texture : draw all of it
+        TEST(!TexCache::redraw(&c, art));
+        TESTeq(builds, 1);
+        TexCache::redraw(&c, atlas);
+    }
+    { // Window drag : grows with room to spare, never shrinks
+        TEST(TexCache::get(&c, win) != NULL);
+        TexCache::redraw(&c, win);
+        int made = c.entry[win].made;
+        for(int k=2; k<=3; k++)
+        {
+            TexCache::size(&c, win, k*320, k*180);
+            TEST(TexCache::get(&c, win) != NULL);
+            TEST(TexCache::redraw(&c, win));            // New scale : upscale all of it
+        }
+        TESTeq(c.entry[win].made - made, 2);            // 640 x 360, then 960 x 540
+        TESTeq(c.entry[win].cap_w, 960);
+        for(int k : {1, 2, 3, 2})
+        {
+            TexCache::size(&c, win, k*320, k*180);
+            TexCache::get(&c, win);
+        }
+        TESTeq(c.entry[win].made - made, 2);            // Fits : same texture
+        TexCache::size(&c, win, 1400, 800);             // More than half again : just enough
+        TexCache::get(&c, win);
+        TESTeq(c.entry[win].cap_w, 1440);
+        TexCache::size(&c, win, 1500, 900);             // Half again is past the max
+        TexCache::get(&c, win);
+        TESTeq(c.entry[win].cap_w, 2000);
+        TESTeq(c.entry[win].cap_h, 1215);
+        TexCache::size(&c, win, 960, 540);
+        TexCache::redraw(&c, win);
+    }
+    { // Targets reset : render targets redraw, nothing is remade
+        int made = TexCache::made(&c);
+        TexCache::redraw(&c, art);
+        TexCache::targets_reset(&c);
+        TEST(TexCache::redraw(&c, art));
+        TEST(!TexCache::redraw(&c, win));
+        TEST(!TexCache::redraw(&c, atlas));
+        TESTeq(TexCache::made(&c), made);
+    }
+    { // Device reset : everything remade at the next get(), at the size in use
+        TexCache::device_reset(&c);
+        TESTeq(c.resets, 1);
+        TEST(c.entry[atlas].tex == NULL);
+        TEST(TexCache::get(&c, atlas) != NULL);
+        TESTeq(builds, 2);
+        TEST(TexCache::get(&c, win) != NULL);
+        TESTeq(c.entry[win].cap_w, 960);
+        TEST(TexCache::redraw(&c, win));
+    }
+    TexCache::destroy(&c);
+    TESTeq(c.num, 0);
+    SDL_DestroyRenderer(ren);
+    SDL_FreeSurface(screen);
+}
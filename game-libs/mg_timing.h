@@ -0,0 +1,54 @@
+#ifndef __MG_TIMING_H__
+#define __MG_TIMING_H__
+
+namespace Timing
+{ // Time things with the performance counter (include SDL.h before this)
+    /* *************DOC***************
+     * Timing::now() is a tick count. Convert a pair of ticks to time with
+     * Timing::ms() or Timing::sec().
+     *
+     *      Uint64 t0 = Timing::now();
+     *      do_stuff();
+     *      float dt = Timing::ms(t0, Timing::now());
+     *
+     * Timing::Stats keeps the last Stats::N measurements for avg and max.
+     * *******************************/
+    Uint64 now(void) { return SDL_GetPerformanceCounter(); }
+    double sec(Uint64 t0, Uint64 t1)
+    { // Seconds from t0 to t1
+        return static_cast<double>(t1-t0)/static_cast<double>(SDL_GetPerformanceFrequency());
+    }
+    float ms(Uint64 t0, Uint64 t1) { return static_cast<float>(1000.0*sec(t0,t1)); }
+
+    struct Stats
+    { // Rolling window of the last N measurements
+        static constexpr int N = 120;                   // 2 seconds of frames at 60 FPS
+        float buf[N]{};
+        int pos{};                                      // Next write position
+        int count{};                                    // Number of valid measurements
+        float last{};                                   // Most recent measurement
+
+        void add(float x)
+        {
+            last = x;
+            buf[pos] = x;
+            pos = (pos+1)%N;
+            if(count < N) count++;
+        }
+        float avg(void) const
+        {
+            if(count == 0) return 0;
+            float sum = 0;
+            for(int i=0; i<count; i++) sum += buf[i];
+            return sum/count;
+        }
+        float max(void) const
+        {
+            float m = 0;
+            for(int i=0; i<count; i++) if(buf[i] > m) m = buf[i];
+            return m;
+        }
+    };
+}
+
+#endif // __MG_TIMING_H__
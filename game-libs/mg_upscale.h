@@ -0,0 +1,80 @@
+#ifndef __MG_UPSCALE_H__
+#define __MG_UPSCALE_H__
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Upscale
+{ // Nearest-neighbor upscale by an integer factor (include SDL.h first)
+    /* *************DOC***************
+     * Chunky pixels: every source pixel becomes a k x k block of destination pixels.
+     *
+     * Because k is an integer, there is no filtering and no per-pixel coordinate math:
+     *  1. row() : repeat each pixel of a source row k times into a destination row
+     *  2. copy that destination row k-1 more times with memcpy
+     *
+     *      src row :  A B C
+     *      k = 3   :  A A A B B B C C C   <-- row()
+     *                 A A A B B B C C C   <-- memcpy
+     *                 A A A B B B C C C   <-- memcpy
+     *
+     * Pixels are 32-bit (any 32-bit format, the bytes are just copied).
+     * Pitches are in pixels, not bytes.
+     * *******************************/
+    void row(const Uint32* src, int n, Uint32* dst, int k)
+    { // dst[0 : n*k) = each src pixel repeated k times
+        int i = 0;
+#if defined(__SSE2__)
+        if(k == 2)
+        { // ABCD -> AABB CCDD
+            for(; i+4<=n; i+=4)
+            {
+                __m128i s = _mm_loadu_si128((const __m128i*)(src+i));
+                _mm_storeu_si128((__m128i*)(dst+2*i),   _mm_unpacklo_epi32(s, s));
+                _mm_storeu_si128((__m128i*)(dst+2*i+4), _mm_unpackhi_epi32(s, s));
+            }
+        }
+        else if(k == 4)
+        { // ABCD -> AAAA BBBB CCCC DDDD
+            for(; i+4<=n; i+=4)
+            {
+                __m128i s = _mm_loadu_si128((const __m128i*)(src+i));
+                __m128i lo = _mm_unpacklo_epi32(s, s);  // AABB
+                __m128i hi = _mm_unpackhi_epi32(s, s);  // CCDD
+                _mm_storeu_si128((__m128i*)(dst+4*i),    _mm_unpacklo_epi64(lo, lo));
+                _mm_storeu_si128((__m128i*)(dst+4*i+4),  _mm_unpackhi_epi64(lo, lo));
+                _mm_storeu_si128((__m128i*)(dst+4*i+8),  _mm_unpacklo_epi64(hi, hi));
+                _mm_storeu_si128((__m128i*)(dst+4*i+12), _mm_unpackhi_epi64(hi, hi));
+            }
+        }
+        else if(k > 4)
+        { // One pixel at a time, 4 copies per store
+            for(; i<n; i++)
+            {
+                __m128i v = _mm_set1_epi32(static_cast<int>(src[i]));
+                Uint32* d = dst + i*k;
+                int j = 0;
+                for(; j+4<=k; j+=4) _mm_storeu_si128((__m128i*)(d+j), v);
+                for(; j<k; j++) d[j] = src[i];
+            }
+        }
+#endif
+        for(; i<n; i++)
+        { // Leftovers (and k = 1, 3 or no SSE2)
+            Uint32* d = dst + i*k;
+            for(int j=0; j<k; j++) d[j] = src[i];
+        }
+    }
+    void blit(const Uint32* src, int src_pitch, int w, int h, Uint32* dst, int dst_pitch, int k)
+    { // Upscale w x h src pixels into (w*k) x (h*k) dst pixels
+        for(int y=0; y<h; y++)
+        {
+            Uint32* d = dst + (y*k)*dst_pitch;
+            row(src + y*src_pitch, w, d, k);
+            for(int r=1; r<k; r++) memcpy(d + r*dst_pitch, d, w*k*sizeof(Uint32));
+        }
+    }
+}
+
+#endif // __MG_UPSCALE_H__
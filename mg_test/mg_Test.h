@@ -0,0 +1,95 @@
+#ifndef __MG_TEST_H__
+#define __MG_TEST_H__
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+
+namespace Tests
+{ // Tiny test framework : a failed test prints where and why, then keeps going
+    /* *************DOC***************
+     * TEST(expr)               expr is true
+     * TESTeq(a, b)             a == b (ints of any signedness compare by value)
+     * TESTnear(a, b, tol)      |a - b| <= tol
+     *
+     * Each one counts as one test in Tests::total. A pass prints nothing. A fail
+     * prints file:line, the expression, and both values:
+     *
+     *      src/synth_tests.cpp:42: FAIL TESTeq(Sound::pos, want) : 1024 != 1000
+     *
+     * For a property over many inputs, loop with a plain bool and TEST() it once,
+     * then report the first input that broke it (see Tests::note()).
+     *
+     * main() ends with:
+     *
+     *      return Tests::exit_code();              // EXIT_FAILURE if anything failed
+     * *******************************/
+    int fail{};
+    int pass{};
+    int total{};
+
+    template<typename T>
+    void show(const T& x)
+    { // Print a value the way it would be written in code
+        if constexpr(std::is_same_v<T, bool>)            printf("%s", x ? "true" : "false");
+        else if constexpr(std::is_floating_point_v<T>)   printf("%.9g", static_cast<double>(x));
+        else if constexpr(std::is_enum_v<T>)             printf("%lld", static_cast<long long>(x));
+        else if constexpr(std::is_signed_v<T>)           printf("%lld", static_cast<long long>(x));
+        else if constexpr(std::is_unsigned_v<T>)         printf("%llu", static_cast<unsigned long long>(x));
+        else if constexpr(std::is_convertible_v<T, const char*>) printf("\"%s\"", static_cast<const char*>(x));
+        else if constexpr(std::is_pointer_v<T>)          printf("%p", static_cast<const void*>(x));
+        else                                             printf("?");
+    }
+    bool result(bool ok, const char* file, int line, const char* test)
+    { // Count one test. On fail, print the start of the message (caller finishes the line).
+        total++;
+        if(ok) { pass++; return true; }
+        fail++;
+        printf("%s:%d: FAIL %s", file, line, test);
+        return false;
+    }
+    template<typename A, typename B>
+    bool equal(const A& a, const B& b)
+    {
+        if constexpr(  std::is_integral_v<A> && std::is_integral_v<B>
+                    && !std::is_same_v<A, bool> && !std::is_same_v<B, bool>)
+            return std::cmp_equal(a, b);
+        else return a == b;
+    }
+    template<typename A, typename B>
+    bool eq(const A& a, const B& b, const char* test, const char* file, int line)
+    {
+        if(result(equal(a, b), file, line, test)) return true;
+        printf(" : "); show(a); printf(" != "); show(b); printf("\n");
+        return false;
+    }
+    bool near(double a, double b, double tol, const char* test, const char* file, int line)
+    {
+        double d = (a > b) ? a-b : b-a;
+        if(result(d <= tol, file, line, test)) return true;
+        printf(" : %.9g and %.9g differ by %.3g\n", a, b, d);
+        return false;
+    }
+    bool is_true(bool ok, const char* test, const char* file, int line)
+    {
+        if(result(ok, file, line, test)) return true;
+        printf("\n");
+        return false;
+    }
+    void note(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+    void note(const char* fmt, ...)
+    { // Extra detail under a failed test
+        va_list args; va_start(args, fmt);
+        printf("\t"); vprintf(fmt, args); printf("\n");
+        va_end(args);
+    }
+    int exit_code(void) { return fail ? EXIT_FAILURE : EXIT_SUCCESS; }
+}
+
+#define TEST(expr) Tests::is_true((expr), "TEST(" #expr ")", __FILE__, __LINE__)
+#define TESTeq(a, b) Tests::eq((a), (b), "TESTeq(" #a ", " #b ")", __FILE__, __LINE__)
+#define TESTnear(a, b, tol) Tests::near((a), (b), (tol), "TESTnear(" #a ", " #b ", " #tol ")", __FILE__, __LINE__)
+
+#endif // __MG_TEST_H__
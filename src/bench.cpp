@@ -0,0 +1,608 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "mg_colors.h"
+#include "mg_timing.h"
+#include "mg_glyph_atlas.h"
+#include "mg_draw_list.h"
+#include "mg_raster.h"
+#include "mg_upscale.h"
+#include "mg_sprites.h"
+#include "mg_snapshot_ring.h"
+#include "mg_fft.h"
+#include "synth.h"
+
+/* *************Benchmarks***************
+ * Build with optimizations and run: make bench
+ *
+ * Everything draws with SDL's software renderer on an offscreen surface, and SDL
+ * uses its dummy video and audio drivers, so this runs headless (no display, no
+ * sound card).
+ *
+ * Results also go to a JSON file. If there is a baseline file, every result is
+ * compared to it and the run fails if any got slower by more than the threshold:
+ *
+ *      make bench                      # Run, write build-bench/bench.json, compare
+ *      make bench-baseline             # Keep this run as build-bench/baseline.json
+ *      make bench BENCH_THRESHOLD=5    # Fail on more than 5% slower
+ *
+ *      run-bench [--json out.json] [--compare baseline.json] [--threshold percent]
+ * *******************************/
+
+namespace Bench
+{ // Shared setup for benchmarks
+    constexpr int W = 320;                              // GameArt::w
+    constexpr int H = 180;                              // GameArt::h
+    SDL_Surface* surf;                                  // Offscreen render target
+    SDL_Renderer* ren;                                  // Software renderer on surf
+    struct Result
+    {
+        char name[64];
+        float ms_per_rep;
+        float ns_per_op;
+    };
+    constexpr int MAX_RESULTS = 64;
+    Result results[MAX_RESULTS];
+    int num_results{};
+    void report(const char* name, Uint64 t0, Uint64 t1, int reps, int ops)
+    { // Print time per rep and per op, keep it for the JSON file
+        float ms = Timing::ms(t0, t1);
+        float ns_per_op = 1e6f*ms/(static_cast<float>(reps)*ops);
+        printf("%-40s %9.3f ms/rep %9.2f ns/op\n", name, ms/reps, ns_per_op);
+        if(num_results == MAX_RESULTS) return;
+        Result* r = &results[num_results++];
+        snprintf(r->name, sizeof(r->name), "%s", name);
+        r->ms_per_rep = ms/reps; r->ns_per_op = ns_per_op;
+    }
+    bool write_json(const char* path)
+    { // One result per line, so compare() can read it back with sscanf
+        FILE* f = fopen(path, "w");
+        if(f == NULL) return false;
+        fprintf(f, "{\"results\":[\n");
+        for(int i=0; i<num_results; i++)
+        {
+            fprintf(f, "{\"name\":\"%s\",\"ms_per_rep\":%.6f,\"ns_per_op\":%.4f}%s\n",
+                    results[i].name, results[i].ms_per_rep, results[i].ns_per_op,
+                    (i+1 < num_results) ? "," : "");
+        }
+        fprintf(f, "]}\n");
+        fclose(f);
+        return true;
+    }
+    int compare(const char* path, float threshold)
+    { // Compare to baseline at path. Return number of results more than threshold % slower.
+        FILE* f = fopen(path, "r");
+        if(f == NULL) return -1;
+        printf("\n%-40s %12s %12s %8s\n", "vs baseline", "base ns/op", "now ns/op", "change");
+        int regressions = 0;
+        char line[256];
+        while(fgets(line, sizeof(line), f))
+        {
+            Result base;
+            if(sscanf(line, "{\"name\":\"%63[^\"]\",\"ms_per_rep\":%f,\"ns_per_op\":%f",
+                        base.name, &base.ms_per_rep, &base.ns_per_op) != 3) continue;
+            const Result* now = NULL;
+            for(int i=0; i<num_results; i++) if(strcmp(results[i].name, base.name) == 0) now = &results[i];
+            if((now == NULL) || (base.ns_per_op <= 0)) continue;   // Benchmark was renamed or removed
+            float change = 100*(now->ns_per_op - base.ns_per_op)/base.ns_per_op;
+            bool slower = (change > threshold);
+            if(slower) regressions++;
+            printf("%-40s %12.2f %12.2f %+7.1f%%%s\n", base.name, base.ns_per_op, now->ns_per_op,
+                    change, slower ? "  REGRESSION" : "");
+        }
+        fclose(f);
+        printf("%d regressions (threshold %.1f%%)\n", regressions, threshold);
+        return regressions;
+    }
+}
+
+namespace BenchDrawList
+{ // Immediate SDL draw calls vs DrawList batching
+    constexpr int NUM_PRIMS = 100000;                   // Primitives per rep
+    constexpr int REPS = 5;
+    SDL_Color color(int i)
+    { // Cycle through colors so every primitive changes draw color
+        SDL_Color c = Colors::list[i%SDL_arraysize(Colors::list)]; c.a = 128;
+        return c;
+    }
+    SDL_Rect rect(int i)
+    { // Some rect inside the game art
+        return SDL_Rect{(i*7)%Bench::W, (i*13)%Bench::H, 1+(i%17), 1+(i%11)};
+    }
+    void immediate(SDL_Renderer* ren)
+    { // One SDL_SetRenderDrawColor + one draw call per primitive
+        for(int i=0; i<NUM_PRIMS; i++)
+        {
+            SDL_Color c = color(i); SDL_Rect r = rect(i);
+            SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a);
+            switch(i%3)
+            {
+                case 0: SDL_RenderDrawLine(ren, r.x, r.y, r.x+r.w, r.y+r.h); break;
+                case 1: SDL_RenderFillRect(ren, &r); break;
+                default: SDL_RenderDrawRect(ren, &r); break;
+            }
+        }
+    }
+    void batched(SDL_Renderer* ren, DrawList::List* dl)
+    { // Record everything, then one SDL_RenderGeometry call per full list
+        DrawList::begin(dl, ren, SDL_BLENDMODE_ADD);
+        for(int i=0; i<NUM_PRIMS; i++)
+        {
+            SDL_Color c = color(i); SDL_Rect r = rect(i);
+            switch(i%3)
+            {
+                case 0: DrawList::line(dl, r.x, r.y, r.x+r.w, r.y+r.h, c); break;
+                case 1: DrawList::fill_rect(dl, r, c); break;
+                default: DrawList::rect(dl, r, c); break;
+            }
+        }
+        DrawList::flush(dl);
+    }
+    void run(void)
+    {
+        SDL_Renderer* ren = Bench::ren;
+        SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_ADD);
+        { // Immediate
+            Uint64 t0 = Timing::now();
+            for(int rep=0; rep<REPS; rep++) immediate(ren);
+            Bench::report("draw 100k prims : immediate", t0, Timing::now(), REPS, NUM_PRIMS);
+        }
+        { // DrawList
+            DrawList::List dl;
+            if(!DrawList::init(&dl, 1<<16)) { puts("Out of memory"); return; }
+            Uint64 t0 = Timing::now();
+            for(int rep=0; rep<REPS; rep++) batched(ren, &dl);
+            Bench::report("draw 100k prims : DrawList", t0, Timing::now(), REPS, NUM_PRIMS);
+            printf("\t(%d SDL_RenderGeometry calls per rep)\n", dl.num_calls);
+            DrawList::destroy(&dl);
+        }
+    }
+}
+
+namespace BenchGameArt
+{ // Game art backends : render target + DrawList vs CPU raster + dirty row upload
+    constexpr int SCALE = 4;                            // GameArt::pixel_size
+    constexpr int WIN_W = Bench::W*SCALE;
+    constexpr int WIN_H = Bench::H*SCALE;
+    constexpr int FRAMES = 200;
+    template<typename Painter>
+    void scene(Painter* p, int frame, bool moving)
+    { // Same kind of placeholder art as main.cpp. moving=false : only voice boxes change.
+        SDL_Color c = Colors::list[moving ? frame%SDL_arraysize(Colors::list) : 0]; c.a = 128;
+        line(p, 0,0,Bench::W,Bench::H, c);
+        line(p, Bench::W,0,0,Bench::H, c);
+        int mx = moving ? (frame*3)%Bench::W : 100;
+        line(p, Bench::W/2,Bench::H/2, mx,50, c);
+        int s = moving ? frame%Bench::H : 60;
+        fill_rect(p, SDL_Rect{Bench::W/2-s/2, Bench::H/2-s/2, s, s}, Colors::tardis);
+        for(int i=0; i<8; i++)
+        { // Voice boxes : the count changes every frame
+            SDL_Rect r{10+i*15, 10, 10, 10};
+            if((frame%8) >= i) fill_rect(p, r, Colors::orange);
+            else               rect(p, r, Colors::orange);
+        }
+    }
+    void run_target(SDL_Renderer* ren, bool moving, const char* name)
+    { // Current path : draw into render target texture, stretch to window
+        SDL_Texture* tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888,
+                SDL_TEXTUREACCESS_TARGET, Bench::W, Bench::H);
+        DrawList::List dl; DrawList::init(&dl, 1<<12);
+        SDL_Rect dst{0,0,WIN_W,WIN_H};
+        Uint64 t0 = Timing::now();
+        for(int f=0; f<FRAMES; f++)
+        {
+            SDL_SetRenderTarget(ren, tex);
+            SDL_SetRenderDrawColor(ren, 0x24,0x23,0x21,0xff);
+            SDL_RenderClear(ren);
+            DrawList::begin(&dl, ren, SDL_BLENDMODE_ADD);
+            scene(&dl, f, moving);
+            DrawList::flush(&dl);
+            SDL_SetRenderTarget(ren, NULL);
+            SDL_RenderCopy(ren, tex, NULL, &dst);
+        }
+        Bench::report(name, t0, Timing::now(), FRAMES, 1);
+        DrawList::destroy(&dl);
+        SDL_DestroyTexture(tex);
+    }
+    void run_cpu(SDL_Renderer* ren, bool moving, const char* name)
+    { // CPU raster : draw into memory, upload changed rows, stretch to window
+        SDL_Texture* tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888,
+                SDL_TEXTUREACCESS_STREAMING, Bench::W, Bench::H);
+        Raster::Canvas cv; Raster::init(&cv, Bench::W, Bench::H);
+        SDL_Rect dst{0,0,WIN_W,WIN_H};
+        int rows = 0;
+        Uint64 t0 = Timing::now();
+        for(int f=0; f<FRAMES; f++)
+        {
+            Raster::clear(&cv, Colors::darkgravel);
+            cv.blend = SDL_BLENDMODE_ADD;
+            scene(&cv, f, moving);
+            rows += Raster::upload(&cv, tex);
+            SDL_RenderCopy(ren, tex, NULL, &dst);
+        }
+        Bench::report(name, t0, Timing::now(), FRAMES, 1);
+        printf("\t(%d of %d rows uploaded per frame)\n", rows/FRAMES, Bench::H);
+        Raster::destroy(&cv);
+        SDL_DestroyTexture(tex);
+    }
+    void run(void)
+    {
+        SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, WIN_W, WIN_H, 32, SDL_PIXELFORMAT_RGBA8888);
+        SDL_Renderer* ren = SDL_CreateSoftwareRenderer(surf);
+        if(ren == NULL) { printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError()); return; }
+        run_target(ren, true,  "game art frame : render target");
+        run_cpu(ren,    true,  "game art frame : CPU raster");
+        run_target(ren, false, "game art frame (static) : render target");
+        run_cpu(ren,    false, "game art frame (static) : CPU raster");
+        SDL_DestroyRenderer(ren);
+        SDL_FreeSurface(surf);
+    }
+}
+
+namespace BenchSprites
+{ // 20k moving sprites over a tilemap : one SDL_RenderGeometry per layer vs CPU raster
+    constexpr int NUM = 20000;
+    constexpr int TILE = 8;
+    constexpr int FRAMES = 200;
+    constexpr float BUDGET_MS = 1000.0f/60;             // 60 FPS
+    Sprites::Sheet sheet;
+    Sprites::Tilemap map;
+    Sprites::Layer layer;
+    SDL_FPoint vel[NUM];
+    bool setup(void)
+    { // 8x8 images, a map twice the game art each way, sprites anywhere on it
+        if(!Sprites::init(&sheet, 64, 64) || !Sprites::init(&map, 2*Bench::W/TILE, 2*Bench::H/TILE, TILE, TILE)
+          || !Sprites::init(&layer, NUM)) return false;
+        Uint32 px[TILE*TILE];
+        for(int i=0; i<4; i++)
+        { // Ring of color, clear middle : both clear and opaque pixels
+            for(int p=0; p<TILE*TILE; p++)
+            {
+                int x = p%TILE; int y = p/TILE;
+                bool edge = (x == 0) || (y == 0) || (x == TILE-1) || (y == TILE-1);
+                px[p] = edge ? Raster::pack(Colors::list[i]) : 0;
+            }
+            Sprites::add(&sheet, px, TILE, TILE, TILE);
+        }
+        map.tileset[1] = 0;
+        for(int y=0; y<map.h; y++) for(int x=0; x<map.w; x++) if((x+y)%3 == 0) Sprites::set(&map, x, y, 1);
+        for(int i=0; i<NUM; i++)
+        {
+            Sprites::add(&layer, 1 + i%3, static_cast<float>((i*37)%(Bench::W-TILE)), static_cast<float>((i*53)%(Bench::H-TILE)));
+            vel[i] = SDL_FPoint{static_cast<float>(i%7) - 3, static_cast<float>(i%5) - 2};
+        }
+        return true;
+    }
+    void step(void)
+    { // Everything moves every frame : no frame is like the last
+        for(int i=0; i<NUM; i++)
+        {
+            Sprites::Sprite* sp = &layer.sprites[i];
+            sp->x += vel[i].x; sp->y += vel[i].y;
+            if((sp->x < 0) || (sp->x > Bench::W-TILE)) vel[i].x = -vel[i].x;
+            if((sp->y < 0) || (sp->y > Bench::H-TILE)) vel[i].y = -vel[i].y;
+        }
+    }
+    void verdict(const char* name, Uint64 t0, Uint64 t1)
+    {
+        Bench::report(name, t0, t1, FRAMES, NUM);
+        float ms = Timing::ms(t0, t1)/FRAMES;
+        printf("\t(%.0f FPS, %s the 60 FPS budget)\n", 1000/ms, (ms <= BUDGET_MS) ? "within" : "OVER");
+    }
+    void run_target(SDL_Renderer* ren)
+    { // Render target + DrawList : one call for the map, one for the sprites
+        SDL_Texture* tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888,
+                SDL_TEXTUREACCESS_TARGET, Bench::W, Bench::H);
+        sheet.tex = Sprites::make_texture(&sheet, ren);
+        DrawList::List dl;
+        if((tex == NULL) || (sheet.tex == NULL) || !DrawList::init(&dl, 1<<15))
+        { // Nothing to time : clean up below
+            printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError());
+        }
+        else
+        {
+            const SDL_Rect map_view{Bench::W/2, Bench::H/2, Bench::W, Bench::H};   // Map scrolled
+            const SDL_Rect art{0, 0, Bench::W, Bench::H};   // Sprites live in the game art
+            int calls = 0;
+            Uint64 t0 = Timing::now();
+            for(int f=0; f<FRAMES; f++)
+            {
+                step();
+                SDL_SetRenderTarget(ren, tex);
+                SDL_SetRenderDrawColor(ren, 0x24,0x23,0x21,0xff);
+                SDL_RenderClear(ren);
+                DrawList::begin(&dl, ren, SDL_BLENDMODE_ADD);
+                Sprites::draw(&dl, &sheet, &map, map_view);
+                Sprites::draw(&dl, &sheet, &layer, art);
+                DrawList::flush(&dl);
+                calls += dl.num_calls;
+                SDL_SetRenderTarget(ren, NULL);
+                SDL_RenderCopy(ren, tex, NULL, NULL);
+            }
+            verdict("20k sprites + map : render target", t0, Timing::now());
+            printf("\t(%d SDL_RenderGeometry calls per frame)\n", calls/FRAMES);
+        }
+        DrawList::destroy(&dl);
+        if(sheet.tex) { SDL_DestroyTexture(sheet.tex); sheet.tex = NULL; }
+        if(tex) SDL_DestroyTexture(tex);
+    }
+    void run_cpu(SDL_Renderer* ren)
+    { // CPU raster : blit into memory, upload changed rows
+        SDL_Texture* tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888,
+                SDL_TEXTUREACCESS_STREAMING, Bench::W, Bench::H);
+        Raster::Canvas cv; Raster::init(&cv, Bench::W, Bench::H);
+        const SDL_Rect map_view{Bench::W/2, Bench::H/2, Bench::W, Bench::H};
+        const SDL_Rect art{0, 0, Bench::W, Bench::H};
+        Uint64 t0 = Timing::now();
+        for(int f=0; f<FRAMES; f++)
+        {
+            step();
+            Raster::clear(&cv, Colors::darkgravel);
+            Sprites::draw(&cv, &sheet, &map, map_view);
+            Sprites::draw(&cv, &sheet, &layer, art);
+            Raster::upload(&cv, tex);
+            SDL_RenderCopy(ren, tex, NULL, NULL);
+        }
+        verdict("20k sprites + map : CPU raster", t0, Timing::now());
+        printf("\t(%d of %d map chunks drawn)\n", map.drawn, map.chunks_w*map.chunks_h);
+        Raster::destroy(&cv);
+        SDL_DestroyTexture(tex);
+    }
+    void run(void)
+    {
+        if(!setup()) puts("Out of memory");
+        else { run_target(Bench::ren); run_cpu(Bench::ren); }
+        Sprites::destroy(&layer);                       // Whatever setup() got
+        Sprites::destroy(&map);
+        Sprites::destroy(&sheet);
+    }
+}
+
+namespace BenchUpscale
+{ // Chunky pixel upscale : SDL scaled copy vs integer upscale + 1:1 copy
+    constexpr int K = 4;                                // GtoW::scale
+    constexpr int WIN_W = Bench::W*K;
+    constexpr int WIN_H = Bench::H*K;
+    constexpr int FRAMES = 200;
+    void run(void)
+    {
+        SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, WIN_W, WIN_H, 32, SDL_PIXELFORMAT_RGBA8888);
+        SDL_Renderer* ren = SDL_CreateSoftwareRenderer(surf);
+        if(ren == NULL) { printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError()); return; }
+        Raster::Canvas cv; Raster::init(&cv, Bench::W, Bench::H);
+        for(int i=0; i<Bench::W*Bench::H; i++) cv.px[i] = 0x01020304u*(i%61);
+        SDL_Rect dst{0,0,WIN_W,WIN_H};
+        { // Scaled copy (what the render target path does)
+            SDL_Texture* tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888,
+                    SDL_TEXTUREACCESS_STREAMING, Bench::W, Bench::H);
+            SDL_UpdateTexture(tex, NULL, cv.px, Bench::W*sizeof(Uint32));
+            Uint64 t0 = Timing::now();
+            for(int f=0; f<FRAMES; f++) SDL_RenderCopy(ren, tex, NULL, &dst);
+            Bench::report("upscale x4 : SDL_RenderCopy scaled", t0, Timing::now(), FRAMES, 1);
+            SDL_DestroyTexture(tex);
+        }
+        SDL_Texture* win_tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888,
+                SDL_TEXTUREACCESS_STREAMING, WIN_W, WIN_H);
+        { // Integer upscale (Upscale::blit only)
+            Uint32* out = (Uint32*)malloc(WIN_W*WIN_H*sizeof(Uint32));
+            Uint64 t0 = Timing::now();
+            for(int f=0; f<FRAMES; f++) Upscale::blit(cv.px, Bench::W, Bench::W, Bench::H, out, WIN_W, K);
+            Bench::report("upscale x4 : Upscale::blit", t0, Timing::now(), FRAMES, 1);
+            free(out);
+        }
+        { // Integer upscale into streaming texture, every row changed, then 1:1 copy
+            Uint64 t0 = Timing::now();
+            for(int f=0; f<FRAMES; f++)
+            {
+                void* pixels; int pitch;
+                SDL_LockTexture(win_tex, NULL, &pixels, &pitch);
+                Upscale::blit(cv.px, Bench::W, Bench::W, Bench::H, (Uint32*)pixels, pitch/sizeof(Uint32), K);
+                SDL_UnlockTexture(win_tex);
+                SDL_RenderCopy(ren, win_tex, NULL, &dst);
+            }
+            Bench::report("upscale x4 : lock+blit+copy 1:1", t0, Timing::now(), FRAMES, 1);
+        }
+        { // Game art unchanged : upscale skipped, 1:1 copy only
+            Uint64 t0 = Timing::now();
+            for(int f=0; f<FRAMES; f++) SDL_RenderCopy(ren, win_tex, NULL, &dst);
+            Bench::report("upscale x4 : unchanged (copy 1:1)", t0, Timing::now(), FRAMES, 1);
+        }
+        SDL_DestroyTexture(win_tex);
+        Raster::destroy(&cv);
+        SDL_DestroyRenderer(ren);
+        SDL_FreeSurface(surf);
+    }
+}
+
+namespace BenchScope
+{ // Per-frame cost of the scope : copy latest samples out of the ring, then FFT
+    constexpr int N = 4096;                             // Scope::N
+    constexpr int FRAMES = 2000;
+    void run(void)
+    {
+        static SnapshotRing::Ring ring;
+        static Uint8 tape[2*SnapshotRing::SIZE];
+        for(Uint32 i=0; i<sizeof(tape); i++) tape[i] = static_cast<Uint8>(i*7);
+        SnapshotRing::write_le16(&ring, tape, SnapshotRing::SIZE);
+        static Sint16 snap[N]; static float x[N]; static float mag[N/2+1];
+        FFT::Plan fft; FFT::init(&fft, N);
+        { // Snapshot only
+            Uint64 t0 = Timing::now();
+            for(int f=0; f<FRAMES; f++) SnapshotRing::read_latest(&ring, snap, N);
+            Bench::report("scope : read_latest 4096", t0, Timing::now(), FRAMES, N);
+        }
+        { // FFT only
+            for(int i=0; i<N; i++) x[i] = snap[i]/32768.0f;
+            Uint64 t0 = Timing::now();
+            for(int f=0; f<FRAMES; f++) FFT::magnitude(&fft, x, mag);
+            Bench::report("scope : FFT::magnitude 4096", t0, Timing::now(), FRAMES, N);
+        }
+        FFT::destroy(&fft);
+    }
+}
+
+namespace BenchSynth
+{ // Audio thread kernels : write_tape per voice count, noise, device callback
+    constexpr int BLOCK = 512;                          // Samples per callback (main.cpp)
+    constexpr int BLOCKS = GameAudio::SAMPLE_RATE/BLOCK;// About 1s of audio per rep
+    constexpr int REPS = 5;
+    Uint8 block[BLOCK*GameAudio::BYTES_PER_SAMPLE];
+    void setup(void)
+    { // Mouse at a middling position, held (nothing in UI::VCA::ring)
+        const float v[ControlRing::NUM_VALUES] = {0.5f, 0.5f};
+        ControlRing::init(&UI::VCA::curve, GameAudio::SAMPLE_RATE, v);
+        Envelope::enabled = false; Envelope::phase = 0; // Envelope holds at full volume
+        Nodes::setup();                                 // Default patch
+    }
+    void write_tape_voices(int voices)
+    {
+        Voices::count = voices;
+        char name[64]; snprintf(name, sizeof(name), "write_tape : %d voices", voices);
+        Uint64 t0 = Timing::now();
+        for(int rep=0; rep<REPS; rep++)
+            for(int b=0; b<BLOCKS; b++) write_tape(block, BLOCK);
+        Bench::report(name, t0, Timing::now(), REPS, BLOCKS*BLOCK);
+    }
+    void noise(void)
+    {
+        constexpr int N = 1<<20;
+        volatile float sink = 0;                        // Keep the calls
+        Uint64 t0 = Timing::now();
+        for(int rep=0; rep<REPS; rep++)
+        {
+            float sum = 0;
+            for(int i=0; i<N; i++) sum += Waveform::noise();
+            sink = sink + sum;
+        }
+        Bench::report("Waveform::noise", t0, Timing::now(), REPS, N);
+    }
+    void fill_audio_dev(Uint32 tape_samples, const char* name)
+    { // Callback with a tape of tape_samples : short tapes wrap around more often
+        using namespace GameAudio;
+        Voices::count = 1;
+        Sound::len = tape_samples*BYTES_PER_SAMPLE;
+        Sound::buf = (Uint8*)calloc(Sound::len, 1);
+        Sound::pos = 0;
+        num_samples = BLOCK;
+        if(Sound::buf == NULL) { puts("Out of memory"); return; }
+        Uint64 t0 = Timing::now();
+        for(int rep=0; rep<REPS; rep++)
+            for(int b=0; b<BLOCKS; b++) GameAudio::fill_audio_dev(NULL, block, sizeof(block));
+        Bench::report(name, t0, Timing::now(), REPS, BLOCKS*BLOCK);
+        free(Sound::buf); Sound::buf = NULL;
+    }
+    void run(void)
+    {
+        setup();
+        const int voices[] = {1, 8, 64, 256};
+        for(int v : voices) write_tape_voices(v);
+        noise();
+        fill_audio_dev(GameAudio::SAMPLE_RATE, "fill_audio_dev : 1s tape");
+        fill_audio_dev(3*BLOCK + BLOCK/5, "fill_audio_dev : wrap 1 in 3");
+    }
+}
+
+namespace BenchOverlay
+{ // Overlay text : lay out and draw with the glyph atlas
+    constexpr int WIN_W = 1280;
+    constexpr int WIN_H = 720;
+    constexpr int FRAMES = 500;
+    void run(void)
+    {
+        if(TTF_Init() < 0) { printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError()); return; }
+        TTF_Font* ttf = TTF_OpenFont("ProggyClean.ttf", 36);
+        if(ttf == NULL) { printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError()); TTF_Quit(); return; }
+        SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormat(0, WIN_W, WIN_H, 32, SDL_PIXELFORMAT_RGBA8888);
+        SDL_Renderer* ren = SDL_CreateSoftwareRenderer(surf);
+        static GlyphAtlas::Atlas atlas;
+        static GlyphAtlas::Text text;
+        if((ren == NULL) || !GlyphAtlas::build(&atlas, ren, ttf))
+        {
+            printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError());
+        }
+        else
+        {
+            char str[256];
+            { // Text changes every frame (FREQ line follows the mouse)
+                Uint64 t0 = Timing::now();
+                for(int f=0; f<FRAMES; f++)
+                {
+                    snprintf(str, sizeof(str),
+                        "FREQ: %0.3fHz %0.3fHz\nFRAME: %0.2fms avg %0.2fms max\n"
+                        "PHYSICS: 240Hz TEXT: %0.1fus", 0.1f*f, 0.2f*f, 16.6f, 17.1f, 0.3f*f);
+                    GlyphAtlas::layout(&text, &atlas, str, 10, 10, WIN_W-20, Colors::snow);
+                    GlyphAtlas::draw(ren, &atlas, &text);
+                }
+                Bench::report("overlay text : layout+draw", t0, Timing::now(), FRAMES, 1);
+            }
+            { // Same text every frame : layout is a cache hit
+                Uint64 t0 = Timing::now();
+                for(int f=0; f<FRAMES; f++)
+                {
+                    GlyphAtlas::layout(&text, &atlas, str, 10, 10, WIN_W-20, Colors::snow);
+                    GlyphAtlas::draw(ren, &atlas, &text);
+                }
+                Bench::report("overlay text : cached+draw", t0, Timing::now(), FRAMES, 1);
+            }
+        }
+        GlyphAtlas::destroy(&atlas);
+        if(ren) SDL_DestroyRenderer(ren);
+        SDL_FreeSurface(surf);
+        TTF_CloseFont(ttf);
+        TTF_Quit();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* json_path = NULL;                       // --json : write results here
+    const char* baseline_path = NULL;                   // --compare : baseline results
+    float threshold = 10;                               // --threshold : % slower to fail
+    for(int i=1; i<argc; i++)
+    {
+        if((strcmp(argv[i], "--json") == 0) && (i+1 < argc))           json_path = argv[++i];
+        else if((strcmp(argv[i], "--compare") == 0) && (i+1 < argc))   baseline_path = argv[++i];
+        else if((strcmp(argv[i], "--threshold") == 0) && (i+1 < argc)) threshold = static_cast<float>(atof(argv[++i]));
+        else { printf("usage: %s [--json out.json] [--compare baseline.json] [--threshold percent]\n", argv[0]); return EXIT_FAILURE; }
+    }
+    // Headless : no window, no sound card (unless the caller picked a driver)
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
+    {
+        printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    { // Offscreen software renderer, same size as game art
+        Bench::surf = SDL_CreateRGBSurfaceWithFormat(0, Bench::W, Bench::H, 32, SDL_PIXELFORMAT_RGBA8888);
+        Bench::ren = SDL_CreateSoftwareRenderer(Bench::surf);
+        if(Bench::ren == NULL)
+        {
+            printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError());
+            return EXIT_FAILURE;
+        }
+    }
+    BenchDrawList::run();
+    BenchGameArt::run();
+    BenchSprites::run();
+    BenchUpscale::run();
+    BenchScope::run();
+    BenchSynth::run();
+    BenchOverlay::run();
+    SDL_DestroyRenderer(Bench::ren);
+    SDL_FreeSurface(Bench::surf);
+    SDL_Quit();
+    if(json_path && !Bench::write_json(json_path))
+    {
+        printf("line %d : Cannot write \"%s\"\n",__LINE__, json_path);
+        return EXIT_FAILURE;
+    }
+    if(baseline_path)
+    {
+        int regressions = Bench::compare(baseline_path, threshold);
+        if(regressions < 0) printf("No baseline at %s (make bench-baseline)\n", baseline_path);
+        if(regressions > 0) return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,315 @@
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "SDL.h"
+#include "mg_timing.h"
+#include "mg_fft.h"
+#include "synth.h"
+
+/* *************Golden audio tests***************
+ * Render scripted input through the real audio path, compare it to a reference
+ * render : make golden
+ *
+ * SDL runs the device with its disk driver (SDL_AUDIODRIVER=disk). The callback
+ * (GameAudio::fill_audio_dev, write_tape, the patch) runs on SDL's audio thread
+ * as it does in the app, and SDL writes every device buffer to a file instead
+ * of a sound card. SDL_DISKAUDIODELAY=0 : buffers come as fast as the callback
+ * makes them.
+ *
+ * Everything that changes from run to run is pinned:
+ *  - noise : Waveform::seed(SEED)
+ *  - clock of the control curves : GameAudio::ticks counts samples, not wall time
+ *  - input : data/golden/NAME.timeline, applied on the audio thread just before
+ *    the callback it falls in, so it lands on the same buffer every run
+ *
+ * The output is compared to data/golden/NAME.wav, one SECTION_MS slice at a time:
+ *  - bit-for-bit
+ *  - RMS of the difference, in dB relative to the reference (fail above --rms)
+ *  - log-spectral distance, in dB (fail above --lsd)
+ * and the run is timed : render speed as a multiple of real time, and time per
+ * callback, so a slower write_tape shows up here too.
+ *
+ *      make golden                     # Render each GOLDEN_NAMES, compare, print metrics
+ *      make golden-update              # Keep the current output as the reference
+ *
+ *      run-golden [--update] [--rms dB] [--lsd dB] [--dir data/golden] [--out build-golden] NAME
+ *
+ * Timeline : one event per line, "ms action values", ms from the start of the render.
+ *      mouse center_dist height        control values (0 : 1), curve ramps between points
+ *      note | note_one_shot | note_repeat
+ *      voices N                        1 : Voices::MAX_COUNT
+ *      wobble 0|1                      modulation (Nodes::setup_mod)
+ *      noise 0|1                       noise channel in the mix
+ *      end                             length of the render
+ * *******************************/
+
+namespace Golden
+{
+    constexpr Uint32 SEED = 0x5EED;
+    constexpr Uint32 START_MS = 1000;                   // Clock at sample 0 : audio time starts past 0, like a real run
+    constexpr int BUFFER = 1<<9;                        // Samples per callback (main.cpp)
+    constexpr int SECTION_MS = 500;                     // Metrics per slice of this much audio
+    constexpr int FFT_N = 1024;
+    constexpr float MAG_FLOOR = 1e-5f;                  // -100dB : spectra are compared above this
+    constexpr int MAX_EVENTS = 256;
+    enum Action { MOUSE, NOTE, NOTE_ONE_SHOT, NOTE_REPEAT, VOICES, WOBBLE, NOISE, END };
+    struct Event { Uint32 ms; Action action; float a, b; };
+    Event events[MAX_EVENTS];
+    int num_events{};
+    Uint32 length_ms{};                                 // "end"
+
+    ////////////////
+    // TIMELINE
+    ////////////////
+    bool load_timeline(const char* path)
+    { // False if missing, malformed, or without an end
+        FILE* f = fopen(path, "r");
+        if(f == NULL) { printf("Cannot open %s\n", path); return false; }
+        static const char* NAMES[] = {"mouse", "note", "note_one_shot", "note_repeat", "voices", "wobble", "noise", "end"};
+        char line[256]; int n = 0; bool ok = true;
+        while(ok && fgets(line, sizeof(line), f))
+        {
+            n++;
+            if(char* c = strchr(line, '#')) *c = '\0';
+            char name[32]; unsigned ms; float a = 0, b = 0;
+            int got = sscanf(line, "%u %31s %f %f", &ms, name, &a, &b);
+            if(got <= 0) continue;                      // Blank or comment
+            int action = -1;
+            for(int i=0; i<=END; i++) if((got >= 2) && (strcmp(name, NAMES[i]) == 0)) action = i;
+            bool args = (action == MOUSE) ? (got == 4) : ((action == VOICES) || (action == WOBBLE) || (action == NOISE)) ? (got == 3) : (got == 2);
+            // Voices::count indexes Voices::phase : same range as the keys allow
+            if((action == VOICES) && !((a >= 1) && (a <= Voices::MAX_COUNT))) args = false;
+            if((action < 0) || !args || (num_events == MAX_EVENTS) || (num_events && (ms < events[num_events-1].ms)))
+            {
+                printf("%s:%d : bad event (or out of order) : %s", path, n, line);
+                ok = false; break;
+            }
+            events[num_events++] = {ms, static_cast<Action>(action), a, b};
+            if(action == END) { length_ms = ms; break; }
+        }
+        fclose(f);
+        if(ok && (length_ms == 0)) { printf("%s : no end event\n", path); ok = false; }
+        return ok;
+    }
+    void apply(const Event& e)
+    { // Audio thread, before the callback : same code as the keys in main.cpp
+        switch(e.action)
+        {
+            case MOUSE:
+            {
+                ControlRing::Point p; p.t_ms = START_MS + e.ms;
+                p.v[UI::VCA::CENTER_DIST] = e.a; p.v[UI::VCA::HEIGHT] = e.b;
+                ControlRing::push(&UI::VCA::ring, p);
+                break;
+            }
+            case NOTE:          Envelope::enabled = false; Envelope::phase = 0;
+                                Mod::trigger(&Nodes::matrix, Nodes::ENV_FILTER); break;
+            case NOTE_ONE_SHOT: Envelope::enabled = true; Envelope::one_shot = true; Envelope::phase = 0;
+                                Mod::trigger(&Nodes::matrix, Nodes::ENV_FILTER); break;
+            case NOTE_REPEAT:   Envelope::enabled = true; Envelope::one_shot = false; Envelope::phase = 0;
+                                Mod::trigger(&Nodes::matrix, Nodes::ENV_FILTER); break;
+            case VOICES:        Voices::count = static_cast<int>(e.a); break;
+            case WOBBLE:        Nodes::setup_mod(e.a != 0); break;
+            case NOISE:
+            {
+                Patch::Graph* g = &Nodes::graph;
+                if(e.a != 0) Patch::connect(g, Nodes::Id::noise_vca, Nodes::Id::mix, 1);
+                else         Patch::disconnect(g, Nodes::Id::mix, 1);
+                Patch::publish(&Nodes::engine, g);
+                break;
+            }
+            case END: break;
+        }
+    }
+
+    ////////////////
+    // RENDER
+    ////////////////
+    Uint64 samples_done{};                              // Audio thread
+    int next_event{};
+    Uint64 samples_wanted{};
+    std::atomic<bool> done{false};
+    double callback_ms{};                               // Time in fill_audio_dev
+    int callbacks{};
+    Uint32 ticks(void) { return START_MS + static_cast<Uint32>(samples_done*1000/GameAudio::SAMPLE_RATE); }
+    void SDLCALL callback(void* userdata, Uint8* stream, int len)
+    { // Disk driver's audio thread : events due in this buffer, then the app's callback
+        if(done.load(std::memory_order_relaxed)) { memset(stream, 0, len); return; }
+        Uint32 now = ticks() - START_MS;
+        while((next_event < num_events) && (events[next_event].ms <= now)) apply(events[next_event++]);
+        Uint64 t0 = Timing::now();
+        GameAudio::fill_audio_dev(userdata, stream, len);
+        callback_ms += Timing::ms(t0, Timing::now()); callbacks++;
+        samples_done += static_cast<Uint64>(len/GameAudio::BYTES_PER_SAMPLE);
+        if(samples_done >= samples_wanted) done.store(true, std::memory_order_release);
+    }
+    bool setup(void)
+    { // Same audio state as main.cpp at startup
+        using namespace GameAudio;
+        if(!Arena::init(&arena, ARENA_SIZE)) return false;
+        Sound::len = SAMPLE_RATE*BYTES_PER_SAMPLE;      // One second of tape
+        Sound::buf = Arena::alloc_array<Uint8>(&arena, Sound::len);
+        if(Sound::buf == NULL) return false;
+        memset(Sound::buf, 0, Sound::len);
+        num_samples = BUFFER;
+        const float v[ControlRing::NUM_VALUES] = {};
+        ControlRing::init(&UI::VCA::curve, SAMPLE_RATE, v);
+        Waveform::seed(SEED);
+        GameAudio::ticks = Golden::ticks;
+        return Nodes::setup();
+    }
+    bool render(const char* raw_path, Sint16* out, Uint64 n, double* wall_ms)
+    { // n samples of the timeline through the disk driver into out
+        SDL_setenv("SDL_AUDIODRIVER", "disk", 1);
+        SDL_setenv("SDL_DISKAUDIOFILE", raw_path, 1);
+        SDL_setenv("SDL_DISKAUDIODELAY", "0", 1);
+        if(SDL_Init(SDL_INIT_AUDIO) < 0) { printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError()); return false; }
+        SDL_AudioSpec want{}, got{};
+        want.freq = GameAudio::SAMPLE_RATE; want.format = AUDIO_S16LSB; want.channels = 1;
+        want.samples = BUFFER; want.callback = callback;
+        samples_wanted = n;
+        Uint64 t0 = Timing::now();
+        SDL_AudioDeviceID dev = SDL_OpenAudioDevice(NULL, 0, &want, &got, 0);
+        if(dev == 0) { printf("line %d : SDL error msg: \"%s\"\n",__LINE__, SDL_GetError()); SDL_Quit(); return false; }
+        SDL_PauseAudioDevice(dev, 0);
+        while(!done.load(std::memory_order_acquire)) SDL_Delay(1);
+        SDL_CloseAudioDevice(dev);                      // Driver has written every buffer
+        *wall_ms = Timing::ms(t0, Timing::now());
+        SDL_Quit();
+        FILE* f = fopen(raw_path, "rb");
+        bool ok = f && (fread(out, sizeof(Sint16), n, f) == n);   // Little-endian (x86/ARM)
+        if(f) fclose(f);
+        if(!ok) printf("line %d : %s is short\n",__LINE__, raw_path);
+        return ok;
+    }
+
+    ////////////////
+    // REFERENCE
+    ////////////////
+    bool write_wav(const char* path, const Sint16* x, Uint64 n)
+    {
+        FILE* f = fopen(path, "wb");
+        if(f == NULL) return false;
+        Uint8 h[Capture::WAV_HEADER_BYTES];
+        Capture::wav_header(h, GameAudio::SAMPLE_RATE, static_cast<Uint32>(2*n));
+        bool ok = (fwrite(h, 1, sizeof(h), f) == sizeof(h)) && (fwrite(x, sizeof(Sint16), n, f) == n);
+        return (fclose(f) == 0) && ok;
+    }
+    bool read_wav(const char* path, Sint16* x, Uint64 n)
+    { // The WAV write_wav wrote : same header, n samples
+        FILE* f = fopen(path, "rb");
+        if(f == NULL) return false;
+        Uint8 h[Capture::WAV_HEADER_BYTES], want[Capture::WAV_HEADER_BYTES];
+        Capture::wav_header(want, GameAudio::SAMPLE_RATE, static_cast<Uint32>(2*n));
+        bool ok = (fread(h, 1, sizeof(h), f) == sizeof(h)) && (memcmp(h, want, sizeof(h)) == 0)
+               && (fread(x, sizeof(Sint16), n, f) == n);
+        fclose(f);
+        return ok;
+    }
+
+    ////////////////
+    // METRICS
+    ////////////////
+    double rms_db(const Sint16* got, const Sint16* ref, int n)
+    { // Difference relative to the reference. -inf : identical.
+        double err = 0, sig = 0;
+        for(int i=0; i<n; i++) { double d = got[i] - ref[i]; err += d*d; sig += 1.0*ref[i]*ref[i]; }
+        if(err == 0) return -INFINITY;
+        return 10*log10(err/(sig > 0 ? sig : 1));
+    }
+    double lsd_db(FFT::Plan* plan, const Sint16* got, const Sint16* ref, int n)
+    { // Log-spectral distance, averaged over FFT_N frames : RMS over bins of the dB difference
+        static float a[FFT_N], b[FFT_N], ma[FFT_N/2+1], mb[FFT_N/2+1];
+        double sum = 0; int frames = 0;
+        for(int start=0; start+FFT_N<=n; start+=FFT_N)
+        {
+            for(int i=0; i<FFT_N; i++) { a[i] = got[start+i]/32768.0f; b[i] = ref[start+i]/32768.0f; }
+            FFT::magnitude(plan, a, ma); FFT::magnitude(plan, b, mb);
+            double d2 = 0;
+            for(int k=0; k<=FFT_N/2; k++)
+            {
+                double d = 20*log10((ma[k] + MAG_FLOOR)/(mb[k] + MAG_FLOOR));
+                d2 += d*d;
+            }
+            sum += sqrt(d2/(FFT_N/2+1)); frames++;
+        }
+        return frames ? sum/frames : 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* dir = "data/golden";                    // --dir : timelines and references
+    const char* out_dir = "build-golden";               // --out : disk driver output
+    const char* name = NULL;
+    bool update = false;                                // --update : write the reference
+    double max_rms = -60;                               // --rms : fail above this (dB)
+    double max_lsd = 1;                                 // --lsd : fail above this (dB)
+    for(int i=1; i<argc; i++)
+    {
+        if(strcmp(argv[i], "--update") == 0)                          update = true;
+        else if((strcmp(argv[i], "--rms") == 0) && (i+1 < argc))      max_rms = atof(argv[++i]);
+        else if((strcmp(argv[i], "--lsd") == 0) && (i+1 < argc))      max_lsd = atof(argv[++i]);
+        else if((strcmp(argv[i], "--dir") == 0) && (i+1 < argc))      dir = argv[++i];
+        else if((strcmp(argv[i], "--out") == 0) && (i+1 < argc))      out_dir = argv[++i];
+        else if((argv[i][0] != '-') && (name == NULL))                name = argv[i];
+        else { name = NULL; break; }
+    }
+    if(name == NULL)
+    {
+        printf("usage: %s [--update] [--rms dB] [--lsd dB] [--dir data/golden] [--out build-golden] NAME\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    char timeline[512], ref_path[512], raw_path[512];
+    snprintf(timeline, sizeof(timeline), "%s/%s.timeline", dir, name);
+    snprintf(ref_path, sizeof(ref_path), "%s/%s.wav", dir, name);
+    snprintf(raw_path, sizeof(raw_path), "%s/%s.raw", out_dir, name);
+    if(!Golden::load_timeline(timeline)) return EXIT_FAILURE;
+    if(!Golden::setup())
+    {
+        printf("line %d : Audio setup failed\n",__LINE__);
+        return EXIT_FAILURE;
+    }
+    const Uint64 n = static_cast<Uint64>(Golden::length_ms)*GameAudio::SAMPLE_RATE/1000;
+    Sint16* got = static_cast<Sint16*>(calloc(n, sizeof(Sint16)));
+    Sint16* ref = static_cast<Sint16*>(calloc(n, sizeof(Sint16)));
+    double wall_ms = 0;
+    if((got == NULL) || (ref == NULL) || !Golden::render(raw_path, got, n, &wall_ms)) return EXIT_FAILURE;
+    double audio_ms = 1000.0*n/GameAudio::SAMPLE_RATE;
+    printf("%-12s %.2fs of audio in %.1fms (%.0fx real time), %.1fus per %d-sample callback\n",
+           name, audio_ms/1000, wall_ms, audio_ms/wall_ms,
+           1000*Golden::callback_ms/Golden::callbacks, Golden::BUFFER);
+    if(update)
+    {
+        if(!Golden::write_wav(ref_path, got, n)) { printf("line %d : Cannot write \"%s\"\n",__LINE__, ref_path); return EXIT_FAILURE; }
+        printf("Wrote reference %s\n", ref_path);
+        return EXIT_SUCCESS;
+    }
+    if(!Golden::read_wav(ref_path, ref, n))
+    {
+        printf("No reference %s for this timeline (make golden-update)\n", ref_path);
+        return EXIT_FAILURE;
+    }
+    if(memcmp(got, ref, n*sizeof(Sint16)) == 0) { printf("%-12s identical to %s\n", name, ref_path); return EXIT_SUCCESS; }
+    FFT::Plan plan;
+    if(!FFT::init(&plan, Golden::FFT_N)) { printf("line %d : Out of memory\n",__LINE__); return EXIT_FAILURE; }
+    printf("%-12s differs from %s\n", name, ref_path);
+    printf("%-16s %12s %12s\n", "section", "rms (dB)", "lsd (dB)");
+    int failed = 0;
+    const int section = Golden::SECTION_MS*GameAudio::SAMPLE_RATE/1000;
+    for(Uint64 start=0; start<n; start+=section)
+    {
+        int len = static_cast<int>((n - start < static_cast<Uint64>(section)) ? n - start : section);
+        double rms = Golden::rms_db(got+start, ref+start, len);
+        double lsd = Golden::lsd_db(&plan, got+start, ref+start, len);
+        bool bad = (rms > max_rms) || (lsd > max_lsd);
+        failed += bad;
+        char span[32]; snprintf(span, sizeof(span), "%.1f-%.1fs", 1.0*start/GameAudio::SAMPLE_RATE, 1.0*(start+len)/GameAudio::SAMPLE_RATE);
+        printf("%-16s %12.1f %12.3f%s\n", span, rms, lsd, bad ? "  FAIL" : "");
+    }
+    FFT::destroy(&plan);
+    printf("%d of %d sections over --rms %.0fdB or --lsd %.1fdB\n", failed, static_cast<int>((n + section - 1)/section), max_rms, max_lsd);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -2,6 +2,28 @@
 #include "SDL.h"
 #include "SDL_ttf.h"
 #include "mg_colors.h"
+#include "mg_timing.h"
+#include "mg_glyph_atlas.h"
+#include "mg_draw_list.h"
+#include "mg_raster.h"
+#include "mg_upscale.h"
+#include "mg_tex_cache.h"
+#include "mg_sprites.h"
+#include "mg_snapshot_ring.h"
+#include "mg_fft.h"
+#include "mg_input_map.h"
+#include "mg_control_ring.h"
+#include "mg_log.h"
+#include "mg_profile.h"
+#include "mg_replay.h"
+#include "mg_gtow.h"
+#include "mg_arena.h"
+#include "mg_patch.h"
+#include "mg_mod.h"
+#include "mg_hot.h"
+#include "mg_audio_device.h"
+#include "synth.h"
+#include "preset.h"
 
 /* *************Audio Tasks***************
    [x] make my own audio data instead of audio from file
@@ -57,13 +79,12 @@
  * - if I don't hear "jumps" in the audio level, then latency is good
  * *******************************/
 
-constexpr bool DEBUG    = true;                         // True: general debug prints
-constexpr bool DEBUG_UI = true;                         // True: print unused UI events
-constexpr bool DEBUG_AUDIO = true;                      // True: audio debug prints
+// Debug prints are LOG() calls, compiled in or out with make LOG_LEVEL=... (see mg_log.h)
+constexpr bool DEBUG    = Log::enabled(Log::DEBUG, Log::APP);    // True: general debug prints
+constexpr bool DEBUG_UI = Log::enabled(Log::TRACE, Log::UI);     // True: print unused UI events
+constexpr bool DEBUG_AUDIO = Log::enabled(Log::DEBUG, Log::AUDIO); // True: audio debug prints
 constexpr bool AUDIO_CALLBACK = true;                   // False : queue audio instead of callback
-constexpr int A_MAX = (1<<12) - 1;                      // Maximum volume of any single sound
-// Freq of 1st harmonic is UI::VCA::mouse_height*FREQ_H1_MAX
-constexpr float FREQ_H1_MAX = 220;                      // Maximum freq of 1st harmonic
+constexpr bool VSYNC = true;                            // True : SDL_RenderPresent blocks on vsync
 
 namespace Mouse
 { // Everyone wants to know about the mouse
@@ -76,41 +97,127 @@ namespace Mouse
 namespace UI
 { // If UI event code does too much, move code out and make it a flag
 
+    bool quit{};
     bool show_overlay{true};
+    bool show_scope{true};                              // Oscilloscope and spectrum in game art
+    InputMap::Map keys;                                 // Key bindings, see namespace Actions
+    Replay::Session replay;                             // MG_RECORD / MG_REPLAY
+    Preset::Loader preset;                              // preset_load reads the file off-thread
     namespace Flags
     {
         bool window_size_changed{true};
+        int resize_events{};                            // SIZE_CHANGED since last resize (for debug)
         bool mouse_moved{};
-        bool fullscreen_toggled{};
         // TODO: loop_audio only affects queued audio. Extend to callback audio.
         bool loop_audio{true};
         bool load_audio_from_file{false};               // Make my own audio in code!
         bool mouse_xy_isfloat{true};
-        bool pressed_space{};
-        bool pressed_shift_space{};
-        bool pressed_j{};
-        bool pressed_r{};
-        bool pressed_R{};
-        // Play specific notes by warping mouse to x,y with numbers
-        bool pressed_1{};
-        bool pressed_2{};
-        bool pressed_3{};
-        bool pressed_4{};
-        bool pressed_5{};
-        bool pressed_6{};
-        bool pressed_7{};
-        bool pressed_8{};
-        bool pressed_9{};
-        bool pressed_0{};
-        bool pressed_minus{};
-        bool pressed_equals{};
-        bool pressed_backspace{};
     }
     bool is_fullscreen{};
-    namespace VCA
+}
+namespace Sim
+{ // Fixed-timestep simulation : physics runs at Sim::HZ no matter the render rate
+    /* *************DOC***************
+     * The main loop polls input and runs physics in steps of Sim::dt.
+     * Rendering happens whenever the display wants a new frame.
+     *
+     * With vsync, SDL_RenderPresent paces the loop to the display. Each loop runs
+     * every physics step (and the input dispatch in it) the time since the last loop
+     * is owed, so input and VCA updates happen at Sim::HZ, not at the monitor
+     * refresh rate. The audio callback does not depend on either: it gets every
+     * mouse position (see MouseInput).
+     *
+     * Without vsync (VSYNC false, or a fast replay), the loop does not block in
+     * SDL_RenderPresent. It renders on a fixed schedule of render_period instead.
+     *
+     * Rendering draws a blend of the last two physics states:
+     *
+     *      alpha = time left in accumulator / dt
+     *      drawn = prev + alpha*(curr - prev)
+     * *******************************/
+    constexpr int HZ = 240;                             // Physics steps per second
+    constexpr double dt = 1.0/HZ;                       // Seconds per physics step
+    constexpr double MAX_FRAME = 0.25;                  // Drop time after a long stall
+    double accumulator{};                               // Seconds not yet simulated
+    struct State
+    { // Everything the renderer interpolates
+        float mouse_xf, mouse_yf;
+        float mouse_center_dist, mouse_height;
+    };
+    State prev{}, curr{};
+    State capture(void)
+    { // Snapshot physics state after a step
+        return State{Mouse::xf, Mouse::yf, UI::VCA::mouse_center_dist, UI::VCA::mouse_height};
+    }
+    State lerp(float alpha)
+    { // State between prev and curr for rendering
+        auto mix = [alpha](float a, float b){ return a + alpha*(b-a); };
+        return State{
+            mix(prev.mouse_xf, curr.mouse_xf),
+            mix(prev.mouse_yf, curr.mouse_yf),
+            mix(prev.mouse_center_dist, curr.mouse_center_dist),
+            mix(prev.mouse_height, curr.mouse_height)};
+    }
+}
+namespace Metrics
+{ // Frame time and input-to-photon latency (shown in overlay)
+    Timing::Stats frame_ms;                             // Time between presents
+    Timing::Stats input_to_photon_ms;                   // Input event to present
+    Timing::Stats overlay_text_us;                      // Time to lay out and draw overlay text
+    Timing::Stats scope_us;                             // Time to copy scope samples and FFT
+    Uint64 last_present{};
+    Uint32 pending_input_ms{};                          // Oldest unpresented input (0: none)
+    void input(Uint32 event_timestamp_ms)
+    { // Remember the oldest input not on screen yet
+        if(pending_input_ms) return;
+        pending_input_ms = (event_timestamp_ms) ? event_timestamp_ms : 1; // 0 means none
+    }
+    void presented(void)
+    { // Call right after SDL_RenderPresent
+        Uint64 t = Timing::now();
+        if(last_present) frame_ms.add(Timing::ms(last_present, t));
+        last_present = t;
+        if(pending_input_ms)
+        {
+            input_to_photon_ms.add(static_cast<float>(SDL_GetTicks() - pending_input_ms));
+            pending_input_ms = 0;
+        }
+    }
+}
+namespace Startup
+{ // Milliseconds per startup step, logged once the first frame with overlay text is up
+    /* *************DOC***************
+     * Startup is ordered for time to first sound:
+     *  1. audio : SDL audio, the synth, the device, playback starts
+     *  2. window : SDL video, window, renderer, game art
+     *  3. first frame
+     * The font opens on its own thread from the start (Font), and the glyph atlas
+     * is built on the first frame after that (it needs the renderer).
+     *
+     * mark(name) ends step name : it took the time since the previous mark.
+     * add(name, ms) is for steps that ran beside the others (the font thread).
+     * *******************************/
+    constexpr int MAX_STEPS = 16;
+    struct Step { const char* name; float ms; };
+    Step steps[MAX_STEPS];
+    int num_steps{};
+    Uint64 t0{}, last{};
+    bool first_frame{};
+    bool reported{};
+    void begin(void) { t0 = last = Timing::now(); }
+    void add(const char* name, float ms) { if(num_steps < MAX_STEPS) steps[num_steps++] = {name, ms}; }
+    void mark(const char* name)
     {
-        float mouse_center_dist;
-        float mouse_height;
+        Uint64 t = Timing::now();
+        add(name, Timing::ms(last, t));
+        last = t;
+    }
+    float since_begin(void) { return Timing::ms(t0, Timing::now()); }
+    void report(void)
+    {
+        reported = true;
+        for(int i=0; i<num_steps; i++) LOG(INFO, APP, "Startup : %-22s %7.1fms", steps[i].name, steps[i].ms);
+        LOG(INFO, APP, "Startup : %-22s %7.1fms", "total", since_begin());
     }
 }
 namespace UnusedUI
@@ -122,7 +229,7 @@ namespace UnusedUI
          * event_type_str : "SDL_AUDIODEVICEADDED"
          * event_timestamp_ms : e.common.timestamp
          * *******************************/
-        printf("line %d :\tUnused %s\tat %dms\n",
+        LOG(TRACE, UI, "line %d :\tUnused %s\tat %dms",
                 line_num, event_type_str, event_timestamp_ms);
     }
 }
@@ -130,7 +237,7 @@ namespace UnknownUI
 {
     void msg(int line_num, const char* event_type_str, const char* event_id_str, Uint32 event_id)
     { // Message content for unknown UI events
-        printf("line %d :\tUnknown %s\t%s: %d\n",
+        LOG(TRACE, UI, "line %d :\tUnknown %s\t%s: %d",
                 line_num, event_type_str, event_id_str, event_id);
     }
 }
@@ -153,393 +260,187 @@ namespace GameArt
     constexpr int w = AspectRatio::w * scale;
     constexpr int h = AspectRatio::h * scale;
 
-    SDL_Texture *tex;
+    DrawList::List dl;                                  // Batch all game art in one draw call
+    constexpr int MAX_QUADS = 1<<15;                    // Room in dl before it has to flush (20k sprites)
+
+    ///////////////////
+    // CPU RASTER
+    ///////////////////
+    // Software renderer (no GPU) : draw game art on the CPU into cv and upscale only the
+    // rows that changed into GameWin::tex, instead of going through SDL render targets.
+    // Default: on for the software renderer. Override with env MG_CPU_RASTER=0 or 1.
+    bool cpu_raster{};
+    Raster::Canvas cv;
 }
-namespace GameWin
-{ // Size of actual game in the OS window -- pixel_size > 1 makes it chunky
-    int w = GameArt::w * GameArt::pixel_size;
-    int h = GameArt::h * GameArt::pixel_size;
+namespace Overlay
+{ // Debug/help overlay text drawn from a glyph atlas
+    GlyphAtlas::Atlas atlas;                            // Built once from the font
+    GlyphAtlas::Text text;                              // Re-laid out only when text changes
+    char stats[256];                                    // Metrics text, updated a few times a second
+    Uint64 stats_t{};                                   // When stats text was last updated
+    constexpr double STATS_PERIOD = 0.25;               // Seconds between stats updates
 }
-void write_tape(Uint8* wpos, Uint32 NUM_SAMPLES);
-namespace GameAudio
-{
-    SDL_AudioDeviceID dev;                              // Audio playback device handle
-    Uint32 dev_buf_size{};                              // Audio buffer size in bytes
-    Uint32 num_samples{};                               // Audio buffer size in samples
-
-    // For audio I make (not audio from file)
-    constexpr int SAMPLE_RATE = 44100;                  // 44100 samples per second
-    constexpr int BYTES_PER_SAMPLE = 2;                 // 16-bit audio
-
-    namespace Sound
+namespace Flame
+{ // Overlay timeline : one stacked bar per frame, one color per profile zone
+    /* *************DOC***************
+     * Bars are CPU time per frame, oldest on the left. Audio runs on its own thread
+     * but stacks on the same bar, so a bar can be taller than the frame took.
+     * The line across the bars is one frame at the display refresh rate.
+     * *******************************/
+    Profile::Timeline tl;
+    GlyphAtlas::Text legend;                            // Zone names under the bars
+    const char* NAMES[] = {"events", "physics", "scope", "art", "window", "overlay", "present", "audio"};
+    constexpr SDL_Color COLORS[] = {
+        Colors::lime, Colors::tardis, Colors::dalespale, Colors::orange,
+        Colors::saltwatertaffy, Colors::dress, Colors::taffy, Colors::toffee};
+    constexpr int NUM = sizeof(NAMES)/sizeof(NAMES[0]);
+    constexpr int BAR_W = 4;                            // Pixels per frame
+    constexpr int W = Profile::FRAMES*BAR_W;
+    void setup(void)
     {
-        Uint8* buf = NULL;                              // Sound buffer in memory
-        Uint32 len{};                                   // Number of bytes in buffer
-        // For callback (from loopwave.c)
-        int pos{};                                      // Position rel to start of buffer
+        for(int i=0; i<NUM; i++) Profile::add_name(&tl, NAMES[i]);
     }
-
-    // Callback : from loopwave.c
-    void SDLCALL fill_audio_dev(void* userdata, Uint8* stream, int len)
-    { // Copied from libsdl.org/SDL2/test/loopwave.c
-        // The example code is nice and general: source buffer size is decoupled from device
-        // buffer size. But why should I care? Why not just let source buffer always be an
-        // exact multiple of device buffer size? Like 10x? That would eliminate checking for
-        // the wraparound, which makes the code much simpler.
-        // TODO: try that. Any difference?
-        // TODO: change callback name to "read_tape_callback"
-        //       SDL callback where the audio device reads in the next bit of audio tape.
-        //       The callback then writes the bit of audio tape just after the bit that was
-        //       read.
-
-        /* *************DOC***************
-         * userdata : stuff I pass to callback, no use for this yet
-         * stream : audio device buffer
-         * len : size of audio device buffer
-         *
-         * Usually, this callback just does this:
-         *
-         *      // Get position in the audio tape
-         *      play_head = Sound::buf + Sound::pos;        // Source byte I'm up to
-         *
-         *      // Copy a len-sized bit from the tape to the audio device
-         *      SDL_memcpy(stream, play_head, len);
-         *
-         *      // Update the position in the audio tape
-         *      Sound::pos += len;
-         *
-         * Eventually, the audio tape reaches the end, or close to it.
-         * This is when the tape left is less than the audio device buffer size.
-         *
-         *      // How much tape is left?
-         *      tapeleft = Sound::len - Sound::pos;         // Source bytes until wrap around
-         *
-         *      // Is it enough to fill the device buffer?
-         *      if(tapeleft < len)
-         *      {
-         *          ...
-         *
-         * When that happens, first just copy whatever is left:
-         *
-         *      if(tapeleft < len)
-         *      {
-                    SDL_memcpy(stream, play_head, tapeleft);
-         *      }
-         *
-         *      // Update device buffer position and remaining space to fill
-         *      stream += tapeleft; len -= tapeleft;
-         *
-         * Note, the len will reset to the full buffer size the next time the callback is
-         * called. The function takes int len, not int* len. Similarly, the stream will
-         * reset to point at the start of the stream because the function takes Uint*
-         * stream, not Uint** stream.
-         *
-         *      // Tape wraparound 
-         *      play_head = Sound::buf;
-         *      tapeleft = Sound::len;
-         *      Sound::pos = 0;
-         *
-         *      // Copy a len-sized bit from the tape to the audio device
-         *      SDL_memcpy(stream, play_head, len);
-         *
-         *      // Update the position in the audio tape
-         *      Sound::pos += len;
-         *
-         * Note these last two lines read the same as the usual non-wraparound case, so it
-         * is the same code. But when these lines happen after a wraparound, stream and len
-         * are different from the usual values. stream is somewhere inside the device buffer
-         * and len is less than the buffer length.
-         * *******************************/
-        { // Copy from Sound::buf to audio device
-            (void)userdata;
-            Uint8* play_head; int tapeleft;
-            /* *************DOC***************
-             * This callback loads from the source buffer (audio tape) into the device
-             * buffer.
-             *
-             * The source buffer is much larger than the device buffer.
-             *      Say the device buffer is 4096 mono 16-bit samples.
-             *      That's 2^12 * 2 bytes, or 8192 bytes.
-             *      For a stereo wav file, the device buffer is double that (8192 bytes for
-             *      each channel).
-             *      Playing that at 44100 samples per second, the device buffer holds only
-             *      about 92ms of audio.
-             *      For generating audio from UI events, the device buffer should be smaller
-             *      to avoid latency (delay between when event happens and when sound
-             *      updates). UI events are handled once per frame, at 60 FPS that is about
-             *      16ms. For mono 16-bit samples at 44100 samples per second, use 2^9
-             *      samples. 2^9 samples * 2 bytes is 1024 bytes. This is a latency of
-             *      512/44100 = 0.01161 seconds, about 12ms, which means the callback
-             *      happens about once per frame. Any faster would be overkill (UI events
-             *      don't get processed any faster). And the latency feels OK.
-             *      So the device buffer is something like 512 samples or 4096 samples,
-             *      depending on whether I care about latency or if I just default to
-             *      whatever the wav file sample size is.
-             *
-             *      Say the source buffer is one seconds worth of audio.
-             *      Playing that at 44100 samples per second, the source buffer holds 44100
-             *      samples. The source buffer is 86x to 10x bigger than the device buffer.
-             *
-             *      Since these are mono 16-bit samples, that's just 2 bytes per sample,
-             *      so the source buffer is 88,200 bytes.
-             *      That's big, but not crazy big. It's 200 bytes larger than what I've been
-             *      playing with in my initial tests.
-             *
-             *      Allocate that when the program starts and only deallocate at shutdown.
-             *      It can definitely be smaller, I just don't have a good sense of the
-             *      constraints yet. But it's fine at this size, so just go for it.
-             *
-             * I normally have no access to the device buffer.
-             * This callback lets me access its starting address and its length.
-             *
-             * userdata : no use for this yet
-             * stream : starting address of the audio device byte buffer
-             * len : length of the audio device byte buffer
-             *
-             * Sound::buf is my audio source.
-             * Sound::len is the number of bytes in my source.
-             *
-             * Sound::buf is an absolute address.
-             * Sound::pos and Sound::len are relative to Sound::buf.
-             *
-             * Similarly, "stream" is an absolute address and "len" is relative to stream.
-             *
-             * 0               16              42 <--- Silly example numbers
-             * Sound::buf      Sound::pos      Sound::len
-             * ┬─────────      ┬─────────      ─────────┬
-             * ↓               ↓                        ↓
-             * ┌─────────────────────────────────────────┐
-             * 0               x                        !│
-             * └─────────────────────────────────────────┘
-             * ---------------SOURCE BUFFER---------------
-             *
-             * 0
-             * stream       len
-             * ┬─────       ──┬
-             * ↓              ↓
-             * ┌───────────────┐
-             * 0              !│
-             * └───────────────┘
-             * --DEVICE BUFFER--
-             *
-             * Here is an example of how this plays out using made-up tiny numbers.
-             *
-             * len = 16 unless otherwise noted
-             *
-             * SDL_memcpy(stream, play_head, len)
-             * |               SDL_memcpy(stream, play_head, len)
-             * |               |               SDL_memcpy(stream, play_head, tapeleft)
-             * |               |               |                             = 10
-             * |               |               |         SDL_memcpy(stream, play_head, len)
-             * |               |               |         |                  = 0      = 6
-             * |               |               |         |     SDL_memcpy(stream, play_head, len)
-             * |               |               |         |     |               SDL_memcpy(stream, play_head, len)
-             * |               |               |         |     |               |               SDL_memcpy(stream, play_head, tapeleft)
-             * |               |               |         |     |               |               |                             = 4
-             * v               v               v         v     v               v               v
-             * 0               16              32        0     6               22              38
-             * play_head       play_head  play_head  play_head play_head       play_head       play_head
-             * ┬──────         ┬──────    ─────┬──── ────┬──── ┬────────       ┬──────         ┬──────
-             * ↓               ↓               ↓         ↓     ↓               ↓               ↓
-             * ┌───────────────|───────────────|─────────┌─────|───────────────|───────────────|───┐
-             * 0              !0              !0        !0    !0              !0              !0   │
-             * └───────────────|───────────────|─────────└─────────────────────|───────────────|───┘
-             * 0--------------SOURCE BUFFER--------------0--------------SOURCE BUFFER--------------
-             * ┌───────────────┌───────────────┌─────────|─────┌───────────────┌───────────────┐
-             * 0              !0              !0        !0    !0              !0              !│
-             * └───────────────└───────────────└─────────|─────└───────────────└───────────────┘
-             * 0-DEVICE BUFFER-0-DEVICE BUFFER-0-DEVICE BUFFER-0-DEVICE BUFFER-0-DEVICE BUFFER-
-             * *******************************/
-            play_head = Sound::buf + Sound::pos;        // Source byte I'm up to
-            tapeleft = Sound::len - Sound::pos;         // Source bytes until wrap around
-            if(tapeleft <= len)
-            { // Near end of Sound::buf, copy the last bit of sound to device
-                /* *************DOC***************
-                 * tapeleft : amount of audio left until the "end of the tape"
-                 * len : size of audio device buffer (tiny compared to size of audio tape)
-                 *
-                 * See my sketch above that shows this branch is the wraparound case.
-                 *
-                 * ******************************/
-                // Copy from Sound::buf to audio device buffer
-                SDL_memcpy(stream, play_head, tapeleft);
-                // Advance audio device buffer
-                stream += tapeleft;
-                // Update remaining space in audio device buffer
-                len -= tapeleft;
-                // Wrap back around to start of Sound::buf
-                // Point at start of Sound::buf
-                play_head = Sound::buf;
-                tapeleft = Sound::len;
-                Sound::pos = 0;
+    void draw(DrawList::List* dl, int x, int y, int h, float frame_ms)
+    { // Bars in x : x+W, y : y+h. Full height is two frames.
+        for(int f=0; f<Profile::FRAMES; f++)
+        {
+            const float* ms = tl.ms[(tl.newest + 1 + f) % Profile::FRAMES];
+            float bot = static_cast<float>(y + h);
+            for(int i=0; i<NUM; i++)
+            {
+                float bar_h = ms[i]/(2*frame_ms)*h;
+                if(bot - bar_h < y) bar_h = bot - y;    // Clip at top
+                DrawList::fill_rect(dl, static_cast<float>(x + f*BAR_W), bot - bar_h,
+                        BAR_W-1, bar_h, COLORS[i]);
+                bot -= bar_h;
             }
-            SDL_memcpy(stream, play_head, len);
-            Sound::pos += len;
         }
-        { // Write next bit of sound for consumption in next callback
-            Uint8* write_head = Sound::buf + Sound::pos;// write_head : walk Sound::buf
-            int NUM_SAMPLES = GameAudio::num_samples;   // Samples I want to write
-
-            int bytesleft = Sound::len - Sound::pos;    // Bytes until wraparound
-            int samplesleft=bytesleft/BYTES_PER_SAMPLE; // Samples until wraparound
-            if(samplesleft <  NUM_SAMPLES)
-            { // Not enough room: write part of it, then wraparound and write the rest
-                write_tape(write_head, samplesleft);       // Final write before wrap around
-                // Set up to write the rest after wraparound
-                NUM_SAMPLES -= samplesleft;
-                write_head = Sound::buf;                      // Point back at start of Sound::buf
-            }
-            if(0)
-            { // Debug prints! Show samplesleft and NUM_SAMPLES
-                printf("%d : samplesleft: %d\n",__LINE__, samplesleft);
-                printf("%d : NUM_SAMPLES: %d\n",__LINE__, NUM_SAMPLES);
-                fflush(stdout);
-            }
-            // Write the rest (or all of it if there was enough room)
-            write_tape(write_head, NUM_SAMPLES);           // Usually a full dev buf write
+        SDL_Color c = Colors::snow; c.a = 128;
+        DrawList::fill_rect(dl, static_cast<float>(x), static_cast<float>(y + h/2),
+                static_cast<float>(W), 1, c);
+    }
+    void draw_legend(DrawList::List* dl, const GlyphAtlas::Atlas* a, int x, int y)
+    { // Names with a color swatch under each (call before flushing dl)
+        char str[128] = "";
+        for(int i=0; i<NUM; i++)
+        {
+            if(i) strncat(str, " ", sizeof(str)-strlen(str)-1);
+            strncat(str, NAMES[i], sizeof(str)-strlen(str)-1);
+        }
+        GlyphAtlas::layout(&legend, a, str, x, y, W, Colors::snow);
+        const int space = a->glyph[' '-GlyphAtlas::FIRST].advance;
+        for(int i=0; i<NUM; i++)
+        {
+            int w = GlyphAtlas::word_w(a, NAMES[i]);
+            DrawList::fill_rect(dl, static_cast<float>(x), static_cast<float>(y + a->line_skip),
+                    static_cast<float>(w), 2, COLORS[i]);
+            x += w + space;
         }
     }
 }
-namespace Voices
-{ // Track phase value for each voice in the periodic waveform
-    constexpr int MAX_COUNT = 8;
-    int count = 1;
-    float phase[MAX_COUNT]{};                               // [0:1] : location in waveform
+namespace GameWin
+{ // Size of actual game in the OS window -- pixel_size > 1 makes it chunky
+    int w = GameArt::w * GameArt::pixel_size;
+    int h = GameArt::h * GameArt::pixel_size;
 }
-namespace Waveform
-{
-    ////////////
-    // WAVEFORMS
-    ////////////
-    // Waveforms:
-    // - return a float in range -0.5 to 0.5
-    // - use phase to calculate the return value (if waveform is periodic)
-    float sawtooth(float phase) { return (-0.5*(1-phase)) + (0.5*phase); }
-    float noise(void) { return (static_cast<float>(rand())/RAND_MAX) - 0.5; }
-    void advance(float* phase, float freq)
-    {
-        /* *************DOC***************
-         * phase : time location [0:1] in one period of the waveform
-         * freq : float [Hz] of waveform
-         *
-         * Advance the waveform phase based on the frequency parameter.
-         *
-         * Advance the phase by some fraction of a period.
-         * The fraction of a period is in units of [Periods per Sample]:
-         *               freq / SAMPLE_RATE        = Fraction of a period
-         * Periods per second / Samples per second = Periods per Sample
-         *
-         * WHEN phase hits 1:
-         * - reached end of period
-         * - DO NOT reset phase to zero!
-         * - Subtract 1 instead
-         * - This allows the phase to "wraparound"
-         * - If I reset phase to zero, freq is noticeably quantized at high freq
-         * *******************************/
-        *phase += (freq / static_cast<float>(GameAudio::SAMPLE_RATE));
-        if(*phase >= 1) *phase -= 1;
+namespace Scope
+{ // Oscilloscope and spectrum of the latest samples written to the audio tape
+    /* *************DOC***************
+     * write_tape() (audio thread) copies every sample it writes into Scope::ring.
+     * Once per rendered frame, Scope::update() (UI thread) copies the latest N
+     * samples out of the ring and takes their spectrum.
+     *
+     * The audio thread never waits on the UI thread: see mg_snapshot_ring.h.
+     * *******************************/
+    constexpr int N = 4096;                             // Samples in view = FFT size
+    FFT::Plan fft;
+    Sint16 snap[N];                                     // Latest N samples
+    float x[N];                                         // Same samples as float [-1:1]
+    float mag[N/2+1];                                   // Spectrum : sine at full scale is 1
+    bool valid{};                                       // True once snap has good samples
+    void update(void)
+    { // Copy latest samples from the audio thread, compute spectrum
+        if(!SnapshotRing::read_latest(&ring, snap, N)) return; // Keep last good view
+        for(int i=0; i<N; i++) x[i] = snap[i]/32768.0f;
+        FFT::magnitude(&fft, x, mag);
+        valid = true;
     }
 }
-namespace Envelope
-{
-    bool enabled{};
-    float phase = 1;
-    bool one_shot{true};
-    ////////////
-    // ENVELOPES
-    ////////////
-    // Envelopes:
-    // - return a float in range 0 to 1
-    // - use phase to calculate the return value (if waveform is periodic)
-    float straight_R(float phase) { return 1-phase; } // Linear release
-    void advance(float* phase, float period)
+namespace MouseInput
+{ // Every mouse motion event, converted to VCA controls once per physics step
+    /* *************DOC***************
+     * Event loop : on the first SDL_MOUSEMOTION, drain() pulls all queued motion
+     * events with SDL_PeepEvents and add()s each (time, x, y) to a ring. That is all
+     * the work per event.
+     *
+     * Physics step : update() converts every new position to GameArt coordinates and
+     * VCA values, and pushes those to UI::VCA::ring for the audio thread. The last
+     * position also sets Mouse:: and UI::VCA:: for the game.
+     * *******************************/
+    constexpr int BATCH = 64;                           // Events per SDL_PeepEvents
+    constexpr Uint32 SIZE = 256;                        // Positions in ring (power of 2)
+    struct Pos { Uint32 t_ms; Sint32 x, y; };           // Window coordinates
+    Pos ring[SIZE];
+    Uint32 head{}, tail{};                              // Only the UI thread uses this ring
+    int batch_count{};                                  // Events in last drain (for debug)
+    void add(const SDL_MouseMotionEvent& m)
     {
-        if (enabled)
+        if(head - tail == SIZE) tail++;                 // Full : lose the oldest
+        ring[head++ & (SIZE-1)] = Pos{m.timestamp, m.x, m.y};
+        Mouse::motion = m;
+        UI::Flags::mouse_moved = true;
+    }
+    void drain(const SDL_Event& first)
+    { // Add first event, then every motion event still in the queue
+        add(first.motion);
+        batch_count = 1;
+        SDL_Event batch[BATCH]; int n;
+        while((n = SDL_PeepEvents(batch, BATCH, SDL_GETEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION)) > 0)
         {
-            float freq = 1/period;
-            *phase += (freq / static_cast<float>(GameAudio::SAMPLE_RATE));
-            if(*phase >= 1)
-            {
-                if(one_shot)
-                { // Envelope is single-shot
-                    *phase = 1;
-                    enabled = false;
-                }
-                else
-                { // Envelope loops
-                    *phase = 0;
-                    enabled = true;
-                }
-            }
+            for(int i=0; i<n; i++) { add(batch[i].motion); Replay::input(&UI::replay, batch[i]); }
+            batch_count += n;
         }
     }
-}
-void write_tape(Uint8* wpos, Uint32 NUM_SAMPLES)
-{ // Write `NUM_SAMPLES` to position `wpos` in audio tape
-    // TODO: Move sound generation and amplitude stuff out to a different
-    //       function that generates the waveform samples. This function should literally
-    //       just write samples to tape -- so it will read values from somewhere, it won't
-    //       generate any samples.
-    //       The noise generation and amplitude scaling here is just a placeholder.
-    int sample;                                         // Amplitude of final mix
-    int sample_ch1;                                     // Channel 1 amplitude
-    int sample_ch2;                                     // Channel 2 amplitude
-    for(Uint32 i=0; i<NUM_SAMPLES; i++)
-    {
-        if(1) // Waveform channel : Play all Voices as a single mix of sawtooth harmonics
-        { // Parametric waveform -- use mouse to vary pitch, not amplitude
-            sample_ch1 = 0;                             // Reset next sample to 0
-            for(int i=0; i<Voices::count; i++)
-            { // Add the sample for each voice (harmonic)
-                // Get waveform value for this voice
-                float a = Waveform::sawtooth(Voices::phase[i]);
-                // Amplitude and frequency depend on which harmonic this is
-                int harmonic = i+1;                     // harmonic : simple int multiple
-                // Convert to a 16-bit sample and add to this sample
-                constexpr bool ATTENUATE = false;       // False : same amplitude for all
-                if(ATTENUATE) sample_ch1 += static_cast<int>((A_MAX*a)/Voices::count);
-                else          sample_ch1 += static_cast<int>(A_MAX*a);
-                // Advance phase, get freq from mouse distance to center and harmonic
-                // freq is set by mouse height, max freq is FREQ_H1_MAX*harmonic
-                Waveform::advance(
-                        &Voices::phase[i],
-                        UI::VCA::mouse_height*FREQ_H1_MAX*harmonic);
-            }
-        }
-        if(1) // Noise channel
-        { // Noise -- mouse vary amplitude, add noise to other sounds
-            float a = Waveform::noise();
-            sample_ch2 = static_cast<int>(UI::VCA::mouse_center_dist*a*A_MAX/2);
+    void to_vca(float x, float y, float* center_dist, float* height)
+    { // Use mouse distance from game art center to set VCA
+        if(!UI::Flags::mouse_xy_isfloat)
+        { // Snap to game art pixels
+            x = SDL_floorf(x); y = SDL_floorf(y);
         }
-        if(1) // Apply Envelope
-        { // Use an envelope (retrigger with `j`)
-            float a = Envelope::straight_R(Envelope::phase);
-            sample_ch1 = static_cast<int>(sample_ch1*a);
-            sample_ch2 = static_cast<int>(sample_ch2*a);
-            Envelope::advance(&Envelope::phase, 0.2);
+        if(0)
+        { // Method 1 : Abs value diff along x axis
+          // Volume only depends on distance from center in x-direction
+            float abs_diff = x - (GameArt::w/2);
+            if(abs_diff < 0) abs_diff *= -1;
+            *center_dist = ((GameArt::w/2) - abs_diff) / static_cast<float>(GameArt::w/2);
         }
-        if(1) // Mix
-        { // Mix the channels
-            sample = sample_ch1 + sample_ch2;
+        if(1)
+        { // Method 2 : Sum of square distances from center
+          // Only silent when mouse is in the corners of the screen
+            int cx = GameArt::w/2; int cy = GameArt::h/2;
+            int max = ((cx*cx)+(cy*cy));
+            float dx = x - cx;
+            float dy = y - cy;
+            *center_dist = (max - ((dx*dx) + (dy*dy))) / static_cast<float>(max);
         }
-        // Little Endian (LSB at lower address)
-        *wpos++ = (Uint8)(sample&0xFF);      // LSB
-        *wpos++ = (Uint8)(sample>>8);        // MSB
+        *height = (GameArt::h - y) / static_cast<float>(GameArt::h);
     }
-}
-namespace GtoW
-{ // Coordinate transform from GameArt coordinates to Window coordinates
-    /* *************DOC***************
-     * W = (k*G) + Offset
-     * G = (W - Offset)/k
-     * Offset = W - (k*G)
-    *******************************/
-    namespace Offset
-    {
-        int x=0;
-        int y=0;
+    void update(void)
+    { // Convert new positions, send them to audio, keep the latest for the game
+        float xf = Mouse::xf, yf = Mouse::yf;
+        for(; tail != head; tail++)
+        {
+            const Pos& p = ring[tail & (SIZE-1)];
+            GtoW::to_game(p.x, p.y, GameArt::w, GameArt::h, &xf, &yf);
+            ControlRing::Point pt; pt.t_ms = p.t_ms;
+            to_vca(xf, yf, &pt.v[UI::VCA::CENTER_DIST], &pt.v[UI::VCA::HEIGHT]);
+            ControlRing::push(&UI::VCA::ring, pt);
+            UI::VCA::mouse_center_dist = pt.v[UI::VCA::CENTER_DIST];
+            UI::VCA::mouse_height = pt.v[UI::VCA::HEIGHT];
+        }
+        Mouse::xf = xf; Mouse::yf = yf;
+        Mouse::x = static_cast<Sint32>(xf); Mouse::y = static_cast<Sint32>(yf);
     }
-    int scale = GameArt::pixel_size;
 }
 struct WindowInfo
 { // OS Window size and flags
@@ -551,6 +452,147 @@ SDL_Window* win;
 SDL_Renderer* ren;
 TTF_Font* ttf;
 
+namespace Font
+{ // Open ttf on its own thread : startup does not wait for it (see Startup)
+    const char* PATH = "ProggyClean.ttf";
+    constexpr int SIZE = 36;                            // Point size
+    enum State { LOADING, LOADED, FAILED };
+    SDL_Thread* thread{};
+    std::atomic<int> state{LOADING};
+    char error[256];                                    // SDL error on the font thread
+    float ms{};                                         // Time the font thread took
+    int SDLCALL load(void*)
+    {
+        Uint64 t0 = Timing::now();
+        if(TTF_Init() == 0) ttf = TTF_OpenFont(PATH, SIZE);
+        if(ttf == NULL) snprintf(error, sizeof(error), "%s", SDL_GetError());
+        ms = Timing::ms(t0, Timing::now());
+        state.store(ttf ? LOADED : FAILED, std::memory_order_release);
+        return 0;
+    }
+    bool start(void)
+    {
+        thread = SDL_CreateThread(load, "font", NULL);
+        return thread != NULL;
+    }
+    State poll(void)
+    { // Main thread : ttf may be used once this says LOADED
+        return static_cast<State>(state.load(std::memory_order_acquire));
+    }
+    void finish(void) { if(thread) SDL_WaitThread(thread, NULL); thread = NULL; }
+}
+namespace World
+{ // Sprite demo : a tilemap bigger than the game art, a camera panning over it, sprites bouncing
+    /* *************DOC***************
+     * T shows it behind the placeholder art. MG_SPRITES=N sets how many sprites
+     * (default 2000, up to MAX_ACTORS).
+     *
+     * The map is twice the game art each way, so chunk culling has chunks to skip.
+     * Sprites move once per physics step and are drawn where they are (no lerp).
+     * *******************************/
+    constexpr int TILE = 8;                             // Tile and sprite size
+    constexpr int MAP_W = 2*GameArt::w/TILE;            // Map size in tiles
+    constexpr int MAP_H = 2*GameArt::h/TILE;
+    constexpr int MAX_ACTORS = 20000;
+    bool show{};
+    Sprites::Sheet sheet;                               // sheet.tex : see Textures::sprites
+    Sprites::Tilemap map;
+    Sprites::Layer actors;
+    SDL_FPoint* vel;                                    // Pixels per second, one per actor
+    SDL_Rect view{0, 0, GameArt::w, GameArt::h};        // Camera, world pixels
+    double t{};                                         // Seconds simulated
+    enum Tile : Uint8 { EMPTY, BRICK, GRASS };
+    const char* BRICK_ART[TILE] = {
+        "########", "#ooo#ooo", "#ooo#ooo", "########",
+        "oo#ooo#o", "oo#ooo#o", "########", "#ooo#ooo"};
+    const char* GRASS_ART[TILE] = {
+        "#.#..#.#", "########", "oooooooo", "oo.ooooo",
+        "oooooo.o", "oooooooo", "o.oooooo", "oooooooo"};
+    const char* GHOST_ART[TILE] = {
+        "..####..", ".######.", "#o##o###", "#o##o###",
+        "########", "########", "########", "#.##.##."};
+    const char* COIN_ART[TILE] = {
+        "........", "..####..", ".##oo##.", ".#o##o#.",
+        ".#o##o#.", ".##oo##.", "..####..", "........"};
+    int art(const char* rows[TILE], SDL_Color a, SDL_Color b)
+    { // Image from text : '.' clear, '#' is a, 'o' is b
+        Uint32 px[TILE*TILE];
+        for(int y=0; y<TILE; y++)
+            for(int x=0; x<TILE; x++)
+            {
+                char c = rows[y][x];
+                px[y*TILE+x] = (c == '#') ? Raster::pack(a) : (c == 'o') ? Raster::pack(b) : 0;
+            }
+        return Sprites::add(&sheet, px, TILE, TILE, TILE);
+    }
+    bool setup(void)
+    { // Build the sheet, map and sprites. Return false if out of memory.
+        vel = (SDL_FPoint*)malloc(MAX_ACTORS*sizeof(SDL_FPoint));
+        if(  (vel == NULL) || !Sprites::init(&sheet, 64, 64)
+          || !Sprites::init(&map, MAP_W, MAP_H, TILE, TILE) || !Sprites::init(&actors, MAX_ACTORS)
+          ) return false;
+        map.tileset[BRICK] = art(BRICK_ART, Colors::darkroast, Colors::toffee);
+        map.tileset[GRASS] = art(GRASS_ART, Colors::lime, Colors::deepgravel);
+        const int ghost = art(GHOST_ART, Colors::snow, Colors::coal);
+        const int coin = art(COIN_ART, Colors::dalespale, Colors::orange);
+        for(int x=0; x<MAP_W; x++) { Sprites::set(&map, x, 0, BRICK); Sprites::set(&map, x, MAP_H-1, GRASS); }
+        for(int y=0; y<MAP_H; y++) { Sprites::set(&map, 0, y, BRICK); Sprites::set(&map, MAP_W-1, y, BRICK); }
+        for(int i=0; i<12; i++)
+        { // Platforms
+            int x0 = 4 + (i*29)%(MAP_W-16); int y = 6 + (i*7)%(MAP_H-10);
+            for(int x=x0; x<x0+8; x++) Sprites::set(&map, x, y, GRASS);
+        }
+        int num = 2000;
+        const char* env = SDL_getenv("MG_SPRITES");
+        if(env) num = atoi(env);
+        if(num > MAX_ACTORS) num = MAX_ACTORS;
+        for(int i=0; i<num; i++)
+        {
+            float x = static_cast<float>(TILE + std::rand()%(MAP_W*TILE - 3*TILE));
+            float y = static_cast<float>(TILE + std::rand()%(MAP_H*TILE - 3*TILE));
+            Sprites::Sprite* sp = Sprites::add(&actors, (i%4) ? ghost : coin, x, y);
+            SDL_Color c = Colors::list[i%SDL_arraysize(Colors::list)];
+            if(i%4) sp->tint = c;                       // Coins stay gold
+            vel[i] = SDL_FPoint{static_cast<float>(std::rand()%121 - 60), static_cast<float>(std::rand()%121 - 60)};
+        }
+        return true;
+    }
+    void step(float dt)
+    { // Bounce off the map walls, pan the camera
+        t += dt;
+        constexpr float lo = TILE; constexpr float hi_x = (MAP_W-2)*TILE; constexpr float hi_y = (MAP_H-2)*TILE;
+        for(int i=0; i<actors.num; i++)
+        {
+            Sprites::Sprite* sp = &actors.sprites[i];
+            sp->x += vel[i].x*dt; sp->y += vel[i].y*dt;
+            if((sp->x < lo) || (sp->x > hi_x)) { vel[i].x = -vel[i].x; sp->x = (sp->x < lo) ? lo : hi_x; }
+            if((sp->y < lo) || (sp->y > hi_y)) { vel[i].y = -vel[i].y; sp->y = (sp->y < lo) ? lo : hi_y; }
+        }
+        view.x = static_cast<int>((MAP_W*TILE - GameArt::w)*(0.5 + 0.5*SDL_sin(0.20*t)));
+        view.y = static_cast<int>((MAP_H*TILE - GameArt::h)*(0.5 + 0.5*SDL_sin(0.13*t)));
+    }
+    void destroy(void)
+    {
+        Sprites::destroy(&actors);
+        Sprites::destroy(&map);
+        Sprites::destroy(&sheet);
+        free(vel); vel = NULL;
+    }
+}
+namespace Textures
+{ // Every texture on the renderer : TexCache remakes them after a device reset
+    TexCache::Cache cache;
+    int art{-1};                                        // Game art render target, GameArt::w x GameArt::h
+    int win{-1};                                        // CPU raster only : game art upscaled, GameWin::w x GameWin::h
+    int atlas{-1};                                      // Overlay::atlas.tex, once the font is loaded
+    int sprites{-1};                                    // World::sheet.tex
+    SDL_Texture* make_atlas(SDL_Renderer* r, void*)
+    { // Render the glyphs (again)
+        return GlyphAtlas::build(&Overlay::atlas, r, ttf) ? Overlay::atlas.tex : NULL;
+    }
+    SDL_Texture* make_sprites(SDL_Renderer* r, void*) { return Sprites::make_texture(&World::sheet, r); }
+}
+
 namespace Notes
 { // Notes from traditional even-tempered music theory
     // Calculate 2^(i/12) for i = 0 : 12
@@ -605,34 +647,411 @@ namespace Notes
         /* float root = static_cast<float>(GameArt::h/2); */
         float game_y = GameArt::h - root*_12th_root_of_2[index];
         // Transform that to the y-value in the actual window
-        float win_y = GtoW::scale*game_y + GtoW::Offset::y;
+        float win_y = GtoW::to_win_y(game_y);
         // Keep same mouse_x, just warp mouse_y
         // Still need to transform Mouse::x from Game to Win coordinates
-        float win_x = GtoW::scale*Mouse::x + GtoW::Offset::x;
+        float win_x = GtoW::to_win_x(static_cast<float>(Mouse::x));
         SDL_WarpMouseInWindow(win, win_x, win_y);
     }
 }
+namespace SynthReload
+{ // UI side of SynthModule : load each new build/libsynth.so, release the old one once audio is off it
+    Hot::Library lib;
+    const SynthModule::Api* loaded{};                   // Api in lib.live
+    void setup(void) { Hot::watch(&lib, "build/libsynth.so"); }
+    void update(void)
+    { // Once per frame
+        if(  lib.old && (SynthModule::running.load(std::memory_order_acquire) == loaded)
+          && (Nodes::engine.pending.load(std::memory_order_acquire) < 0))
+        { // Audio runs the new write_tape, and a plan made from the new kinds
+            Hot::release_old(&lib);
+        }
+        if(!Hot::changed(&lib, SDL_GetTicks())) return;
+        Uint64 start = SDL_GetPerformanceCounter();
+        void* h = Hot::open(&lib);
+        using Get = const SynthModule::Api* (*)(void);
+        Get get = reinterpret_cast<Get>(Hot::symbol(h, "synth_module"));
+        const SynthModule::Api* api = get ? get() : NULL;
+        if(  (api == NULL) || (api->version != SynthModule::VERSION) || (api->layout != SynthModule::layout())
+          || (api->num_kinds != Nodes::NUM_KINDS))
+        {
+            LOG(WARN, AUDIO, "Cannot reload %s : %s", lib.path,
+                h ? "built from different synth state, restart the app" : lib.error);
+            Hot::close(h); return;
+        }
+        if(api->state != &Nodes::engine)
+        { // Library has its own globals : the program was not linked with -rdynamic
+            LOG(WARN, AUDIO, "Cannot reload %s : it does not share the app's synth state", lib.path);
+            Hot::close(h); return;
+        }
+        Nodes::graph.kinds = api->kinds;                // New process functions at the next block
+        Patch::publish(&Nodes::engine, &Nodes::graph);
+        SynthModule::offered.store(api, std::memory_order_release);
+        Hot::swap(&lib, h); loaded = api;
+        double ms = 1000.0*(SDL_GetPerformanceCounter() - start)/SDL_GetPerformanceFrequency();
+        LOG(INFO, AUDIO, "Reloaded %s (build %d) in %.1fms", lib.path, lib.generation, ms);
+    }
+}
+namespace AudioRecovery
+{ // UI side of AudioDevice : the output went away (unplugged), keep playing on the default one
+    AudioDevice::Device device;
+    void removed(const SDL_AudioDeviceEvent& e)
+    {
+        if(e.iscapture || (e.which != device.id)) return;
+        LOG(WARN, AUDIO, "Audio device removed, reopening the default output");
+        AudioDevice::removed(&device, e.which, e.iscapture, SDL_GetTicks());
+        GameAudio::dev = device.id;                     // 0 until reopened
+    }
+    void update(void)
+    { // Once per frame
+        switch(AudioDevice::update(&device, SDL_GetTicks()))
+        {
+            case AudioDevice::REOPENED:
+                GameAudio::dev = device.id;
+                GameAudio::reopened.fetch_add(1, std::memory_order_release);  // Fade in : no click
+                SDL_PauseAudioDevice(GameAudio::dev, 0);
+                LOG(INFO, AUDIO, "Audio device reopened after %ums", SDL_GetTicks() - device.lost_at);
+                break;
+            case AudioDevice::RETRY:
+                LOG(DEBUG, AUDIO, "No audio device yet (%s), retrying in %ums", device.error, AudioDevice::RETRY_MS);
+                break;
+            default: break;
+        }
+    }
+}
+namespace Recorder
+{ // UI side of the capture tap in synth.h : start and stop recording, report dropped blocks
+    Uint32 reported{};                                  // tap.dropped already logged
+    double seconds(Uint64 samples) { return static_cast<double>(samples)/GameAudio::SAMPLE_RATE; }
+    void stop(void)
+    {
+        if(!Capture::recording(&tap)) return;
+        bool ok = Capture::stop(&tap);
+        Uint32 dropped = tap.dropped.load(std::memory_order_relaxed);
+        if(ok) LOG(INFO, AUDIO, "Capture : wrote %.1fs, %u blocks dropped", seconds(tap.samples), dropped);
+        else   LOG(WARN, AUDIO, "Capture : file is short (%s), wrote %.1fs", tap.error[0] ? tap.error : "close failed",
+                   seconds(tap.samples));
+    }
+    void toggle(Capture::Format format)
+    { // Start recording to capture.wav or capture.flac, or stop
+        if(Capture::recording(&tap)) { stop(); return; }
+        const char* path = (format == Capture::FLAC) ? "capture.flac" : "capture.wav";
+        reported = 0;
+        if(Capture::start(&tap, path, format, GameAudio::SAMPLE_RATE)) LOG(INFO, AUDIO, "Capture : recording to %s", path);
+        else                                                             LOG(WARN, AUDIO, "Cannot record to %s", path);
+    }
+    void update(void)
+    { // Once per frame : the writer thread fell behind (disk stall), the file has gaps
+        Uint32 dropped = tap.dropped.load(std::memory_order_relaxed);
+        if(!Capture::recording(&tap) || (dropped == reported)) return;
+        LOG(WARN, AUDIO, "Capture : disk is too slow, %u blocks (%.1fs) dropped so far",
+            dropped, seconds(static_cast<Uint64>(dropped)*Capture::BLOCK));
+        reported = dropped;
+    }
+}
+namespace Actions
+{ // What keys do : one handler per action, bound to keys in UI::keys
+    /* *************DOC***************
+     * To add a key binding:
+     *  1. add an Id
+     *  2. write its handler and define() it in setup()
+     *  3. bind() a default key in setup() (users can rebind in data/keys.cfg)
+     * *******************************/
+    enum Id
+    {
+        NONE = InputMap::NONE,
+        QUIT, FULLSCREEN, OVERLAY, SCOPE, SPRITES, PROFILE_EXPORT,
+        VOICE_UP, VOICE_DOWN, PATCH_NOISE, MOD_WOBBLE,
+        PRESET_SAVE, PRESET_LOAD, CAPTURE, CAPTURE_FLAC, AUDIO_REOPEN,
+        NOTE, NOTE_ONE_SHOT, NOTE_REPEAT,
+        NOTE_0,                                         // NOTE_0 : NOTE_12 warp mouse to a pitch
+        NOTE_12 = NOTE_0 + 12,
+        COUNT
+    };
+    void quit(int) { UI::quit = true; }
+    void fullscreen(int)
+    {
+        UI::is_fullscreen = !UI::is_fullscreen;
+        if(UI::is_fullscreen)
+        { // Go fullscreen
+            // Don't bother dealing with videomode mode change
+            // SDL_WINDOW_FULLSCREEN_DESKTOP is way easier and faster than
+            // SDL_WINDOW_FULLSCREEN
+            SDL_SetWindowFullscreen(win, SDL_WINDOW_FULLSCREEN_DESKTOP);
+        }
+        else
+        { // Go back to windowed
+            SDL_SetWindowFullscreen(win, 0);
+        }
+    }
+    void overlay(int) { UI::show_overlay = !UI::show_overlay; }
+    void scope(int) { UI::show_scope = !UI::show_scope; }
+    void sprites(int)
+    { // Sprite demo on/off
+        World::show = !World::show;
+        LOG(INFO, APP, "Sprites %s : %d sprites, %dx%d tiles", World::show ? "on" : "off",
+                World::actors.num, World::MAP_W, World::MAP_H);
+    }
+    void profile_export(int)
+    { // Write the profile rings as a Chrome trace
+        const char* path = "profile.json";
+        if(Profile::export_chrome(path)) LOG(INFO, APP, "Wrote profile trace to %s", path);
+        else                             LOG(WARN, APP, "Cannot write profile trace to %s", path);
+    }
+    void voice_up(int)
+    { // Space is my go-to for things I want to play with temporarily
+        if (0) UI::Flags::mouse_xy_isfloat = !UI::Flags::mouse_xy_isfloat;
+        if (1)
+        { // Increment number of voices
+            Voices::count++;
+            if(Voices::count > Voices::UI_MAX) Voices::count = 1;
+        }
+    }
+    void voice_down(int)
+    { // Decrease voice count
+        Voices::count--;
+        if(Voices::count < 1) Voices::count = Voices::UI_MAX;
+    }
+    void patch_noise(int)
+    { // Patch the noise channel in or out of the mix (audio switches at its next block)
+        Patch::Graph* g = &Nodes::graph;
+        if(g->nodes[Nodes::Id::mix].in[1] == Patch::NO_NODE) Patch::connect(g, Nodes::Id::noise_vca, Nodes::Id::mix, 1);
+        else                                                  Patch::disconnect(g, Nodes::Id::mix, 1);
+        if(!Patch::publish(&Nodes::engine, g)) LOG(WARN, AUDIO, "Patch has a cycle, keeping the old one");
+    }
+    void mod_wobble(int)
+    { // Vibrato, filter sweep and filter envelope on or off
+        static bool wobble = false;
+        wobble = !wobble;
+        Nodes::setup_mod(wobble);
+    }
+    constexpr const char* PRESET_PATH = "data/preset.mgp";
+    constexpr const char* PRESET_TEXT = "data/preset.txt";
+    void preset_save(int)
+    { // Save the current sound, and a readable copy
+        Preset::Data d;
+        Preset::capture(&d, "preset");
+        if(Preset::save(&d, PRESET_PATH) && Preset::write_text(&d, PRESET_TEXT))
+             LOG(INFO, AUDIO, "Saved preset to %s (text : %s)", PRESET_PATH, PRESET_TEXT);
+        else LOG(WARN, AUDIO, "Cannot save preset to %s", PRESET_PATH);
+    }
+    void preset_load(int)
+    { // Load PRESET_PATH off-thread : the main loop switches to it when it is read (Preset::poll)
+        if(!Preset::load_async(&UI::preset, PRESET_PATH)) LOG(WARN, AUDIO, "Preset is still loading");
+    }
+    void capture(int) { Recorder::toggle(Capture::WAV); }
+    void capture_flac(int) { Recorder::toggle(Capture::FLAC); }
+    void audio_reopen(int)
+    { // Act as if the output was unplugged : test recovery with SDL_AUDIODRIVER=dummy or disk
+        LOG(INFO, AUDIO, "Closing the audio device to test recovery");
+        AudioDevice::lose(&AudioRecovery::device, SDL_GetTicks());
+        GameAudio::dev = AudioRecovery::device.id;
+    }
+    void note(int)
+    { // Trigger a note with no envelope (reset envelope)
+        Envelope::enabled = false;                      // Turn off envelope
+        Envelope::phase = 0;                            // Start sound
+        Mod::trigger(&Nodes::matrix, Nodes::ENV_FILTER);
+    }
+    void note_one_shot(int)
+    { // Trigger a note with one-shot envelope
+        Envelope::enabled = true;                       // Turn on envelope
+        Envelope::one_shot = true;
+        Envelope::phase = 0;                            // Trigger envelope
+        Mod::trigger(&Nodes::matrix, Nodes::ENV_FILTER);
+    }
+    void note_repeat(int)
+    { // Trigger a note with periodic envelope (repeat envelope)
+        Envelope::enabled = true;                       // Turn on envelope
+        Envelope::one_shot = false;
+        Envelope::phase = 0;                            // Start sound
+        Mod::trigger(&Nodes::matrix, Nodes::ENV_FILTER);
+    }
+    void note_N(int action)
+    { // Set note by warping mouse to xy
+        Notes::mouse_to_note(action - NOTE_0);
+    }
+    void setup(InputMap::Map* m)
+    { // Define actions and bind default keys
+        InputMap::define(m, QUIT,           "quit",           quit);
+        InputMap::define(m, FULLSCREEN,     "fullscreen",     fullscreen);
+        InputMap::define(m, OVERLAY,        "overlay",        overlay);
+        InputMap::define(m, SCOPE,          "scope",          scope);
+        InputMap::define(m, SPRITES,        "sprites",        sprites);
+        InputMap::define(m, PROFILE_EXPORT, "profile_export", profile_export);
+        InputMap::define(m, VOICE_UP,       "voice_up",       voice_up);
+        InputMap::define(m, VOICE_DOWN,     "voice_down",     voice_down);
+        InputMap::define(m, PATCH_NOISE,    "patch_noise",    patch_noise);
+        InputMap::define(m, MOD_WOBBLE,     "mod_wobble",     mod_wobble);
+        InputMap::define(m, PRESET_SAVE,    "preset_save",    preset_save);
+        InputMap::define(m, PRESET_LOAD,    "preset_load",    preset_load);
+        InputMap::define(m, CAPTURE,        "capture",        capture);
+        InputMap::define(m, CAPTURE_FLAC,   "capture_flac",   capture_flac);
+        InputMap::define(m, AUDIO_REOPEN,   "audio_reopen",   audio_reopen);
+        InputMap::define(m, NOTE,           "note",           note);
+        InputMap::define(m, NOTE_ONE_SHOT,  "note_one_shot",  note_one_shot);
+        InputMap::define(m, NOTE_REPEAT,    "note_repeat",    note_repeat);
+        static const char* note_names[] = {
+            "note_0", "note_1", "note_2", "note_3", "note_4", "note_5", "note_6",
+            "note_7", "note_8", "note_9", "note_10", "note_11", "note_12"};
+        for(int i=0; i<=12; i++) InputMap::define(m, NOTE_0+i, note_names[i], note_N);
+        InputMap::bind(m, SDLK_q,      false, QUIT);
+        InputMap::bind(m, SDLK_F11,    false, FULLSCREEN);
+        InputMap::bind(m, SDLK_SLASH,  true,  OVERLAY);    // ?
+        InputMap::bind(m, SDLK_s,      false, SCOPE);
+        InputMap::bind(m, SDLK_t,      false, SPRITES);
+        InputMap::bind(m, SDLK_p,      false, PROFILE_EXPORT);
+        InputMap::bind(m, SDLK_SPACE,  false, VOICE_UP);
+        InputMap::bind(m, SDLK_SPACE,  true,  VOICE_DOWN);
+        InputMap::bind(m, SDLK_n,      false, PATCH_NOISE);
+        InputMap::bind(m, SDLK_w,      false, MOD_WOBBLE);
+        InputMap::bind(m, SDLK_F5,     false, PRESET_SAVE);
+        InputMap::bind(m, SDLK_F9,     false, PRESET_LOAD);
+        InputMap::bind(m, SDLK_c,      false, CAPTURE);
+        InputMap::bind(m, SDLK_c,      true,  CAPTURE_FLAC);
+        InputMap::bind(m, SDLK_F7,     false, AUDIO_REOPEN);
+        InputMap::bind(m, SDLK_r,      false, NOTE);
+        InputMap::bind(m, SDLK_j,      false, NOTE_ONE_SHOT);
+        InputMap::bind(m, SDLK_r,      true,  NOTE_REPEAT);
+        // Play specific notes by warping mouse to x,y with the number row
+        const SDL_Keycode note_keys[] = {
+            SDLK_1, SDLK_2, SDLK_3, SDLK_4, SDLK_5, SDLK_6, SDLK_7,
+            SDLK_8, SDLK_9, SDLK_0, SDLK_MINUS, SDLK_EQUALS, SDLK_BACKSPACE};
+        for(int i=0; i<=12; i++) InputMap::bind(m, note_keys[i], false, NOTE_0+i);
+    }
+}
+
+template<typename Painter>
+void draw_game_art(Painter* p, const Sim::State& drawn)
+{ // Placeholder game art
+    /* *************DOC***************
+     * Painter is DrawList::List (GPU) or Raster::Canvas (CPU). Both namespaces have
+     * line(), fill_rect() and rect() taking the painter as first arg, so the calls
+     * below find the right one by argument type. Sprites::draw() takes either.
+     * *******************************/
+    if(World::show)
+    { // Sprite demo behind the placeholder art : one draw call per layer
+        Sprites::draw(p, &World::sheet, &World::map, World::view);
+        Sprites::draw(p, &World::sheet, &World::actors, World::view);
+    }
+    { // X
+        uint8_t rand_r = (uint8_t)(std::rand()%256);
+        uint8_t rand_b = (uint8_t)(std::rand()%256);
+        uint8_t rand_g = (uint8_t)(std::rand()%256);
+        SDL_Color c = {rand_r,rand_g,rand_b,128};
+
+        line(p, 0,0,GameArt::w,GameArt::h, c);
+        line(p, GameArt::w,0,0,GameArt::h, c);
+    }
+    { // Mouse location
+        SDL_Color c = Colors::lime; c.a = 128;
+        line(p, GameArt::w/2,GameArt::h/2,
+                static_cast<int>(drawn.mouse_xf),static_cast<int>(drawn.mouse_yf), c);
+    }
+    if(1)
+    { // Blue box
+        SDL_Color c = Colors::tardis;
+        c.a = static_cast<Uint8>(drawn.mouse_height*255);
+        int w = drawn.mouse_center_dist*GameArt::w;
+        int h = drawn.mouse_center_dist*GameArt::h;
+        int x = GameArt::w/2 - w/2;
+        int y = GameArt::h/2 - h/2;
+        SDL_Rect r{x,y,w,h};
+        fill_rect(p, r, c);
+    }
+    if(UI::show_scope && Scope::valid)
+    { // Oscilloscope : one vertical line per column, from min to max sample in that column
+        constexpr int cy = GameArt::h - 70;             // Center line
+        constexpr int half_h = 20;                      // One voice at A_MAX swings +/- half_h
+        constexpr float gain = half_h*32768.0f/A_MAX;
+        constexpr int per_col = Scope::N/GameArt::w;    // Samples per column
+        SDL_Color c = Colors::lime; c.a = 160;
+        for(int col=0; col<GameArt::w; col++)
+        {
+            float lo = 1, hi = -1;
+            for(int i=col*per_col; i<(col+1)*per_col; i++)
+            {
+                if(Scope::x[i] < lo) lo = Scope::x[i];
+                if(Scope::x[i] > hi) hi = Scope::x[i];
+            }
+            int y0 = cy - static_cast<int>(hi*gain); if(y0 < cy-2*half_h) y0 = cy-2*half_h;
+            int y1 = cy - static_cast<int>(lo*gain); if(y1 > cy+2*half_h) y1 = cy+2*half_h;
+            line(p, col, y0, col, y1, c);
+        }
+    }
+    if(UI::show_scope && Scope::valid)
+    { // Spectrum : bars up from the bottom, log frequency 20Hz to 20kHz, -90dB to 0dB
+        constexpr int max_h = 40;                       // Bar height at 0dB
+        constexpr float DB_MIN = -90;
+        constexpr float bin_hz = static_cast<float>(GameAudio::SAMPLE_RATE)/Scope::N;
+        constexpr int NUM_BINS = Scope::N/2+1;
+        SDL_Color c = Colors::dalespale; c.a = 128;
+        for(int col=0; col<GameArt::w; col++)
+        {
+            // Column spans f0 to f1, f = 20Hz * 1000^(col/w)
+            float f0 = 20*SDL_powf(1000, static_cast<float>(col)/GameArt::w);
+            float f1 = 20*SDL_powf(1000, static_cast<float>(col+1)/GameArt::w);
+            int k0 = static_cast<int>(f0/bin_hz); int k1 = static_cast<int>(f1/bin_hz);
+            if(k1 <= k0) k1 = k0+1;                     // Low end : many columns per bin
+            if(k1 > NUM_BINS) k1 = NUM_BINS;
+            float m = 0;
+            for(int k=k0; k<k1; k++) if(Scope::mag[k] > m) m = Scope::mag[k];
+            float db = (m > 0) ? 20*SDL_log10f(m) : DB_MIN;
+            if(db < DB_MIN) db = DB_MIN;
+            int h = static_cast<int>((db - DB_MIN)/(-DB_MIN)*max_h);
+            if(h > 0) line(p, col, GameArt::h-1, col, GameArt::h-h, c);
+        }
+    }
+    { // Show number of voices in use
+        constexpr int size = 10; int w = size; int h = size;
+        constexpr int gap = size/2;
+        int x0 = 10; int y = 10;
+        for (int i=0; i<Voices::UI_MAX; i++)
+        {
+            int x = x0 + (i*(size+gap));
+            SDL_Rect r{x,y,w,h};
+            SDL_Color c = Colors::orange;
+            if(Voices::count >= (i+1)) fill_rect(p, r, c);
+            else                       rect(p, r, c);
+        }
+    }
+}
 
 void shutdown(void)
 {
+    Replay::finish(&UI::replay);                        // Ends a recording here
+    Font::finish();                                     // Before TTF_CloseFont
+    DrawList::destroy(&GameArt::dl);
+    Raster::destroy(&GameArt::cv);
+    World::destroy();
+    FFT::destroy(&Scope::fft);
     TTF_CloseFont(ttf);
     TTF_Quit();
-    SDL_FreeWAV(GameAudio::Sound::buf);
-    SDL_CloseAudioDevice(GameAudio::dev);
-    SDL_DestroyTexture(GameArt::tex);
+    Preset::finish(&UI::preset);                        // Waits for a load still running
+    Recorder::stop();                                   // Finishes a capture file
+    AudioDevice::close(&AudioRecovery::device);         // Callback is done with the arena
+    Hot::unload(&SynthReload::lib);                     // and with the synth module
+    Arena::destroy(&GameAudio::arena);                  // Frees Sound::buf
+    TexCache::destroy(&Textures::cache);                // Game art, window, glyph atlas
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
+    Log::finish();                                      // Print the last of the log
     SDL_Quit();
 }
 
 int main(int argc, char* argv[])
 {
+    Startup::begin();
+    Log::start();                                       // LOG() never waits on stdout
+    Profile::name_thread("main");
+    Flame::setup();
     WindowInfo wI{};
     { // Window setup
         { // Window x,y,w,h defaults (use these if Vim passes no args)
             wI.x = 1000; // wI.x = 10;
             wI.y = 60;
             SDL_assert(GameArt::pixel_size >= 1);       // 1 : high-def, >1 : chunky
+            GtoW::scale = GameArt::pixel_size;          // Until first GtoW::fit()
             wI.w = GameWin::w;
             wI.h = GameWin::h + 200;                    // 200 : room for overlay
             wI.flags = SDL_WINDOW_RESIZABLE;
@@ -647,59 +1066,33 @@ int main(int argc, char* argv[])
         { // Vim passed some window info, so make window borderless and on-top-always
             wI.flags = SDL_WINDOW_BORDERLESS | SDL_WINDOW_ALWAYS_ON_TOP | SDL_WINDOW_INPUT_GRABBED;
         }
-        if(DEBUG)
-        { // Print window x,y,w,h
-            printf("Window (x,y): (%d,%d)\n", wI.x, wI.y);
-            printf("Window W x H: %d x %d\n", wI.w, wI.h);
-        }
+        // Print window x,y,w,h
+        LOG(DEBUG, APP, "Window (x,y): (%d,%d)", wI.x, wI.y);
+        LOG(DEBUG, APP, "Window W x H: %d x %d", wI.w, wI.h);
     }
-    { // SDL Setup
-        SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO);
-        // TODO: error-handle these SDL_Create calls
-        win = SDL_CreateWindow(argv[0], wI.x, wI.y, wI.w, wI.h, wI.flags);
-        ren = SDL_CreateRenderer(win,-1,SDL_RENDERER_PRESENTVSYNC|SDL_RENDERER_ACCELERATED);
-        if(argc==1)
-        { // Try setting window opacity to 50% (when run with ;r<Space>)
-            if( SDL_SetWindowOpacity(win, 0.5) < 0 )
-            { // Not a big deal if this fails.
-                if(DEBUG) printf("%d : SDL error msg: %s\n",__LINE__,SDL_GetError());
-            }
-        }
-
-        ///////////
-        // GAME ART
-        ///////////
-        if(0) SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND); // Workhorse
-        if(1) SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_ADD);   // Cool lighting effect!
-        GameArt::tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, GameArt::w, GameArt::h);
-        if(SDL_SetTextureBlendMode(GameArt::tex, SDL_BLENDMODE_BLEND) == -1)
-        { // TODO: why set tex blend mode? Makes no difference. Just ren blend mode.
-            // Maybe the idea is to set the render draw blend mode to WHATEVER the texture
-            // blend mode is?
+    { // SDL Setup : audio first (time to first sound), then the window
+        SDL_Init(SDL_INIT_AUDIO);
+        if(!Font::start())
+        { // Font opens on its thread while audio and the window start up
             printf("line %d : SDL error msg: \"%s\" ",__LINE__, SDL_GetError());
             shutdown(); return EXIT_FAILURE;
         }
-        { // Set up font
-            if( TTF_Init() <0 )
-            { // Cannot use fonts, quit
-                printf("line %d : SDL error msg: \"%s\" ",__LINE__, SDL_GetError());
-                shutdown(); return EXIT_FAILURE;
-            }
-            // TODO: load font
-            const char* path = "ProggyClean.ttf";       // font path
-            constexpr int size = 36;                    // font point size
-            ttf = TTF_OpenFont(path,size);
-            if(ttf == NULL)
-            { // Cannot open this font
-                printf("line %d : SDL error msg: \"%s\" ",__LINE__, SDL_GetError());
-                shutdown(); return EXIT_FAILURE;
-            }
-        }
+        Startup::mark("SDL audio init");
 
         /////////////
         // GAME AUDIO
         /////////////
 
+        if(!FFT::init(&Scope::fft, Scope::N))
+        {
+            printf("line %d : Out of memory for Scope::fft\n",__LINE__);
+            shutdown(); return EXIT_FAILURE;
+        }
+        if(!Arena::init(&GameAudio::arena, GameAudio::ARENA_SIZE))
+        { // Every audio buffer comes from the arena
+            printf("line %d : Out of memory for GameAudio::arena\n",__LINE__);
+            shutdown(); return EXIT_FAILURE;
+        }
         SDL_AudioSpec wav_spec{};
         // If loading from file Sound::buf is set by file size.
         // Else, making my own sound, Sound::buf is sized for 1s of audio.
@@ -708,12 +1101,22 @@ int main(int argc, char* argv[])
             const char* wav = "data/windy-lily.wav";
             /* const char* wav = "data/day01.wav"; */
             /* const char* wav = "data/Dry-Kick.wav"; */
-            if (SDL_LoadWAV(wav, &wav_spec,
-                    &GameAudio::Sound::buf, &GameAudio::Sound::len) == NULL)
+            Uint8* wav_buf; Uint32 wav_len;
+            if (SDL_LoadWAV(wav, &wav_spec, &wav_buf, &wav_len) == NULL)
             {
                 printf("line %d : SDL error msg: \"%s\" ",__LINE__, SDL_GetError());
                 shutdown(); return EXIT_FAILURE;
             }
+            // Copy into the arena : SDL_FreeWAV is the only way to free wav_buf
+            GameAudio::Sound::buf = Arena::alloc_array<Uint8>(&GameAudio::arena, wav_len);
+            GameAudio::Sound::len = wav_len;
+            if(GameAudio::Sound::buf) memcpy(GameAudio::Sound::buf, wav_buf, wav_len);
+            SDL_FreeWAV(wav_buf);
+            if(GameAudio::Sound::buf == NULL)
+            {
+                printf("line %d : %s is bigger than GameAudio::ARENA_SIZE\n",__LINE__, wav);
+                shutdown(); return EXIT_FAILURE;
+            }
         }
         else
         { // Set the audio spec manually and put my own sounds in the buffer
@@ -775,22 +1178,26 @@ int main(int argc, char* argv[])
                            /* [ bytes = Samples/sec   * bytes/sample     * sec ] */
                 GameAudio::Sound::len = wav_spec.freq * GameAudio::BYTES_PER_SAMPLE * SECONDS;
             }
-            if(DEBUG)
             { // Print Sound::buf size and audio device buffer size
-                printf("--- AUDIO SETUP (line %d) ---\n", __LINE__);
-                printf(" Audio \"source tape\" length: %6d bytes = %6d samples = %6f sec\n",
+                LOG(DEBUG, AUDIO, "--- AUDIO SETUP (line %d) ---", __LINE__);
+                LOG(DEBUG, AUDIO, " Audio \"source tape\" length: %6d bytes = %6d samples = %6f sec",
                         GameAudio::Sound::len,
                         GameAudio::Sound::len/GameAudio::BYTES_PER_SAMPLE,
                         (float)GameAudio::Sound::len/(wav_spec.freq * GameAudio::BYTES_PER_SAMPLE)
                       );
-                printf("Audio device buffer size:   %6d bytes = %6d samples = %6f sec\n",
+                LOG(DEBUG, AUDIO, "Audio device buffer size:   %6d bytes = %6d samples = %6f sec",
                         wav_spec.size,
                         wav_spec.size/GameAudio::BYTES_PER_SAMPLE,
                         (float)wav_spec.size/(wav_spec.freq * GameAudio::BYTES_PER_SAMPLE)
                         );
             }
-            { // Allocate memory for buf (memory is freed during shutdown)
-                GameAudio::Sound::buf = (Uint8*)malloc(GameAudio::Sound::len);
+            { // Allocate memory for buf (arena is freed during shutdown)
+                GameAudio::Sound::buf = Arena::alloc_array<Uint8>(&GameAudio::arena, GameAudio::Sound::len);
+                if(GameAudio::Sound::buf == NULL)
+                {
+                    printf("line %d : Sound::buf is bigger than GameAudio::ARENA_SIZE\n",__LINE__);
+                    shutdown(); return EXIT_FAILURE;
+                }
             }
             { // Start off with only enough samples to fill device buffer once.
                 GameAudio::num_samples = wav_spec.size/GameAudio::BYTES_PER_SAMPLE;
@@ -800,24 +1207,41 @@ int main(int argc, char* argv[])
                 for(Uint32 i=0; i<GameAudio::num_samples; i++) { *buf++ = 0; *buf++ = 0; }
             }
         }
+        { // write_tape() reads the mouse controls at sample rate
+            float vca[ControlRing::NUM_VALUES]{};
+            vca[UI::VCA::CENTER_DIST] = UI::VCA::mouse_center_dist;
+            vca[UI::VCA::HEIGHT] = UI::VCA::mouse_height;
+            ControlRing::init(&UI::VCA::curve, GameAudio::SAMPLE_RATE, vca);
+        }
+        if(!Nodes::setup())
+        { // write_tape() plays the patch
+            printf("line %d : Default patch does not compile\n",__LINE__);
+            shutdown(); return EXIT_FAILURE;
+        }
+        SynthReload::setup();                           // Later builds of build/libsynth.so replace the DSP code
         if(AUDIO_CALLBACK)
         { // Wire callback into SDL_AudioSpec
             wav_spec.callback = GameAudio::fill_audio_dev;
         }
         SDL_AudioSpec dev_spec{};
         { // 2. Open an audio device to match WAV specs
-            GameAudio::dev = SDL_OpenAudioDevice(NULL, 0, &wav_spec, &dev_spec, 0);
-            if(dev_spec.size != wav_spec.size)
+            GameAudio::dev = AudioDevice::open(&AudioRecovery::device, &wav_spec, &dev_spec);
+            if(GameAudio::dev == 0)
+            { // No output yet : buffers are sized for what we asked for, AudioRecovery opens it later
+                LOG(WARN, AUDIO, "No audio device (%s), starting without sound", SDL_GetError());
+                dev_spec = wav_spec;
+            }
+            else if(dev_spec.size != wav_spec.size)
             {
-                if(DEBUG) printf("%d : Audio device buffer size is %d bytes, "
-                                 "expected %d bytes\n",
+                LOG(ERROR, AUDIO, "%d : Audio device buffer size is %d bytes, "
+                                  "expected %d bytes",
                                 __LINE__, dev_spec.size, wav_spec.size
                                 );
                 shutdown(); return EXIT_FAILURE;
             }
             GameAudio::dev_buf_size = dev_spec.size;
         }
-        if(DEBUG)
+        if(DEBUG_AUDIO)
         { // Print the audio spec for audio device or audio file
 
             /* *************SDL_AudioSpec***************
@@ -853,31 +1277,31 @@ int main(int argc, char* argv[])
             if(0)
             { // wav_spec
                 spec = wav_spec;
-                puts("\n--- Audio file audio spec ---\n");
+                LOG(DEBUG, AUDIO, "--- Audio file audio spec ---");
             }
             else
             { // dev_spec
                 spec = dev_spec;
-                puts("\n--- Audio device audio spec ---\n");
+                LOG(DEBUG, AUDIO, "--- Audio device audio spec ---");
             }
-            printf("- spec.freq: %d samples per second\n", spec.freq);
-            printf("- spec.format: %d SDL_AudioFormat (flags)\n", spec.format);
-            printf("- spec.callback: %s\n", (spec.callback==NULL) ? "NULL" : "NOT NULL");
-            printf("\t- bit size: %d\n", SDL_AUDIO_BITSIZE(spec.format));
-            printf("\t- is float: %s\n", SDL_AUDIO_ISFLOAT(spec.format)?"yes":"no");
-            printf("\t- is int: %s\n", SDL_AUDIO_ISINT(spec.format)?"yes":"no");
-            printf("\t- is bigendian: %s\n", SDL_AUDIO_ISBIGENDIAN(spec.format)?"yes":"no");
-            printf("\t- is littleendian: %s\n", SDL_AUDIO_ISLITTLEENDIAN(spec.format)?"yes":"no");
-            printf("\t- is signed: %s\n", SDL_AUDIO_ISSIGNED(spec.format)?"yes":"no");
-            printf("\t- is unsigned: %s\n", SDL_AUDIO_ISUNSIGNED(spec.format)?"yes":"no");
-            printf("- spec.channels: %d (%s)\n", spec.channels, (spec.channels==1)?"mono":((spec.channels==2)?"stereo":"not mono or stereo!"));
-            printf("- spec.silence: %d\n", spec.silence);
-            printf("- spec.samples: %d\n", spec.samples);
-            printf("- spec.padding: %d\n", spec.padding);
-            printf("- spec.size: %d bytes\n", spec.size);
-            printf("\t- Compare with GameAudio::Sound::len : %d bytes\n", GameAudio::Sound::len);
+            LOG(DEBUG, AUDIO, "- spec.freq: %d samples per second", spec.freq);
+            LOG(DEBUG, AUDIO, "- spec.format: %d SDL_AudioFormat (flags)", spec.format);
+            LOG(DEBUG, AUDIO, "- spec.callback: %s", (spec.callback==NULL) ? "NULL" : "NOT NULL");
+            LOG(DEBUG, AUDIO, "\t- bit size: %d", SDL_AUDIO_BITSIZE(spec.format));
+            LOG(DEBUG, AUDIO, "\t- is float: %s", SDL_AUDIO_ISFLOAT(spec.format)?"yes":"no");
+            LOG(DEBUG, AUDIO, "\t- is int: %s", SDL_AUDIO_ISINT(spec.format)?"yes":"no");
+            LOG(DEBUG, AUDIO, "\t- is bigendian: %s", SDL_AUDIO_ISBIGENDIAN(spec.format)?"yes":"no");
+            LOG(DEBUG, AUDIO, "\t- is littleendian: %s", SDL_AUDIO_ISLITTLEENDIAN(spec.format)?"yes":"no");
+            LOG(DEBUG, AUDIO, "\t- is signed: %s", SDL_AUDIO_ISSIGNED(spec.format)?"yes":"no");
+            LOG(DEBUG, AUDIO, "\t- is unsigned: %s", SDL_AUDIO_ISUNSIGNED(spec.format)?"yes":"no");
+            LOG(DEBUG, AUDIO, "- spec.channels: %d (%s)", spec.channels, (spec.channels==1)?"mono":((spec.channels==2)?"stereo":"not mono or stereo!"));
+            LOG(DEBUG, AUDIO, "- spec.silence: %d", spec.silence);
+            LOG(DEBUG, AUDIO, "- spec.samples: %d", spec.samples);
+            LOG(DEBUG, AUDIO, "- spec.padding: %d", spec.padding);
+            LOG(DEBUG, AUDIO, "- spec.size: %d bytes", spec.size);
+            LOG(DEBUG, AUDIO, "\t- Compare with GameAudio::Sound::len : %d bytes", GameAudio::Sound::len);
         }
-        if(!AUDIO_CALLBACK)
+        if(!AUDIO_CALLBACK && GameAudio::dev)
         { // Queue the audio
             Uint32 queued = SDL_GetQueuedAudioSize(GameAudio::dev);
             while(queued < GameAudio::dev_buf_size)
@@ -887,121 +1311,159 @@ int main(int argc, char* argv[])
                 queued = SDL_GetQueuedAudioSize(GameAudio::dev);
             }
         }
-        SDL_PauseAudioDevice(GameAudio::dev, 0);        // Start device playback!
+        if(GameAudio::dev) SDL_PauseAudioDevice(GameAudio::dev, 0);  // Start device playback!
+        Startup::mark("audio : playback starts");
+
+        SDL_InitSubSystem(SDL_INIT_VIDEO);
+        Startup::mark("SDL video init");
+        // TODO: error-handle these SDL_Create calls
+        win = SDL_CreateWindow(argv[0], wI.x, wI.y, wI.w, wI.h, wI.flags);
+        ren = SDL_CreateRenderer(win,-1,(VSYNC ? SDL_RENDERER_PRESENTVSYNC : 0)|SDL_RENDERER_ACCELERATED);
+        if(argc==1)
+        { // Try setting window opacity to 50% (when run with ;r<Space>)
+            if( SDL_SetWindowOpacity(win, 0.5) < 0 )
+            { // Not a big deal if this fails.
+                LOG(DEBUG, APP, "%d : SDL error msg: %s",__LINE__,SDL_GetError());
+            }
+        }
+        Startup::mark("window and renderer");
+
+        ///////////
+        // GAME ART
+        ///////////
+        if(0) SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND); // Workhorse
+        if(1) SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_ADD);   // Cool lighting effect!
+        { // Pick game art backend : CPU raster for the software renderer
+            SDL_RendererInfo info;
+            if(SDL_GetRendererInfo(ren, &info) == 0)
+                GameArt::cpu_raster = (info.flags & SDL_RENDERER_SOFTWARE);
+            const char* env = SDL_getenv("MG_CPU_RASTER");
+            if(env) GameArt::cpu_raster = (atoi(env) != 0);
+            LOG(INFO, RENDER, "Game art backend: %s", GameArt::cpu_raster ? "CPU raster" : "render target");
+        }
+        TexCache::init(&Textures::cache, ren);
+        // TODO: why set tex blend mode? Makes no difference. Just ren blend mode.
+        // Maybe the idea is to set the render draw blend mode to WHATEVER the texture
+        // blend mode is?
+        Textures::art = TexCache::add(&Textures::cache, SDL_PIXELFORMAT_RGBA8888,
+                SDL_TEXTUREACCESS_TARGET, SDL_BLENDMODE_BLEND, GameArt::w, GameArt::h);
+        Textures::win = TexCache::add(&Textures::cache, SDL_PIXELFORMAT_RGBA8888,
+                SDL_TEXTUREACCESS_STREAMING, SDL_BLENDMODE_BLEND, GameWin::w, GameWin::h);
+        Textures::sprites = TexCache::add(&Textures::cache, Textures::make_sprites, NULL);
+        if(!GameArt::cpu_raster && (TexCache::get(&Textures::cache, Textures::art) == NULL))
+        { // Cannot draw game art without its render target
+            printf("line %d : SDL error msg: \"%s\" ",__LINE__, SDL_GetError());
+            shutdown(); return EXIT_FAILURE;
+        }
+        if(!DrawList::init(&GameArt::dl, GameArt::MAX_QUADS))
+        { // Cannot draw game art
+            printf("line %d : Out of memory for GameArt::dl\n",__LINE__);
+            shutdown(); return EXIT_FAILURE;
+        }
+        if(GameArt::cpu_raster && !Raster::init(&GameArt::cv, GameArt::w, GameArt::h))
+        { // Cannot draw game art
+            printf("line %d : Out of memory for GameArt::cv\n",__LINE__);
+            shutdown(); return EXIT_FAILURE;
+        }
+        if(!World::setup())
+        { // Cannot draw sprites
+            printf("line %d : Out of memory for World\n",__LINE__);
+            shutdown(); return EXIT_FAILURE;
+        }
+        Startup::mark("game art");
     }
 
     srand(0);
 
-    bool quit = false;
-    while(!quit)
+    double render_period = 1.0/60;                      // Seconds per rendered frame
+    { // Display refresh rate : the schedule when I pace rendering myself (no vsync)
+        SDL_DisplayMode mode;
+        if(  (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(win), &mode) == 0)
+          && (mode.refresh_rate > 0)
+          ) render_period = 1.0/mode.refresh_rate;
+        LOG(DEBUG, APP, "Render period: %.3fms, physics step: %.3fms",
+                1000*render_period, 1000*Sim::dt);
+    }
+    Uint64 sim_t = Timing::now();                       // Time physics is caught up to
+    Uint64 render_t = 0;                                // Time the next render is due (no vsync)
+    Sim::accumulator = Sim::dt;                         // Step once before first render
+
+    { // Key bindings : defaults, then rebind from data/keys.cfg if it exists
+        Actions::setup(&UI::keys);
+        int n = InputMap::load(&UI::keys, "data/keys.cfg");
+        if(n >= 0) LOG(DEBUG, UI, "Loaded %d key bindings from data/keys.cfg", n);
+    }
+    { // Input record/replay : MG_RECORD=file or MG_REPLAY=file (and MG_REPLAY_FAST=1)
+        const char* record = SDL_getenv("MG_RECORD");
+        const char* replay = SDL_getenv("MG_REPLAY");
+        if(replay)
+        {
+            const char* fast = SDL_getenv("MG_REPLAY_FAST");
+            if(!Replay::play(&UI::replay, replay, win, fast && (atoi(fast) != 0)))
+            { // Asked for a replay that cannot run
+                printf("line %d : Cannot replay \"%s\"\n",__LINE__, replay);
+                shutdown(); return EXIT_FAILURE;
+            }
+            LOG(INFO, APP, "Replaying %u events from %s%s", UI::replay.num_events, replay,
+                    UI::replay.fast ? " (fast)" : "");
+            if(UI::replay.fast && VSYNC) SDL_RenderSetVSync(ren, 0);    // Fast : do not wait for the display
+        }
+        else if(record)
+        {
+            if(!Replay::record(&UI::replay, record, win))
+            { // Asked for a recording that cannot be saved
+                printf("line %d : Cannot record to \"%s\"\n",__LINE__, record);
+                shutdown(); return EXIT_FAILURE;
+            }
+            LOG(INFO, APP, "Recording input to %s", record);
+        }
+    }
+    Startup::mark("keys and replay");
+    while(!UI::quit)
     {
 
         /////////////////////
         // UI - EVENT HANDLER
         /////////////////////
 
-        SDL_Keymod kmod = SDL_GetModState();            // Check for modifier keys
-        SDL_Event e; while(SDL_PollEvent(&e))
+        Profile::Zone events_zone("events");
+        SynthReload::update();                          // `make synth` : new DSP code
+        Recorder::update();                             // Capture fell behind : say so
+        AudioRecovery::update();                        // Output unplugged : reopen it
+        switch(Preset::poll(&UI::preset))
+        { // A preset_load finished reading : audio crossfades to it
+            case Preset::READY:  LOG(INFO, AUDIO, "Loaded preset %s", UI::preset.path); break;
+            case Preset::FAILED: LOG(WARN, AUDIO, "Cannot load preset %s", UI::preset.path); break;
+            default: break;
+        }
+        Replay::tick(&UI::replay, 1000*render_period);  // Recorded events that are due now
+        SDL_Event e; while(Replay::poll(&UI::replay, &e))
         { // Process all events, set flags for tricky ones
             switch(e.type)
             { // See SDL_EventType
-                case SDL_QUIT: quit=true; break;
+                case SDL_QUIT: UI::quit=true; break;
 
                 // e.key
                 case SDL_KEYDOWN:
-                    switch(e.key.keysym.sym)
-                    { // Respond to keyboard input
-                        case SDLK_q: quit=true; break;
-                        case SDLK_F11:
-                            UI::Flags::fullscreen_toggled = true;
-                            break;
-                        case SDLK_SLASH:
-                            if(kmod&KMOD_SHIFT) UI::show_overlay = !UI::show_overlay;
-                            break;
-                        case SDLK_SPACE:
-                            if(kmod&KMOD_SHIFT) UI::Flags::pressed_shift_space = true;
-                            else                UI::Flags::pressed_space = true;
-                            break;
-                        case SDLK_j:
-                            UI::Flags::pressed_j = true;
-                            break;
-                        case SDLK_r:
-                            if(kmod&KMOD_SHIFT) UI::Flags::pressed_R = true;
-                            else                UI::Flags::pressed_r = true;
-                            break;
-                        case SDLK_1:
-                            UI::Flags::pressed_1 = true;
-                            break;
-                        case SDLK_2:
-                            UI::Flags::pressed_2 = true;
-                            break;
-                        case SDLK_3:
-                            UI::Flags::pressed_3 = true;
-                            break;
-                        case SDLK_4:
-                            UI::Flags::pressed_4 = true;
-                            break;
-                        case SDLK_5:
-                            UI::Flags::pressed_5 = true;
-                            break;
-                        case SDLK_6:
-                            UI::Flags::pressed_6 = true;
-                            break;
-                        case SDLK_7:
-                            UI::Flags::pressed_7 = true;
-                            break;
-                        case SDLK_8:
-                            UI::Flags::pressed_8 = true;
-                            break;
-                        case SDLK_9:
-                            UI::Flags::pressed_9 = true;
-                            break;
-                        case SDLK_0:
-                            UI::Flags::pressed_0 = true;
-                            break;
-                        case SDLK_MINUS:
-                            UI::Flags::pressed_minus = true;
-                            break;
-                        case SDLK_EQUALS:
-                            UI::Flags::pressed_equals = true;
-                            break;
-                        case SDLK_BACKSPACE:
-                            UI::Flags::pressed_backspace = true;
-                            break;
-    
-                        ////////////////////////
-                        // UNUSED KEYDOWN EVENTS
-                        ////////////////////////
-                        case SDLK_RETURN:
-                            if(DEBUG_UI) UnusedUI::msg(__LINE__,
-                                "e.key SDL_KEYDOWN: e.key.keysym.sym SDLK_RETURN",
-                                e.common.timestamp
-                                );
-                            break;
-                        case SDLK_ESCAPE:
-                            if(DEBUG_UI) UnusedUI::msg(__LINE__,
-                                "e.key SDL_KEYDOWN: e.key.keysym.sym SDLK_ESCAPE",
-                                e.common.timestamp
+                    Metrics::input(e.common.timestamp);
+                    if(!InputMap::key_down(&UI::keys, e.key.keysym.sym, e.key.keysym.mod))
+                    { // Key is not bound to an action
+                        if(DEBUG_UI)
+                        { // Print unused keydown events
+                            char buf[64];
+                            sprintf(buf,
+                                "e.key \"SDL_KEYDOWN\": e.key.keysym.sym '%c'",
+                                e.key.keysym.sym
                                 );
-                            break;
-                        default:
-                            if(DEBUG_UI)
-                            { // Print unused keydown events
-                                char buf[64];
-                                sprintf(buf,
-                                    "e.key \"SDL_KEYDOWN\": e.key.keysym.sym '%c'",
-                                    e.key.keysym.sym
-                                    );
-                                UnusedUI::msg(__LINE__,buf,e.common.timestamp);
-                            }
-                            break;
+                            UnusedUI::msg(__LINE__,buf,e.common.timestamp);
+                        }
                     }
                     break;
 
                 // e.motion
                 case SDL_MOUSEMOTION:
-                    UI::Flags::mouse_moved = true;
-                    Mouse::motion = e.motion;           // Store the mouse motion
+                    Metrics::input(e.common.timestamp);
+                    MouseInput::drain(e);               // This and all queued motion
                     break;
 
                 // e.window
@@ -1012,11 +1474,12 @@ int main(int argc, char* argv[])
                             // SDL_WINDOWEVENT_SIZE_CHANGED occurs once on a resize
                             // SDL_WINDOWEVENT_RESIZED occurs twice on a resize
                             // So I use SDL_WINDOWEVENT_SIZE_CHANGED.
+                            // Dragging an edge sends a storm of these : resize once per frame
                             UI::Flags::window_size_changed = true;
-                            if(DEBUG)
+                            UI::Flags::resize_events++;
                             { // Print event name, timestamp, window size, game art size
-                                printf("%d : e.window.event \"SDL_WINDOWEVENT_SIZE_CHANGED\" at %dms\n", __LINE__, e.window.timestamp);
-                                printf("BEFORE: \tWindow W x H: %d x %d\tGameArt W x H: %d x %d\tGameWin W x H: %d x %d\tGtoW::scale: %d\n", wI.w, wI.h, GameArt::w, GameArt::h, GameWin::w, GameWin::h, GtoW::scale);
+                                LOG(TRACE, UI, "%d : e.window.event \"SDL_WINDOWEVENT_SIZE_CHANGED\" at %dms", __LINE__, e.window.timestamp);
+                                LOG(TRACE, UI, "BEFORE: \tWindow W x H: %d x %d\tGameArt W x H: %d x %d\tGameWin W x H: %d x %d\tGtoW::scale: %d", wI.w, wI.h, GameArt::w, GameArt::h, GameWin::w, GameWin::h, GtoW::scale);
                             }
                             break;
                         default:
@@ -1043,18 +1506,18 @@ int main(int argc, char* argv[])
                                             "e.window.event \"SDL_WINDOWEVENT_EXPOSED\"",
                                             e.window.timestamp);
                                         SDL_GetWindowSize(win, &w, &h);
-                                        printf("\tSDL_GetWindowSize:         W x H: %d x %d\n", w, h);
+                                        LOG(TRACE, UI, "\tSDL_GetWindowSize:         W x H: %d x %d", w, h);
                                          SDL_GetRendererOutputSize(ren, &w, &h);
-                                        printf("\tSDL_GetRendererOutputSize: W x H: %d x %d\n", w, h);
+                                        LOG(TRACE, UI, "\tSDL_GetRendererOutputSize: W x H: %d x %d", w, h);
                                         break;
                                     case SDL_WINDOWEVENT_RESIZED:
                                         UnusedUI::msg(__LINE__,
                                             "e.window.event \"SDL_WINDOWEVENT_RESIZED\"",
                                             e.window.timestamp);
                                         SDL_GetWindowSize(win, &w, &h);
-                                        printf("\tSDL_GetWindowSize:         W x H: %d x %d\n", w, h);
+                                        LOG(TRACE, UI, "\tSDL_GetWindowSize:         W x H: %d x %d", w, h);
                                          SDL_GetRendererOutputSize(ren, &w, &h);
-                                        printf("\tSDL_GetRendererOutputSize: W x H: %d x %d\n", w, h);
+                                        LOG(TRACE, UI, "\tSDL_GetRendererOutputSize: W x H: %d x %d", w, h);
                                         break;
                                     case SDL_WINDOWEVENT_ENTER:
                                         UnusedUI::msg(__LINE__,
@@ -1112,12 +1575,20 @@ int main(int argc, char* argv[])
 
                 // e.adevice
                 case SDL_AUDIODEVICEADDED:
-                    if(DEBUG_UI) UnusedUI::msg(__LINE__, "e.type \"SDL_AUDIODEVICEADDED\"", e.common.timestamp);
+                    AudioDevice::added(&AudioRecovery::device, e.adevice.iscapture, SDL_GetTicks());
                     break;
+                case SDL_AUDIODEVICEREMOVED: AudioRecovery::removed(e.adevice); break;
 
                 // e.?
                 case SDL_RENDER_TARGETS_RESET:
-                    if(DEBUG_UI) UnusedUI::msg(__LINE__, "e.type \"SDL_RENDER_TARGETS_RESET\"", e.common.timestamp);
+                    // Render targets lost their contents (Direct3D)
+                    LOG(INFO, RENDER, "%d : Render targets reset at %dms", __LINE__, e.common.timestamp);
+                    TexCache::targets_reset(&Textures::cache);
+                    break;
+                case SDL_RENDER_DEVICE_RESET:
+                    // Every texture is gone : remade at the next TexCache::get()
+                    LOG(WARN, RENDER, "%d : Render device reset at %dms", __LINE__, e.common.timestamp);
+                    TexCache::device_reset(&Textures::cache);
                     break;
 
                 // e.edit
@@ -1166,265 +1637,54 @@ int main(int argc, char* argv[])
                     break;
 
                 default:
-                    if (DEBUG_UI)
-                    { // Catch any events I haven't made cases for
-                        printf("line %d : TODO: Look up 0x%4X in enum SDL_EventType "
-                               "and put it in section \"UNUSED EVENTS\"\n", __LINE__, e.type);
-                    }
+                    // Catch any events I haven't made cases for
+                    LOG(TRACE, UI, "line %d : TODO: Look up 0x%4X in enum SDL_EventType "
+                           "and put it in section \"UNUSED EVENTS\"", __LINE__, e.type);
                     break;
             }
         }
 
+        if(UI::Flags::window_size_changed)
+        { // Update stuff that depends on window size : once per frame, however many events
+            UI::Flags::window_size_changed = false;
+            SDL_GetWindowSize(win, &wI.w, &wI.h);       // Latest size, not the size in the event
+            GtoW::fit(GameArt::w, GameArt::h, wI.w, wI.h);  // Scale and center game art
+            GameWin::w = GtoW::scale * GameArt::w;
+            GameWin::h = GtoW::scale * GameArt::h;
+            LOG(DEBUG, UI, "AFTER: \tWindow W x H: %d x %d\tGameArt W x H: %d x %d\tGameWin W x H: %d x %d\tGtoW::scale: %d (%d events)", wI.w, wI.h, GameArt::w, GameArt::h, GameWin::w, GameWin::h, GtoW::scale, UI::Flags::resize_events);
+            UI::Flags::resize_events = 0;
+        }
+        events_zone.end();
+
         /////////////////
         // PHYSICS UPDATE
         /////////////////
-        if(UI::Flags::mouse_moved)
-        { // Update mouse x,y (Get GameArt coordinates)
-            UI::Flags::mouse_moved = false;
-            // Get floats for pitch
-            Mouse::xf = (Mouse::motion.x - GtoW::Offset::x)/static_cast<float>(GtoW::scale);
-            Mouse::yf = (Mouse::motion.y - GtoW::Offset::y)/static_cast<float>(GtoW::scale);
-            // Get ints too
-            Mouse::x = (Mouse::motion.x - GtoW::Offset::x)/GtoW::scale;
-            Mouse::y = (Mouse::motion.y - GtoW::Offset::y)/GtoW::scale;
-            // Clamp mouse x, y to game window:
-            if(Mouse::y < 0) Mouse::y = 0;
-            if(Mouse::x < 0) Mouse::x = 0;
-            if(Mouse::yf < 0) Mouse::yf = 0;
-            if(Mouse::xf < 0) Mouse::xf = 0;
-            if(Mouse::y > GameArt::h) Mouse::y = GameArt::h;
-            if(Mouse::x > GameArt::w) Mouse::x = GameArt::w;
-            if(Mouse::yf > GameArt::h) Mouse::yf = (float)GameArt::h;
-            if(Mouse::xf > GameArt::w) Mouse::xf = (float)GameArt::w;
-            if(DEBUG_UI)
-            {
-                if(UI::Flags::mouse_xy_isfloat)
-                    {printf("Mouse x,y : %.3f,%.3f\n", Mouse::xf, Mouse::yf);}
-                else
-                    {printf("Mouse x,y : %d,%d\n", Mouse::x, Mouse::y);}
-            }
-            // Use mouse distance from game art center to set VCA
-            { // Set VCA amplitudes based on mouse position
-                if(0)
-                { // Method 1 : Abs value diff along x axis
-                  // Volume only depends on distance from center in x-direction
-                    int abs_diff;
-                    {
-                        abs_diff = Mouse::x - (GameArt::w/2);
-                        if (abs_diff < 0 ) abs_diff *= -1;
-                        if(DEBUG)
-                        {
-                            if(abs_diff < 0)
-                            {
-                                printf("%d : Expected abs_diff >= 0, abs_diff = %d\n",__LINE__,abs_diff);
-                            }
-                        }
-                    }
-                    UI::VCA::mouse_center_dist =
-                        ((GameArt::w/2) - abs_diff) /
-                        static_cast<float>(GameArt::w/2);
-                }
-                if(1)
-                { // Method 2 : Sum of square distances from center
-                  // Only silent when mouse is in the corners of the screen
-                    int cx = GameArt::w/2; int cy = GameArt::h/2;
-                    int max = ((cx*cx)+(cy*cy));
-                    if(UI::Flags::mouse_xy_isfloat)
-                    {
-                        float dx = Mouse::xf - cx;
-                        float dy = Mouse::yf - cy;
-                        UI::VCA::mouse_center_dist =
-                            (max - ((dx*dx) + (dy*dy))) /
-                            static_cast<float>(max);
-                        UI::VCA::mouse_height =
-                            (GameArt::h - Mouse::yf) /
-                            static_cast<float>(GameArt::h);
-                        if(DEBUG_UI) printf("%d : VCA mouse_center : %0.3f\n",__LINE__,UI::VCA::mouse_center_dist);
-                        if(DEBUG_UI) printf("%d : VCA mouse_height : %0.3f\n",__LINE__,UI::VCA::mouse_height);
-                    }
-                    else
-                    {
-                        int dx = Mouse::x - cx;
-                        int dy = Mouse::y - cy;
-                        UI::VCA::mouse_center_dist =
-                            (max - ((dx*dx) + (dy*dy))) /
-                            static_cast<float>(max);
-                        UI::VCA::mouse_height =
-                            (GameArt::h - Mouse::y) /
-                            static_cast<float>(GameArt::h);
-                        if(DEBUG_UI) printf("%d : VCA mouse_center : %0.3f\n",__LINE__,UI::VCA::mouse_center_dist);
-                        if(DEBUG_UI) printf("%d : VCA mouse_height : %0.3f\n",__LINE__,UI::VCA::mouse_height);
-                    }
-                }
-            }
-        }
-        if(UI::Flags::fullscreen_toggled)
-        {
-            UI::Flags::fullscreen_toggled = false;
-            UI::is_fullscreen = !UI::is_fullscreen;
-            if(UI::is_fullscreen)
-            { // Go fullscreen
-                // Don't bother dealing with videomode mode change
-                // SDL_WINDOW_FULLSCREEN_DESKTOP is way easier and faster than
-                // SDL_WINDOW_FULLSCREEN
-                SDL_SetWindowFullscreen(win, SDL_WINDOW_FULLSCREEN_DESKTOP);
-            }
-            else
-            { // Go back to windowed
-                SDL_SetWindowFullscreen(win, 0);
-            }
-        }
-        if(UI::Flags::window_size_changed)
-        { // Update stuff that depends on window size
-            UI::Flags::window_size_changed = false;
-            SDL_GetWindowSize(win, &wI.w, &wI.h);
-            { // Resize game art to fit window
-                /* *************Resize***************
-                 * Use largest pixel size for GameArt to fit in Window.
-                 * If window is smaller than GameArt, use GameArt w x h and let it clip.
-                 * *******************************/
-                if((wI.w<GameArt::w)||(wI.h<GameArt::h)) GtoW::scale = 1;
-                else
-                {
-                    int ratio_w = wI.w/GameArt::w;
-                    int ratio_h = wI.h/GameArt::h;
-                    // Use the smaller of the two ratios as the scaling factor
-                    GtoW::scale = (ratio_w > ratio_h) ? ratio_h : ratio_w;
-                }
-                GameWin::w = GtoW::scale * GameArt::w;
-                GameWin::h = GtoW::scale * GameArt::h;
-            }
-            { // Recenter game art in window
-                /* *************Recenter***************
-                 * If window is bigger, recenter game art.
-                 * If window is smaller, pin game art topleft to window topleft.
-                 * *******************************/
-                if(wI.w>GameWin::w) GtoW::Offset::x = (wI.w-GameWin::w)/2;
-                else GtoW::Offset::x = 0;
-                if(wI.h>GameWin::h) GtoW::Offset::y = (wI.h-GameWin::h)/2;
-                else GtoW::Offset::y = 0;
-            }
-            if(DEBUG) printf("AFTER: \tWindow W x H: %d x %d\tGameArt W x H: %d x %d\tGameWin W x H: %d x %d\tGtoW::scale: %d\n", wI.w, wI.h, GameArt::w, GameArt::h, GameWin::w, GameWin::h, GtoW::scale);
+        Profile::Zone physics_zone("physics");
+        { // Accumulate time to simulate
+            Uint64 t = Timing::now();
+            // Fast replay : every loop is one frame, however long it took
+            Sim::accumulator += Replay::fast(&UI::replay) ? render_period : Timing::sec(sim_t, t);
+            sim_t = t;
+            if(Sim::accumulator > Sim::MAX_FRAME) Sim::accumulator = Sim::MAX_FRAME;
         }
-        if(UI::Flags::pressed_space)
-        { // Space is my go-to for things I want to play with temporarily
-            UI::Flags::pressed_space = false;
-            if (0) UI::Flags::mouse_xy_isfloat = !UI::Flags::mouse_xy_isfloat;
-            if (1)
-            { // Increment number of voices
-                Voices::count++;
-                if(Voices::count > Voices::MAX_COUNT) Voices::count = 1;
+        while(Sim::accumulator >= Sim::dt)
+        { // Step physics at a fixed rate, independent of render rate
+            Sim::accumulator -= Sim::dt;
+            Sim::prev = Sim::curr;
+            InputMap::dispatch(&UI::keys);              // Keys pressed since last step
+            if(UI::Flags::mouse_moved)
+            { // Update mouse x,y (GameArt coordinates) and VCA from new positions
+                UI::Flags::mouse_moved = false;
+                MouseInput::update();
+                // Once per step, not once per event
+                LOG(TRACE, UI, "Mouse x,y : %.3f,%.3f (%d events)", Mouse::xf, Mouse::yf, MouseInput::batch_count);
+                LOG(TRACE, UI, "%d : VCA mouse_center : %0.3f mouse_height : %0.3f",__LINE__,
+                        UI::VCA::mouse_center_dist, UI::VCA::mouse_height);
             }
+            if(World::show) World::step(static_cast<float>(Sim::dt));
+            Sim::curr = Sim::capture();
         }
-        if(UI::Flags::pressed_shift_space)
-        { // Decrease voice count
-            UI::Flags::pressed_shift_space = false;
-            Voices::count--;
-            if(Voices::count < 1) Voices::count = Voices::MAX_COUNT;
-        }
-        if(UI::Flags::pressed_r)
-        { // Trigger a note with no envelope (reset envelope)
-            UI::Flags::pressed_r = false;
-            Envelope::enabled = false;                  // Turn off envelope
-            Envelope::phase = 0;                        // Start sound
-        }
-        if(UI::Flags::pressed_j)
-        { // Trigger a note with one-shot envelope
-            UI::Flags::pressed_j = false;
-            Envelope::enabled = true;                   // Turn on envelope
-            Envelope::one_shot = true;
-            Envelope::phase = 0;                        // Trigger envelope
-        }
-        if(UI::Flags::pressed_R)
-        { // Trigger a note with periodic envelope (repeat envelope)
-            UI::Flags::pressed_R = false;
-            Envelope::enabled = true;                   // Turn on envelope
-            Envelope::one_shot = false;
-            Envelope::phase = 0;                        // Start sound
-        }
-        // Set note by warping mouse to xy
-        if(UI::Flags::pressed_1)
-        {
-            UI::Flags::pressed_1 = false;
-            Notes::mouse_to_note(0);
-        }
-        if(UI::Flags::pressed_2)
-        {
-            UI::Flags::pressed_2 = false;
-            Notes::mouse_to_note(1);
-        }
-        if(UI::Flags::pressed_3)
-        {
-            UI::Flags::pressed_3 = false;
-            Notes::mouse_to_note(2);
-        }
-        if(UI::Flags::pressed_4)
-        {
-            UI::Flags::pressed_4 = false;
-            Notes::mouse_to_note(3);
-        }
-        if(UI::Flags::pressed_5)
-        {
-            UI::Flags::pressed_5 = false;
-            Notes::mouse_to_note(4);
-        }
-        if(UI::Flags::pressed_6)
-        {
-            UI::Flags::pressed_6 = false;
-            Notes::mouse_to_note(5);
-        }
-        if(UI::Flags::pressed_7)
-        {
-            UI::Flags::pressed_7 = false;
-            Notes::mouse_to_note(6);
-        }
-        if(UI::Flags::pressed_8)
-        {
-            UI::Flags::pressed_8 = false;
-            Notes::mouse_to_note(7);
-        }
-        if(UI::Flags::pressed_9)
-        {
-            UI::Flags::pressed_9 = false;
-            Notes::mouse_to_note(8);
-        }
-        if(UI::Flags::pressed_0)
-        {
-            UI::Flags::pressed_0 = false;
-            Notes::mouse_to_note(9);
-        }
-        if(UI::Flags::pressed_minus)
-        {
-            UI::Flags::pressed_minus = false;
-            Notes::mouse_to_note(10);
-        }
-        if(UI::Flags::pressed_equals)
-        {
-            UI::Flags::pressed_equals = false;
-            Notes::mouse_to_note(11);
-        }
-        if(UI::Flags::pressed_backspace)
-        {
-            UI::Flags::pressed_backspace = false;
-            Notes::mouse_to_note(12);
-        }
-        // TODO: warp mouse when I press a pitch key, EVEN IF THE MOUSE IS MOVING!
-        // I tried this, but it seems to make no difference.
-        // I think I need to filter the pitch keys instead of polling them.
-        if( UI::Flags::pressed_1 ||
-            UI::Flags::pressed_2 ||
-            UI::Flags::pressed_3 ||
-            UI::Flags::pressed_4 ||
-            UI::Flags::pressed_5 ||
-            UI::Flags::pressed_6 ||
-            UI::Flags::pressed_7 ||
-            UI::Flags::pressed_8 ||
-            UI::Flags::pressed_9 ||
-            UI::Flags::pressed_0 ||
-            UI::Flags::pressed_minus ||
-            UI::Flags::pressed_equals ||
-            UI::Flags::pressed_backspace
-            ) UI::Flags::mouse_moved = true;
+        physics_zone.end();
 
         /////////
         // RENDER
@@ -1467,72 +1727,85 @@ int main(int argc, char* argv[])
                             GameAudio::Sound::buf, GameAudio::Sound::len);
                     if(DEBUG_AUDIO)
                     {
-                        printf("BEFORE: queued %d bytes\n", queued);
+                        LOG(DEBUG, AUDIO, "BEFORE: queued %d bytes", queued);
                         const Uint32 queued = SDL_GetQueuedAudioSize(GameAudio::dev);
-                        printf("AFTER: queued %d bytes\n", queued);
+                        LOG(DEBUG, AUDIO, "AFTER: queued %d bytes", queued);
                     }
                 }
             }
 
         }
 
+        if(!VSYNC && !Replay::fast(&UI::replay))
+        { // Only render when the display is ready for a new frame
+            Uint64 t = Timing::now();
+            if(render_t && (t < render_t))
+            { // Not time to render : keep polling input and stepping physics
+                SDL_Delay(1);
+                continue;
+            }
+            // Next frame is one period after this one was due, not after the sleep
+            // overshot : frames stay evenly spaced. More than a period behind : start over.
+            const Uint64 period = static_cast<Uint64>(render_period*static_cast<double>(SDL_GetPerformanceFrequency()));
+            render_t = (render_t && (t - render_t < period)) ? render_t + period : t + period;
+        }
+        // Draw physics state interpolated between last two steps
+        Sim::State drawn = Sim::lerp(static_cast<float>(Sim::accumulator/Sim::dt));
+        if(UI::show_scope)
+        { // Latest samples and spectrum for the scope
+            PROFILE_ZONE("scope");
+            Uint64 t0 = Timing::now();
+            Scope::update();
+            Metrics::scope_us.add(1000*Timing::ms(t0, Timing::now()));
+        }
+
         //////////////////
         // RENDER GAME ART
         //////////////////
-        SDL_SetRenderTarget(ren, GameArt::tex);
-
-        { // Game art background color
-            SDL_Color c = Colors::darkgravel;
-            SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a);
-            SDL_RenderClear(ren);
+        Profile::Zone art_zone("art");
+        SDL_BlendMode blend; SDL_GetRenderDrawBlendMode(ren, &blend);
+        if(GameArt::cpu_raster)
+        { // Draw on the CPU, upscale changed rows straight into the window-size texture
+            Raster::Canvas* cv = &GameArt::cv;
+            Raster::clear(cv, Colors::darkgravel);      // Game art background color
+            cv->blend = blend;
+            draw_game_art(cv, drawn);
+            // Window grew past the texture : bigger texture. Any new size : upscale everything.
+            TexCache::size(&Textures::cache, Textures::win, GameWin::w, GameWin::h);
+            SDL_Texture* tex = TexCache::get(&Textures::cache, Textures::win);
+            if(TexCache::redraw(&Textures::cache, Textures::win)) cv->upload_all = true;
+            // Nothing changed : no rows sent, no upscale, texture keeps last frame
+            if(tex) Raster::send_changes(cv, [cv, tex](SDL_Rect band)
+            { // Upscale the changed band into the same band of the window texture
+                const int k = GtoW::scale;
+                SDL_Rect dst{band.x*k, band.y*k, band.w*k, band.h*k};
+                void* pixels; int pitch;
+                if(SDL_LockTexture(tex, &dst, &pixels, &pitch) < 0) return;
+                Upscale::blit(cv->px + band.y*cv->w + band.x, cv->w, band.w, band.h,
+                        (Uint32*)pixels, pitch/sizeof(Uint32), k);
+                SDL_UnlockTexture(tex);
+            });
         }
-        { // Placeholder game art
-            { // X
-                uint8_t rand_r = (uint8_t)(std::rand()%256);
-                uint8_t rand_b = (uint8_t)(std::rand()%256);
-                uint8_t rand_g = (uint8_t)(std::rand()%256);
-                SDL_Color c = {rand_r,rand_g,rand_b,128};
+        else
+        { // Draw into the render target : record it all, then draw it in one call
+            SDL_SetRenderTarget(ren, TexCache::get(&Textures::cache, Textures::art));
+            { // Game art background color
+                SDL_Color c = Colors::darkgravel;
                 SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a);
-
-                SDL_RenderDrawLine(ren, 0,0,GameArt::w,GameArt::h);
-                SDL_RenderDrawLine(ren, GameArt::w,0,0,GameArt::h);
-            }
-            { // Mouse location
-                SDL_Color c = Colors::lime;
-                SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, 128);
-                SDL_RenderDrawLine(ren, GameArt::w/2,GameArt::h/2,Mouse::x,Mouse::y);
-            }
-            if(1)
-            { // Blue box
-                SDL_Color c = Colors::tardis;
-                int mod = UI::VCA::mouse_height*255;
-                SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, mod);
-                int w = UI::VCA::mouse_center_dist*GameArt::w;
-                int h = UI::VCA::mouse_center_dist*GameArt::h;
-                int x = GameArt::w/2 - w/2;
-                int y = GameArt::h/2 - h/2;
-                SDL_Rect r{x,y,w,h};
-                SDL_RenderFillRect(ren, &r);
-            }
-            { // Show number of voices in use
-                constexpr int size = 10; int w = size; int h = size;
-                constexpr int gap = size/2;
-                int x0 = 10; int y = 10;
-                for (int i=0; i<Voices::MAX_COUNT; i++)
-                {
-                    int x = x0 + (i*(size+gap));
-                    SDL_Rect r{x,y,w,h};
-                    SDL_Color c = Colors::orange;
-                    SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a);
-                    if(Voices::count >= (i+1)) SDL_RenderFillRect(ren, &r);
-                    else                       SDL_RenderDrawRect(ren, &r);
-                }
+                SDL_RenderClear(ren);
             }
+            World::sheet.tex = TexCache::get(&Textures::cache, Textures::sprites);
+            DrawList::begin(&GameArt::dl, ren, blend);
+            draw_game_art(&GameArt::dl, drawn);
+            DrawList::flush(&GameArt::dl);
         }
 
+        art_zone.end();
+
         ///////////////////
         // RENDER OS WINDOW
         ///////////////////
+        Profile::Zone window_zone("window");
         SDL_SetRenderTarget(ren, NULL);
         { // Set background color of window to match my Vim background color
             SDL_Color c = Colors::blackestgravel;
@@ -1546,14 +1819,35 @@ int main(int argc, char* argv[])
             dst.y = GtoW::Offset::y;
             dst.w = GameWin::w;
             dst.h = GameWin::h;
-            if(SDL_RenderCopy(ren, GameArt::tex, &src, &dst))
+            // CPU raster already did the upscale : copy 1:1
+            SDL_Texture* tex = TexCache::get(&Textures::cache, GameArt::cpu_raster ? Textures::win : Textures::art);
+            if(GameArt::cpu_raster) src = SDL_Rect{0,0,GameWin::w,GameWin::h};  // Top-left of a texture that may be bigger
+            if(SDL_RenderCopy(ren, tex, &src, &dst))
             {
-                if(DEBUG) printf("%d : SDL error msg: %s\n",__LINE__,SDL_GetError());
+                LOG(WARN, RENDER, "%d : SDL error msg: %s",__LINE__,SDL_GetError());
             }
         }
+        window_zone.end();
+        if((Textures::atlas < 0) && (Font::poll() != Font::LOADING))
+        { // Font thread is done : build the glyph atlas (needs the renderer, so on this thread)
+            Font::finish();
+            Uint64 t0 = Timing::now();
+            if(Font::poll() != Font::FAILED) Textures::atlas = TexCache::add(&Textures::cache, Textures::make_atlas, NULL);
+            if((Textures::atlas < 0) || (TexCache::get(&Textures::cache, Textures::atlas) == NULL))
+            { // Cannot draw overlay text without the glyph atlas
+                printf("line %d : SDL error msg: \"%s\" ",__LINE__,
+                        (Font::poll() == Font::FAILED) ? Font::error : SDL_GetError());
+                shutdown(); return EXIT_FAILURE;
+            }
+            Startup::add("font (own thread)", Font::ms);
+            Startup::add("glyph atlas", Timing::ms(t0, Timing::now()));
+        }
+        // NULL until the font is loaded, and if a device reset left no way to rebuild it
+        Overlay::atlas.tex = (Textures::atlas < 0) ? NULL : TexCache::get(&Textures::cache, Textures::atlas);
         if(UI::show_overlay)
         { // Show debug/help overlay
-            constexpr int OVERLAY_H = 100;
+            PROFILE_ZONE("overlay");
+            constexpr int OVERLAY_H = 170;                // Room for 4 lines of text
             { // Darken light stuff
                 SDL_Color c = Colors::coal;
                 SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a>>1); // 50% darken
@@ -1566,7 +1860,9 @@ int main(int argc, char* argv[])
                 SDL_Rect rect = {.x=0, .y=0, .w=wI.w, .h=OVERLAY_H};
                 SDL_RenderFillRect(ren, &rect);             // Draw filled rect
             }
-            { // Render text
+            if(Overlay::atlas.tex)
+            { // Render text (once the font is loaded)
+                Uint64 t0 = Timing::now();
                 char text[1024];
                 switch(Voices::count)
                 {
@@ -1631,22 +1927,54 @@ int main(int argc, char* argv[])
                             UI::VCA::mouse_height*FREQ_H1_MAX*8);
                         break;
                 }
+                if(Timing::sec(Overlay::stats_t, t0) > Overlay::STATS_PERIOD)
+                { // Frame time and latency : update slow enough to read
+                    Overlay::stats_t = t0;
+                    snprintf(Overlay::stats, sizeof(Overlay::stats),
+                        "FRAME: %0.2fms avg %0.2fms max\n"
+                        "INPUT->PHOTON: %0.1fms avg %0.1fms max\n"
+                        "PHYSICS: %dHz TEXT: %0.1fus SCOPE: %0.0fus ART: %s %d rows",
+                        Metrics::frame_ms.avg(), Metrics::frame_ms.max(),
+                        Metrics::input_to_photon_ms.avg(), Metrics::input_to_photon_ms.max(),
+                        Sim::HZ, Metrics::overlay_text_us.avg(), Metrics::scope_us.avg(),
+                        GameArt::cpu_raster ? "CPU" : "GPU", GameArt::cv.rows_uploaded);
+                }
+                strncat(text, Overlay::stats, sizeof(text)-strlen(text)-1);
                 constexpr int margin = 10;
-                SDL_Rect textbox = {.x=margin, .y=margin, .w=0, .h=0};
-                SDL_Surface* surf = TTF_RenderText_Blended_Wrapped(ttf,
-                        text,                          // text
-                        Colors::snow,                   // color
-                        wI.w - 2*margin                 // text width : wrap here
+                // Profile timeline on the right if the window is wide enough
+                bool show_flame = (wI.w > 2*Flame::W);
+                GlyphAtlas::layout(&Overlay::text, &Overlay::atlas,
+                        text,                           // text
+                        margin, margin,                 // top-left
+                        wI.w - 2*margin - (show_flame ? Flame::W + margin : 0), // wrap here
+                        Colors::snow                    // color
                         );
-                SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
-                SDL_FreeSurface(surf);
-                SDL_QueryTexture(tex, NULL, NULL, &textbox.w, &textbox.h);
-                SDL_RenderCopy(ren, tex, NULL, &textbox);
-                SDL_DestroyTexture(tex);
+                GlyphAtlas::draw(ren, &Overlay::atlas, &Overlay::text);
+                Metrics::overlay_text_us.add(1000*Timing::ms(t0, Timing::now()));
+                if(show_flame)
+                { // Stacked bars and legend in one draw call, then legend text
+                    int x = wI.w - margin - Flame::W;
+                    int legend_y = OVERLAY_H - margin - Overlay::atlas.line_skip - 2;
+                    DrawList::begin(&GameArt::dl, ren, SDL_BLENDMODE_BLEND);
+                    Flame::draw(&GameArt::dl, x, margin, legend_y - 4 - margin,
+                            static_cast<float>(1000*render_period));
+                    Flame::draw_legend(&GameArt::dl, &Overlay::atlas, x, legend_y);
+                    DrawList::flush(&GameArt::dl);
+                    GlyphAtlas::draw(ren, &Overlay::atlas, &Flame::legend);
+                }
             }
         }
-        SDL_RenderPresent(ren);
-        if(DEBUG) fflush(stdout);
+        { // Present
+            PROFILE_ZONE("present");
+            SDL_RenderPresent(ren);
+        }
+        Metrics::presented();
+        if(!Startup::reported)
+        { // First frame, then the report once overlay text can draw too
+            if(!Startup::first_frame) { Startup::mark("first frame"); Startup::first_frame = true; }
+            if(Overlay::atlas.tex) Startup::report();
+        }
+        Profile::end_frame(&Flame::tl);                 // Sum this frame's zones into a bar
     }
 
     shutdown();
@@ -0,0 +1,247 @@
+#ifndef __PRESET_H__
+#define __PRESET_H__
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include "synth.h"
+
+namespace Preset
+{ // Snapshot of every synth setting : save, load, switch sounds without a click (include SDL.h first)
+    /* *************DOC***************
+     * A preset is one flat struct, Preset::Data : the patch graph, the modulation
+     * matrix and the voice count. The file is that struct as it is in memory, so
+     * loading is one fread and a check of the header:
+     *
+     *      Preset::Data d;
+     *      Preset::capture(&d, "wobbly");              // Current sound
+     *      Preset::save(&d, "data/wobbly.mgp");
+     *      Preset::write_text(&d, "data/wobbly.txt");  // Same thing, readable
+     *      ...
+     *      if(Preset::load(&d, "data/wobbly.mgp")) Preset::apply(&d);
+     *
+     * apply() offers the new patch to the audio thread with fade=true : the audio
+     * thread fades out, swaps at a block boundary, and fades in (see Crossfade).
+     *
+     * To keep file I/O off the UI thread, load_async() reads and checks the file
+     * on a worker thread. poll() (UI thread, once per frame) applies it when it
+     * is ready.
+     *
+     * File : little-endian (x86/ARM), same struct layout as the program that
+     * wrote it. Any change to Data must bump VERSION : size is also checked.
+     * *******************************/
+    constexpr Uint32 MAGIC = 0x50474D;                  // "MGP\0" little-endian
+    constexpr Uint32 VERSION = 1;
+    constexpr int NAME_LEN = 32;
+    struct Source
+    { // Mod::Source without the pointer
+        Sint32 type;                                    // Mod::Type
+        float a, b;
+        Sint32 control;                                 // EXTERNAL : UI::VCA index, else -1
+    };
+    struct Data
+    {
+        Uint32 magic, version, size;                    // size : sizeof(Data)
+        char name[NAME_LEN];
+        Sint32 voices;                                  // Voices::count
+        Patch::Node nodes[Patch::MAX_NODES];            // Nodes::graph
+        Sint32 output;
+        Sint32 mod_rate;                                // Nodes::mod_config
+        Source sources[Mod::MAX_SOURCES]; Sint32 num_sources;
+        Mod::Dest dests[Mod::MAX_DESTS]; Sint32 num_dests;
+        Mod::Route routes[Mod::MAX_ROUTES]; Sint32 num_routes;
+    };
+    static_assert(std::is_trivially_copyable_v<Data>, "Preset::Data is saved and loaded with memcpy");
+
+    void capture(Data* d, const char* name)
+    { // UI thread : the sound that is playing now
+        memset(d, 0, sizeof(*d));                       // Padding too : files are reproducible
+        d->magic = MAGIC; d->version = VERSION; d->size = sizeof(Data);
+        snprintf(d->name, NAME_LEN, "%s", name);
+        d->voices = Voices::count;
+        memcpy(d->nodes, Nodes::graph.nodes, sizeof(d->nodes));
+        d->output = Nodes::graph.output;
+        const Mod::Config& c = Nodes::mod_config;
+        d->mod_rate = c.rate;
+        d->num_sources = c.num_sources;
+        for(int s=0; s<c.num_sources; s++)
+        {
+            Source* src = &d->sources[s];
+            src->type = c.sources[s].type; src->a = c.sources[s].a; src->b = c.sources[s].b;
+            src->control = -1;
+            for(int k=0; k<ControlRing::NUM_VALUES; k++) if(c.sources[s].ext == Nodes::controls[k]) src->control = k;
+        }
+        d->num_dests = c.num_dests;
+        memcpy(d->dests, c.dests, sizeof(d->dests));
+        d->num_routes = c.num_routes;
+        memcpy(d->routes, c.routes, sizeof(d->routes));
+    }
+    bool check(const Data* d)
+    { // Header matches this build, every count and index is in range, every rate usable
+        /* *************DOC***************
+         * The audio thread indexes arrays with these values and does not check
+         * them again : a corrupt or stale file must stop here.
+         *  - CONTROL param[0] : Nodes::controls row, MOD param[0] : Nodes::mod row
+         *  - sources, dests, routes : Mod tables (dests also fill Nodes::mod rows)
+         *  - output, node inputs : Patch::MAX_NODES
+         * It also converts floats to integers and divides by them:
+         *  - source rates : finite, not negative, LFO under one cycle per tick
+         *  - dests : finite, lo <= hi, PITCH lo >= 0 ; route depths : finite
+         * (Mod::check_source, Mod::check_dest)
+         * *******************************/
+        if((d->magic != MAGIC) || (d->version != VERSION) || (d->size != sizeof(Data))) return false;
+        if((d->voices < 1) || (d->voices > Voices::MAX_COUNT)) return false;
+        if(d->mod_rate < 1) return false;
+        if((d->num_sources < 0) || (d->num_sources > Mod::MAX_SOURCES)) return false;
+        if((d->num_dests < 0) || (d->num_dests > Nodes::NUM_DESTS)) return false;
+        if((d->num_routes < 0) || (d->num_routes > Mod::MAX_ROUTES)) return false;
+        for(int s=0; s<d->num_sources; s++)
+        {
+            const Source& src = d->sources[s];
+            if(!Mod::check_source(src.type, src.a, src.b, d->mod_rate, GameAudio::SAMPLE_RATE)) return false;
+            if((src.control < -1) || (src.control >= ControlRing::NUM_VALUES)) return false;
+        }
+        for(int k=0; k<d->num_dests; k++) if(!Mod::check_dest(d->dests[k])) return false;
+        if((d->num_dests > Nodes::PITCH) && (d->dests[Nodes::PITCH].lo < 0)) return false;     // Saw pitch is 0:1
+        for(int r=0; r<d->num_routes; r++)
+        {
+            const Mod::Route& route = d->routes[r];
+            if((route.src < 0) || (route.src >= d->num_sources) || (route.dest < 0) || (route.dest >= d->num_dests)
+                || !std::isfinite(route.depth))
+                return false;
+        }
+        if((d->output < 0) || (d->output >= Patch::MAX_NODES) || !d->nodes[d->output].used) return false;
+        for(const Patch::Node& n : d->nodes)
+        {
+            if(!n.used) continue;
+            if((n.kind < 0) || (n.kind >= Nodes::NUM_KINDS)) return false;
+            for(int i : n.in) if((i < Patch::NO_NODE) || (i >= Patch::MAX_NODES)) return false;
+            // !(in range) : NaN fails too
+            if((n.kind == Nodes::CONTROL) && !((n.param[0] >= 0) && (n.param[0] < ControlRing::NUM_VALUES))) return false;
+            if((n.kind == Nodes::MOD) && !((n.param[0] >= 0) && (n.param[0] < static_cast<int>(Nodes::NUM_DESTS)))) return false;
+        }
+        return (d->name[NAME_LEN-1] == '\0');
+    }
+    bool save(const Data* d, const char* path)
+    {
+        FILE* f = fopen(path, "wb");
+        if(f == NULL) return false;
+        bool ok = (fwrite(d, sizeof(*d), 1, f) == 1);
+        return (fclose(f) == 0) && ok;
+    }
+    bool load(Data* d, const char* path)
+    { // Read and check path. False if it is missing or not a preset for this build.
+        FILE* f = fopen(path, "rb");
+        if(f == NULL) return false;
+        bool ok = (fread(d, sizeof(*d), 1, f) == 1);
+        fclose(f);
+        return ok && check(d);
+    }
+    bool write_text(const Data* d, const char* path)
+    { // Same settings as save(), one per line, for reading and diffing
+        FILE* f = fopen(path, "w");
+        if(f == NULL) return false;
+        fprintf(f, "# Preset : %s (version %u)\n", d->name, d->version);
+        fprintf(f, "voices = %d\n", d->voices);
+        fprintf(f, "# node id = kind : inputs (-1 unconnected) : params\n");
+        for(int id=0; id<Patch::MAX_NODES; id++)
+        {
+            const Patch::Node& n = d->nodes[id];
+            if(!n.used) continue;
+            fprintf(f, "node %2d = %-8s : %2d %2d %2d %2d : %g %g %g %g\n", id, Nodes::KINDS[n.kind].name,
+                    n.in[0], n.in[1], n.in[2], n.in[3], n.param[0], n.param[1], n.param[2], n.param[3]);
+        }
+        fprintf(f, "output = %d\n", d->output);
+        fprintf(f, "mod_rate = %d\n", d->mod_rate);
+        static const char* TYPES[] = {"lfo_sine", "lfo_triangle", "lfo_saw", "lfo_square", "env", "external"};
+        for(int s=0; s<d->num_sources; s++)
+        {
+            const Source& src = d->sources[s];
+            const char* type = ((src.type >= 0) && (src.type <= Mod::EXTERNAL)) ? TYPES[src.type] : "?";
+            fprintf(f, "source %d = %-12s %g %g control %d\n", s, type, src.a, src.b, src.control);
+        }
+        for(int k=0; k<d->num_dests; k++)
+            fprintf(f, "dest %d = base %g range %g : %g\n", k, d->dests[k].base, d->dests[k].lo, d->dests[k].hi);
+        for(int r=0; r<d->num_routes; r++)
+            fprintf(f, "route = source %d -> dest %d depth %g\n", d->routes[r].src, d->routes[r].dest, d->routes[r].depth);
+        return fclose(f) == 0;
+    }
+    bool apply(const Data* d)
+    { // UI thread : make d the sound. The audio thread crossfades to it. False if it does not compile.
+        Patch::Graph g;
+        Patch::clear(&g, Nodes::graph.kinds, Nodes::graph.num_kinds);   // Kinds of a reloaded synth module
+        memcpy(g.nodes, d->nodes, sizeof(g.nodes));
+        g.output = d->output;
+        Mod::Config c{};
+        c.rate = d->mod_rate;
+        c.sample_rate = GameAudio::SAMPLE_RATE;
+        c.num_sources = d->num_sources;
+        for(int s=0; s<d->num_sources; s++)
+        {
+            const Source& src = d->sources[s];
+            c.sources[s] = {static_cast<Mod::Type>(src.type), src.a, src.b,
+                            (src.control >= 0) ? Nodes::controls[src.control] : NULL};
+        }
+        c.num_dests = d->num_dests;
+        memcpy(c.dests, d->dests, sizeof(c.dests));
+        c.num_routes = d->num_routes;
+        memcpy(c.routes, d->routes, sizeof(c.routes));
+        { // Check both before offering either : a rejected preset must not fade the audio
+            static Patch::Plan test;
+            if(!Patch::compile(&g, &test) || !Mod::check(&c)) return false;
+        }
+        Uint32 n = Crossfade::requested.fetch_add(1, std::memory_order_acq_rel) + 1;
+        Crossfade::voices.store(d->voices, std::memory_order_relaxed);
+        bool ok = Mod::publish(&Nodes::matrix, &c, true) && Patch::publish(&Nodes::engine, &g, true);
+        Crossfade::ready.store(n, std::memory_order_release);
+        if(ok) { Nodes::graph = g; Nodes::mod_config = c; }
+        return ok;
+    }
+
+    ////////////////
+    // OFF-THREAD LOAD
+    ////////////////
+    enum State { IDLE, LOADING, READY, FAILED };
+    struct Loader
+    {
+        SDL_Thread* thread{};
+        std::atomic<int> state{IDLE};
+        char path[256]{};
+        Data data{};                                    // Worker writes, then UI reads once READY
+    };
+    int SDLCALL load_thread(void* userdata)
+    {
+        Loader* l = static_cast<Loader*>(userdata);
+        bool ok = load(&l->data, l->path);
+        l->state.store(ok ? READY : FAILED, std::memory_order_release);
+        return 0;
+    }
+    bool load_async(Loader* l, const char* path)
+    { // UI thread : start loading path. False if a load is still running.
+        if(l->state.load(std::memory_order_acquire) == LOADING) return false;
+        if(l->thread) { SDL_WaitThread(l->thread, NULL); l->thread = NULL; }
+        snprintf(l->path, sizeof(l->path), "%s", path);
+        l->state.store(LOADING, std::memory_order_release);
+        l->thread = SDL_CreateThread(load_thread, "preset", l);
+        if(l->thread == NULL) { l->state.store(FAILED, std::memory_order_release); return false; }
+        return true;
+    }
+    State poll(Loader* l)
+    { // UI thread, once per frame : apply a finished load. READY or FAILED once per load.
+        int state = l->state.load(std::memory_order_acquire);
+        if((state != READY) && (state != FAILED)) return static_cast<State>(state);
+        SDL_WaitThread(l->thread, NULL); l->thread = NULL;
+        l->state.store(IDLE, std::memory_order_relaxed);
+        if((state == READY) && !apply(&l->data)) return FAILED;
+        return static_cast<State>(state);
+    }
+    void finish(Loader* l)
+    { // Shutdown : wait for a load still running, drop its result
+        if(l->thread) SDL_WaitThread(l->thread, NULL);
+        l->thread = NULL;
+        l->state.store(IDLE, std::memory_order_relaxed);
+    }
+}
+
+#endif // __PRESET_H__
@@ -0,0 +1,145 @@
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "preset.h"
+
+namespace PresetTests
+{
+    const char* PATH = "preset_tests.mgp";              // Removed when done
+    bool write_bytes(const void* p, size_t n)
+    {
+        FILE* f = fopen(PATH, "wb");
+        if(f == NULL) return false;
+        fwrite(p, 1, n, f);
+        return fclose(f) == 0;
+    }
+    Uint8 tape[2*Patch::BLOCK*GameAudio::BYTES_PER_SAMPLE];
+}
+
+void run_tests_for_preset()
+{
+    using namespace PresetTests;
+    TEST(Nodes::setup());
+    Preset::Data d;
+    Preset::capture(&d, "tests");
+    TEST(Preset::check(&d));
+    { // Binary round trip : byte for byte
+        Preset::Data got;
+        TEST(Preset::save(&d, PATH));
+        TEST(Preset::load(&got, PATH));
+        TESTeq(memcmp(&got, &d, sizeof(d)), 0);
+        TESTeq(got.sources[Nodes::MOUSE_HEIGHT].control, UI::VCA::HEIGHT);   // Pointer saved as an index
+        TESTeq(got.sources[Nodes::LFO_VIBRATO].control, -1);
+    }
+    { // Not a preset for this build : rejected
+        Preset::Data bad = d; bad.magic++;
+        TEST(write_bytes(&bad, sizeof(bad)) && !Preset::load(&bad, PATH));
+        bad = d; bad.version++;
+        TEST(write_bytes(&bad, sizeof(bad)) && !Preset::load(&bad, PATH));
+        bad = d;
+        TEST(write_bytes(&bad, sizeof(bad)-1) && !Preset::load(&bad, PATH));   // Short file
+        bad = d; bad.nodes[Nodes::Id::saw].kind = Nodes::NUM_KINDS;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.nodes[Nodes::Id::saw].in[0] = Patch::MAX_NODES;
+        TEST(!Preset::check(&bad));
+    }
+    { // Indexes the audio thread uses as they are : rejected when out of range
+        Preset::Data bad = d; bad.nodes[Nodes::Id::center_dist].param[0] = ControlRing::NUM_VALUES;
+        TEST(!Preset::check(&bad));                     // Nodes::controls row
+        bad = d; bad.nodes[Nodes::Id::pitch].param[0] = Nodes::NUM_DESTS;
+        TEST(!Preset::check(&bad));                     // Nodes::mod row
+        bad = d; bad.nodes[Nodes::Id::pitch].param[0] = -1;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.num_dests = Nodes::NUM_DESTS + 1;
+        TEST(!Preset::check(&bad));                     // Mod would fill rows Nodes::mod does not have
+        bad = d; bad.sources[0].type = Mod::EXTERNAL + 1;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.sources[0].control = -2;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.mod_rate = 0;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.routes[0].dest = d.num_dests;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.routes[0].src = -1;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.output = Patch::MAX_NODES;
+        TEST(!Preset::check(&bad));
+        TEST(!Preset::load(&bad, "no such file.mgp"));
+    }
+    { // Floats the audio thread converts or divides by : rejected when not usable
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        const float inf = std::numeric_limits<float>::infinity();
+        Preset::Data bad = d; bad.dests[Nodes::CUTOFF].lo = nan;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.dests[Nodes::AMP].hi = inf;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.dests[Nodes::AMP].base = -inf;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.dests[Nodes::CUTOFF].lo = 0.9f; bad.dests[Nodes::CUTOFF].hi = 0.1f;
+        TEST(!Preset::check(&bad));                     // lo > hi
+        bad = d; bad.dests[Nodes::PITCH].lo = -0.5f;
+        TEST(!Preset::check(&bad));                     // Negative saw pitch
+        bad = d; bad.sources[Nodes::LFO_VIBRATO].a = -1;
+        TEST(!Preset::check(&bad));                     // Negative LFO rate
+        bad = d; bad.sources[Nodes::LFO_VIBRATO].a = nan;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.sources[Nodes::LFO_VIBRATO].a = static_cast<float>(GameAudio::SAMPLE_RATE)/d.mod_rate;
+        TEST(!Preset::check(&bad));                     // A cycle per tick : phase step overflows
+        bad = d; bad.sources[Nodes::LFO_VIBRATO].a = 0;
+        TEST(Preset::check(&bad));                      // Stopped LFO is fine
+        bad = d; bad.sources[Nodes::ENV_FILTER].a = -0.1f;
+        TEST(!Preset::check(&bad));                     // Negative attack
+        bad = d; bad.sources[Nodes::ENV_FILTER].b = inf;
+        TEST(!Preset::check(&bad));
+        bad = d; bad.routes[0].depth = nan;
+        TEST(!Preset::check(&bad));
+    }
+    { // Text export : one line per setting
+        TEST(Preset::write_text(&d, PATH));
+        FILE* f = fopen(PATH, "r");
+        char line[128]; int nodes = 0, routes = 0;
+        while(f && fgets(line, sizeof(line), f))
+        {
+            nodes  += (strncmp(line, "node ", 5) == 0);
+            routes += (strncmp(line, "route ", 6) == 0);
+        }
+        if(f) fclose(f);
+        TESTeq(nodes, 12);                              // Default patch
+        TESTeq(routes, d.num_routes);
+    }
+    remove(PATH);
+    { // apply : a config Mod rejects does not start a crossfade
+        Preset::Data bad = d; bad.routes[0].dest = d.num_dests;   // Skips check(), like a caller could
+        Uint32 requested = Crossfade::requested.load();
+        TEST(!Preset::apply(&bad));
+        TESTeq(Crossfade::requested.load(), requested);
+        TEST(!Patch::fade_pending(&Nodes::engine) && !Mod::fade_pending(&Nodes::matrix));
+    }
+    { // apply : audio fades out, switches while silent, fades back in
+        Voices::count = 1;
+        Preset::Data next = d;
+        next.voices = 3;
+        next.nodes[Nodes::Id::mix].in[1] = Patch::NO_NODE;  // No noise
+        TEST(Preset::apply(&next));
+        TEST(Patch::fade_pending(&Nodes::engine) && Mod::fade_pending(&Nodes::matrix));
+        bool ok = true; bool switched = false;
+        for(int k=0; (k<2*Crossfade::SAMPLES/Patch::BLOCK + 4) && ok; k++)
+        { // One block at a time : Voices::count changes only at gain 0
+            float gain = Crossfade::gain;
+            write_tape(tape, Patch::BLOCK);
+            if(Voices::count == 3)
+            {
+                if(!switched) ok = (gain == 0);
+                switched = true;
+            }
+            if(!ok) Tests::note("switched at gain %f in block %d", gain, k);
+        }
+        TEST(ok && switched);
+        TESTeq(Crossfade::stage, Crossfade::PLAY);
+        TESTeq(Crossfade::gain, 1);
+        TEST(!Patch::fade_pending(&Nodes::engine) && !Mod::fade_pending(&Nodes::matrix));
+        TESTeq(Nodes::graph.nodes[Nodes::Id::mix].in[1], Patch::NO_NODE);
+    }
+}
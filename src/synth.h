@@ -0,0 +1,690 @@
+#ifndef __SYNTH_H__
+#define __SYNTH_H__
+
+#include <atomic>
+#include <cstdlib>
+#include "mg_snapshot_ring.h"
+#include "mg_control_ring.h"
+#include "mg_log.h"
+#include "mg_profile.h"
+#include "mg_arena.h"
+#include "mg_patch.h"
+#include "mg_mod.h"
+#include "mg_capture.h"
+
+/* *************Synth***************
+ * Everything the audio thread runs: the audio device callback, the voices, and the
+ * state they read. main.cpp and bench.cpp both include this (include SDL.h first).
+ *
+ * The audio thread reads mouse controls from UI::VCA::ring and writes every
+ * sample to Scope::ring and Recorder::tap. The UI side of those lives in main.cpp.
+ *
+ * Audio buffers come from GameAudio::arena, allocated once at startup. The
+ * callback never calls malloc or free (build with `make ALLOC_TRAP=1` to check).
+ * *******************************/
+
+constexpr int A_MAX = (1<<12) - 1;                      // Maximum volume of any single sound
+// Freq of 1st harmonic is UI::VCA::mouse_height*FREQ_H1_MAX
+constexpr float FREQ_H1_MAX = 220;                      // Maximum freq of 1st harmonic
+
+namespace UI
+{ // Mouse controls for the audio thread
+    namespace VCA
+    {
+        float mouse_center_dist;                        // Latest value (UI thread)
+        float mouse_height;                             // Latest value (UI thread)
+        enum { CENTER_DIST, HEIGHT };                   // Index in ControlRing::Point::v
+        ControlRing::Ring ring;                         // Every mouse position, for audio
+        ControlRing::Curve curve;                       // Audio thread : VCA at each sample
+    }
+}
+namespace Scope
+{ // Every sample write_tape() writes, for Scope::update() in main.cpp
+    SnapshotRing::Ring ring;
+}
+namespace Recorder
+{ // Every sample write_tape() writes, to a file while recording (Recorder::toggle() in main.cpp)
+    Capture::Tap tap;
+}
+void write_tape(Uint8* wpos, Uint32 NUM_SAMPLES);
+namespace SynthModule
+{ // Hot reload : write_tape and the node kinds from build/libsynth.so (src/synth_module.cpp)
+    /* *************DOC***************
+     * `make synth` builds this same code as a shared library. main.cpp loads each
+     * new build (see SynthReload) and offers its Api here. The audio callback takes
+     * the offer at its start, so write_tape switches at a block boundary. Node
+     * kinds switch when the patch is republished with the new Api::kinds.
+     *
+     * The library has its own copy of the code but no state of its own: the
+     * program is linked with -rdynamic, so the library's globals (Voices, Envelope,
+     * Nodes::engine, ...) are the program's. Phases, envelopes and the patch carry
+     * on through a reload. Api::layout catches a build whose state would not fit.
+     * Until a library is loaded, the program runs its own write_tape.
+     * *******************************/
+    constexpr int VERSION = 1;                          // Bump when Api changes
+    struct Api
+    {
+        int version;
+        Uint32 layout;                                  // layout() of the build : sizes of the state
+        const void* state;                              // &Nodes::engine as the library sees it
+        void (*write_tape)(Uint8* wpos, Uint32 NUM_SAMPLES);
+        const Patch::Kind* kinds; int num_kinds;
+    };
+    std::atomic<const Api*> offered{NULL};              // UI : newest library (NULL : built in)
+    std::atomic<const Api*> running{NULL};              // Audio : library of the last callback
+    const Api* live{};                                  // Audio thread only
+    void acquire(void)
+    { // Audio thread, start of callback : switch to the newest library
+        live = offered.load(std::memory_order_acquire);
+        running.store(live, std::memory_order_release);
+    }
+    void write_tape(Uint8* wpos, Uint32 NUM_SAMPLES)
+    {
+        if(live) live->write_tape(wpos, NUM_SAMPLES);
+        else     ::write_tape(wpos, NUM_SAMPLES);
+    }
+}
+namespace GameAudio
+{
+    SDL_AudioDeviceID dev;                              // Audio playback device handle
+    Uint32 dev_buf_size{};                              // Audio buffer size in bytes
+    Uint32 num_samples{};                               // Audio buffer size in samples
+
+    // For audio I make (not audio from file)
+    constexpr int SAMPLE_RATE = 44100;                  // 44100 samples per second
+    constexpr int BYTES_PER_SAMPLE = 2;                 // 16-bit audio
+
+    // All audio buffers : tape, and later delay lines, sample banks, ...
+    constexpr size_t ARENA_SIZE = 1<<23;                // 8MB : room for a 90s mono WAV
+    Arena::Arena arena;
+
+    namespace Sound
+    {
+        Uint8* buf = NULL;                              // Sound buffer in memory (arena)
+        Uint32 len{};                                   // Number of bytes in buffer
+        // For callback (from loopwave.c)
+        int pos{};                                      // Position rel to start of buffer
+    }
+
+    Uint32 (*ticks)(void) = SDL_GetTicks;               // Clock for control curves (golden tests count samples)
+
+    // Device reopened (see AudioDevice) : the tape carries on, its first buffer fades in
+    constexpr int RESUME_SAMPLES = 256;                 // About 6ms
+    std::atomic<Uint32> reopened{0};                    // UI : devices reopened
+    Uint32 resumed{};                                   // Audio thread : reopens faded in
+    void resume_fade(Uint8* stream, int len)
+    { // Audio thread : ramp the start of the device buffer after a reopen (16-bit samples)
+        Uint32 n = reopened.load(std::memory_order_acquire);
+        if(n == resumed) return;
+        resumed = n;
+        int samples = len/BYTES_PER_SAMPLE;
+        if(samples > RESUME_SAMPLES) samples = RESUME_SAMPLES;
+        for(int i=0; i<samples; i++)
+        {
+            Sint16 x = static_cast<Sint16>(stream[2*i] | (stream[2*i+1]<<8));
+            int y = x*i/RESUME_SAMPLES;
+            stream[2*i] = static_cast<Uint8>(y&0xFF); stream[2*i+1] = static_cast<Uint8>(y>>8);
+        }
+    }
+
+    // Callback : from loopwave.c
+    void SDLCALL fill_audio_dev(void* userdata, Uint8* stream, int len)
+    { // Copied from libsdl.org/SDL2/test/loopwave.c
+        Arena::NoAlloc no_alloc;                        // Real-time : no malloc, no free
+        Uint8* const dev_buf = stream; const int dev_len = len;  // Copy below moves stream, len
+        Profile::name_thread("audio");
+        PROFILE_ZONE("audio");
+        // The example code is nice and general: source buffer size is decoupled from device
+        // buffer size. But why should I care? Why not just let source buffer always be an
+        // exact multiple of device buffer size? Like 10x? That would eliminate checking for
+        // the wraparound, which makes the code much simpler.
+        // TODO: try that. Any difference?
+        // TODO: change callback name to "read_tape_callback"
+        //       SDL callback where the audio device reads in the next bit of audio tape.
+        //       The callback then writes the bit of audio tape just after the bit that was
+        //       read.
+
+        /* *************DOC***************
+         * userdata : stuff I pass to callback, no use for this yet
+         * stream : audio device buffer
+         * len : size of audio device buffer
+         *
+         * Usually, this callback just does this:
+         *
+         *      // Get position in the audio tape
+         *      play_head = Sound::buf + Sound::pos;        // Source byte I'm up to
+         *
+         *      // Copy a len-sized bit from the tape to the audio device
+         *      SDL_memcpy(stream, play_head, len);
+         *
+         *      // Update the position in the audio tape
+         *      Sound::pos += len;
+         *
+         * Eventually, the audio tape reaches the end, or close to it.
+         * This is when the tape left is less than the audio device buffer size.
+         *
+         *      // How much tape is left?
+         *      tapeleft = Sound::len - Sound::pos;         // Source bytes until wrap around
+         *
+         *      // Is it enough to fill the device buffer?
+         *      if(tapeleft < len)
+         *      {
+         *          ...
+         *
+         * When that happens, first just copy whatever is left:
+         *
+         *      if(tapeleft < len)
+         *      {
+                    SDL_memcpy(stream, play_head, tapeleft);
+         *      }
+         *
+         *      // Update device buffer position and remaining space to fill
+         *      stream += tapeleft; len -= tapeleft;
+         *
+         * Note, the len will reset to the full buffer size the next time the callback is
+         * called. The function takes int len, not int* len. Similarly, the stream will
+         * reset to point at the start of the stream because the function takes Uint*
+         * stream, not Uint** stream.
+         *
+         *      // Tape wraparound 
+         *      play_head = Sound::buf;
+         *      tapeleft = Sound::len;
+         *      Sound::pos = 0;
+         *
+         *      // Copy a len-sized bit from the tape to the audio device
+         *      SDL_memcpy(stream, play_head, len);
+         *
+         *      // Update the position in the audio tape
+         *      Sound::pos += len;
+         *
+         * Note these last two lines read the same as the usual non-wraparound case, so it
+         * is the same code. But when these lines happen after a wraparound, stream and len
+         * are different from the usual values. stream is somewhere inside the device buffer
+         * and len is less than the buffer length.
+         * *******************************/
+        { // Copy from Sound::buf to audio device
+            (void)userdata;
+            Uint8* play_head; int tapeleft;
+            /* *************DOC***************
+             * This callback loads from the source buffer (audio tape) into the device
+             * buffer.
+             *
+             * The source buffer is much larger than the device buffer.
+             *      Say the device buffer is 4096 mono 16-bit samples.
+             *      That's 2^12 * 2 bytes, or 8192 bytes.
+             *      For a stereo wav file, the device buffer is double that (8192 bytes for
+             *      each channel).
+             *      Playing that at 44100 samples per second, the device buffer holds only
+             *      about 92ms of audio.
+             *      For generating audio from UI events, the device buffer should be smaller
+             *      to avoid latency (delay between when event happens and when sound
+             *      updates). UI events are handled once per frame, at 60 FPS that is about
+             *      16ms. For mono 16-bit samples at 44100 samples per second, use 2^9
+             *      samples. 2^9 samples * 2 bytes is 1024 bytes. This is a latency of
+             *      512/44100 = 0.01161 seconds, about 12ms, which means the callback
+             *      happens about once per frame. Any faster would be overkill (UI events
+             *      don't get processed any faster). And the latency feels OK.
+             *      So the device buffer is something like 512 samples or 4096 samples,
+             *      depending on whether I care about latency or if I just default to
+             *      whatever the wav file sample size is.
+             *
+             *      Say the source buffer is one seconds worth of audio.
+             *      Playing that at 44100 samples per second, the source buffer holds 44100
+             *      samples. The source buffer is 86x to 10x bigger than the device buffer.
+             *
+             *      Since these are mono 16-bit samples, that's just 2 bytes per sample,
+             *      so the source buffer is 88,200 bytes.
+             *      That's big, but not crazy big. It's 200 bytes larger than what I've been
+             *      playing with in my initial tests.
+             *
+             *      Allocate that when the program starts and only deallocate at shutdown.
+             *      It can definitely be smaller, I just don't have a good sense of the
+             *      constraints yet. But it's fine at this size, so just go for it.
+             *
+             * I normally have no access to the device buffer.
+             * This callback lets me access its starting address and its length.
+             *
+             * userdata : no use for this yet
+             * stream : starting address of the audio device byte buffer
+             * len : length of the audio device byte buffer
+             *
+             * Sound::buf is my audio source.
+             * Sound::len is the number of bytes in my source.
+             *
+             * Sound::buf is an absolute address.
+             * Sound::pos and Sound::len are relative to Sound::buf.
+             *
+             * Similarly, "stream" is an absolute address and "len" is relative to stream.
+             *
+             * 0               16              42 <--- Silly example numbers
+             * Sound::buf      Sound::pos      Sound::len
+             * ┬─────────      ┬─────────      ─────────┬
+             * ↓               ↓                        ↓
+             * ┌─────────────────────────────────────────┐
+             * 0               x                        !│
+             * └─────────────────────────────────────────┘
+             * ---------------SOURCE BUFFER---------------
+             *
+             * 0
+             * stream       len
+             * ┬─────       ──┬
+             * ↓              ↓
+             * ┌───────────────┐
+             * 0              !│
+             * └───────────────┘
+             * --DEVICE BUFFER--
+             *
+             * Here is an example of how this plays out using made-up tiny numbers.
+             *
+             * len = 16 unless otherwise noted
+             *
+             * SDL_memcpy(stream, play_head, len)
+             * |               SDL_memcpy(stream, play_head, len)
+             * |               |               SDL_memcpy(stream, play_head, tapeleft)
+             * |               |               |                             = 10
+             * |               |               |         SDL_memcpy(stream, play_head, len)
+             * |               |               |         |                  = 0      = 6
+             * |               |               |         |     SDL_memcpy(stream, play_head, len)
+             * |               |               |         |     |               SDL_memcpy(stream, play_head, len)
+             * |               |               |         |     |               |               SDL_memcpy(stream, play_head, tapeleft)
+             * |               |               |         |     |               |               |                             = 4
+             * v               v               v         v     v               v               v
+             * 0               16              32        0     6               22              38
+             * play_head       play_head  play_head  play_head play_head       play_head       play_head
+             * ┬──────         ┬──────    ─────┬──── ────┬──── ┬────────       ┬──────         ┬──────
+             * ↓               ↓               ↓         ↓     ↓               ↓               ↓
+             * ┌───────────────|───────────────|─────────┌─────|───────────────|───────────────|───┐
+             * 0              !0              !0        !0    !0              !0              !0   │
+             * └───────────────|───────────────|─────────└─────────────────────|───────────────|───┘
+             * 0--------------SOURCE BUFFER--------------0--------------SOURCE BUFFER--------------
+             * ┌───────────────┌───────────────┌─────────|─────┌───────────────┌───────────────┐
+             * 0              !0              !0        !0    !0              !0              !│
+             * └───────────────└───────────────└─────────|─────└───────────────└───────────────┘
+             * 0-DEVICE BUFFER-0-DEVICE BUFFER-0-DEVICE BUFFER-0-DEVICE BUFFER-0-DEVICE BUFFER-
+             * *******************************/
+            play_head = Sound::buf + Sound::pos;        // Source byte I'm up to
+            tapeleft = Sound::len - Sound::pos;         // Source bytes until wrap around
+            if(tapeleft <= len)
+            { // Near end of Sound::buf, copy the last bit of sound to device
+                /* *************DOC***************
+                 * tapeleft : amount of audio left until the "end of the tape"
+                 * len : size of audio device buffer (tiny compared to size of audio tape)
+                 *
+                 * See my sketch above that shows this branch is the wraparound case.
+                 *
+                 * ******************************/
+                // Copy from Sound::buf to audio device buffer
+                SDL_memcpy(stream, play_head, tapeleft);
+                // Advance audio device buffer
+                stream += tapeleft;
+                // Update remaining space in audio device buffer
+                len -= tapeleft;
+                // Wrap back around to start of Sound::buf
+                // Point at start of Sound::buf
+                play_head = Sound::buf;
+                tapeleft = Sound::len;
+                Sound::pos = 0;
+            }
+            SDL_memcpy(stream, play_head, len);
+            Sound::pos += len;
+            resume_fade(dev_buf, dev_len);              // First buffer on a reopened device
+        }
+        { // Write next bit of sound for consumption in next callback
+            ControlRing::begin(&UI::VCA::curve, ticks());
+            SynthModule::acquire();                     // Reloaded DSP code starts here
+            Uint8* write_head = Sound::buf + Sound::pos;// write_head : walk Sound::buf
+            int NUM_SAMPLES = GameAudio::num_samples;   // Samples I want to write
+
+            int bytesleft = Sound::len - Sound::pos;    // Bytes until wraparound
+            int samplesleft=bytesleft/BYTES_PER_SAMPLE; // Samples until wraparound
+            if(samplesleft <  NUM_SAMPLES)
+            { // Not enough room: write part of it, then wraparound and write the rest
+                SynthModule::write_tape(write_head, samplesleft);  // Final write before wrap around
+                // Set up to write the rest after wraparound
+                NUM_SAMPLES -= samplesleft;
+                write_head = Sound::buf;                      // Point back at start of Sound::buf
+            }
+            // Wraparound split, in the AUDIO log at TRACE (compiled in with make LOG_LEVEL=0)
+            LOG(TRACE, AUDIO, "%d : samplesleft: %d",__LINE__, samplesleft);
+            LOG(TRACE, AUDIO, "%d : NUM_SAMPLES: %d",__LINE__, NUM_SAMPLES);
+            // Write the rest (or all of it if there was enough room)
+            SynthModule::write_tape(write_head, NUM_SAMPLES);  // Usually a full dev buf write
+        }
+    }
+}
+namespace Voices
+{ // Track phase value for each voice in the periodic waveform
+    constexpr int MAX_COUNT = 256;                          // Synth limit (bench goes this high)
+    constexpr int UI_MAX = 8;                               // Space cycles count 1 : UI_MAX
+    int count = 1;
+    alignas(Arena::ALIGN) Uint32 phase[MAX_COUNT]{};        // Location in waveform, 2^32 is one period
+}
+namespace Waveform
+{
+    /* *************DOC***************
+     * Phase is a 32-bit fixed-point fraction of a period : 0 is the start of the
+     * period, 2^32 is the end. A voice advances by a fixed increment per sample:
+     *
+     *      inc = freq * 2^32 / SAMPLE_RATE             (Periods per Sample, scaled)
+     *
+     * Unsigned overflow is the wraparound, so there is no branch, and the phase
+     * never picks up rounding error : after N samples it is exactly N*inc mod 2^32.
+     * The only pitch error is rounding inc to a whole number (under 1e-6 cents at
+     * audio frequencies).
+     *
+     * Increments are precomputed: INC_PER_HZ is the scale factor above, so a
+     * frequency becomes an increment with one multiply and no division per sample.
+     *
+     * The top TABLE_BITS of the phase index a one-period wavetable.
+     * *******************************/
+    constexpr double INC_PER_HZ = 4294967296.0/GameAudio::SAMPLE_RATE; // 2^32 / SAMPLE_RATE
+    Uint32 inc(double freq) { return static_cast<Uint32>(freq*INC_PER_HZ + 0.5); }
+    void advance(Uint32* phase, Uint32 inc) { *phase += inc; }  // Wraps at the end of a period
+
+    ////////////
+    // WAVEFORMS
+    ////////////
+    // Waveforms:
+    // - return a float in range -0.5 to 0.5
+    // - use phase to calculate the return value (if waveform is periodic)
+    constexpr int TABLE_BITS = 12;
+    constexpr int TABLE_SIZE = 1<<TABLE_BITS;           // Samples in one period
+    struct Table { float v[TABLE_SIZE]; };
+    constexpr Table make_sawtooth(void)
+    { // Ramp from -0.5 at the start of the period up to 0.5 at the end
+        Table t{};
+        for(int i=0; i<TABLE_SIZE; i++) t.v[i] = static_cast<float>(i)/TABLE_SIZE - 0.5f;
+        return t;
+    }
+    constexpr Table SAWTOOTH = make_sawtooth();
+    float lookup(const Table& t, Uint32 phase) { return t.v[phase >> (32-TABLE_BITS)]; }
+    float sawtooth(Uint32 phase) { return lookup(SAWTOOTH, phase); }
+    Uint32 noise_state{1};                              // xorshift32 : never 0
+    void seed(Uint32 s) { noise_state = s ? s : 1; }
+    float noise(void)
+    { // Same sequence every run for a seed (golden tests), and no lock (rand() may take one)
+        noise_state ^= noise_state << 13; noise_state ^= noise_state >> 17; noise_state ^= noise_state << 5;
+        return static_cast<float>(noise_state)*(1.0f/4294967296.0f) - 0.5f;
+    }
+}
+namespace Envelope
+{
+    bool enabled{};
+    float phase = 1;
+    bool one_shot{true};
+    ////////////
+    // ENVELOPES
+    ////////////
+    // Envelopes:
+    // - return a float in range 0 to 1
+    // - use phase to calculate the return value (if waveform is periodic)
+    float straight_R(float phase) { return 1-phase; } // Linear release
+    void advance(float* phase, float period)
+    {
+        if (enabled)
+        {
+            float freq = 1/period;
+            *phase += (freq / static_cast<float>(GameAudio::SAMPLE_RATE));
+            if(*phase >= 1)
+            {
+                if(one_shot)
+                { // Envelope is single-shot
+                    *phase = 1;
+                    enabled = false;
+                }
+                else
+                { // Envelope loops
+                    *phase = 0;
+                    enabled = true;
+                }
+            }
+        }
+    }
+}
+namespace Nodes
+{ // Node kinds for the patch graph, and the patch write_tape plays
+    /* *************DOC***************
+     * Signals are floats. 1.0 out of the patch is A_MAX in the tape.
+     *
+     *      CONTROL  (param0 : control)   mouse control (UI::VCA) at each sample, 0 to 1
+     *      SAW      (in0 : pitch 0:1)    Voices::count sawtooth harmonics, param0 : Hz of
+     *                                    harmonic 1 at pitch 1 (uses Voices::phase)
+     *      NOISE                         white noise, -0.5 to 0.5
+     *      ENVELOPE (param0 : period)    Envelope::straight_R, 0 to 1 (uses Envelope::phase)
+     *      MUL      (in0, in1)           in0*in1 : a VCA
+     *      MIX      (in0 : in3)          sum of in[i]*param[i]
+     *      MOD      (param0 : Dest)      modulation matrix output at each sample
+     *      FILTER   (in0, in1 : cutoff)  one-pole lowpass, cutoff 0:1 (1 passes everything)
+     *
+     * Modulation : the Mod::Matrix runs at CONTROL_RATE. Sources are the mouse
+     * controls, two LFOs and a filter envelope; destinations are read by MOD nodes.
+     * *******************************/
+    enum Kind { CONTROL, SAW, NOISE, ENVELOPE, MUL, MIX, MOD, FILTER, NUM_KINDS };
+    enum Source { MOUSE_HEIGHT, MOUSE_CENTER_DIST, LFO_VIBRATO, LFO_SWEEP, ENV_FILTER, NUM_SOURCES };
+    enum Dest { PITCH, AMP, CUTOFF, NUM_DESTS };
+    constexpr int CONTROL_RATE = 32;                    // Samples per modulation tick
+    alignas(Arena::ALIGN) float controls[ControlRing::NUM_VALUES][Patch::BLOCK]; // write_tape fills per block
+    alignas(Arena::ALIGN) float mod[NUM_DESTS][Patch::BLOCK];                   // Mod::run fills per block
+
+    using Patch::Step; using Patch::State;
+    void control(const Step& s, State*, const float* const*, float* out, int frames)
+    {
+        const float* v = controls[static_cast<int>(s.param[0])];
+        for(int i=0; i<frames; i++) out[i] = v[i];
+    }
+    void saw(const Step& s, State*, const float* const* in, float* out, int frames)
+    { // One harmonic at a time over the block : harmonic N is N times harmonic 1's increment
+        // Pitch and Hz come from the patch (any node, any preset) : clamp before the
+        // float to Uint32 conversion. NaN fails every compare and ends up 0.
+        constexpr float INC_MAX = 2147483648.0f;        // 2^31 : harmonic 1 at Nyquist
+        float scale = static_cast<float>(s.param[0]*Waveform::INC_PER_HZ);
+        scale = (scale > 0) ? ((scale < INC_MAX) ? scale : INC_MAX) : 0;
+        Uint32 inc_h1[Patch::BLOCK];
+        for(int i=0; i<frames; i++)
+        {
+            float pitch = in[0][i];
+            pitch = (pitch > 0) ? ((pitch < 1) ? pitch : 1) : 0;    // 0:1
+            inc_h1[i] = static_cast<Uint32>(pitch*scale); out[i] = 0;
+        }
+        for(int v=0; v<Voices::count; v++)
+        {
+            Uint32 harmonic = static_cast<Uint32>(v+1);
+            Uint32 phase = Voices::phase[v];
+            for(int i=0; i<frames; i++)
+            {
+                out[i] += Waveform::sawtooth(phase);
+                Waveform::advance(&phase, inc_h1[i]*harmonic);
+            }
+            Voices::phase[v] = phase;
+        }
+    }
+    void noise(const Step&, State*, const float* const*, float* out, int frames)
+    {
+        for(int i=0; i<frames; i++) out[i] = Waveform::noise();
+    }
+    void envelope(const Step& s, State*, const float* const*, float* out, int frames)
+    {
+        for(int i=0; i<frames; i++)
+        {
+            out[i] = Envelope::straight_R(Envelope::phase);
+            Envelope::advance(&Envelope::phase, s.param[0]);
+        }
+    }
+    void mul(const Step&, State*, const float* const* in, float* out, int frames)
+    {
+        for(int i=0; i<frames; i++) out[i] = in[0][i]*in[1][i];
+    }
+    void mix(const Step& s, State*, const float* const* in, float* out, int frames)
+    {
+        for(int i=0; i<frames; i++)
+            out[i] = in[0][i]*s.param[0] + in[1][i]*s.param[1] + in[2][i]*s.param[2] + in[3][i]*s.param[3];
+    }
+    void mod_out(const Step& s, State*, const float* const*, float* out, int frames)
+    {
+        const float* v = mod[static_cast<int>(s.param[0])];
+        for(int i=0; i<frames; i++) out[i] = v[i];
+    }
+    void filter(const Step&, State* st, const float* const* in, float* out, int frames)
+    {
+        float y = st->z[0];
+        for(int i=0; i<frames; i++) { y += in[1][i]*(in[0][i] - y); out[i] = y; }
+        st->z[0] = y;
+    }
+    constexpr Patch::Kind KINDS[NUM_KINDS] = {
+        {"control", 0, control}, {"saw", 1, saw}, {"noise", 0, noise},
+        {"envelope", 0, envelope}, {"mul", 2, mul}, {"mix", 4, mix},
+        {"mod", 0, mod_out}, {"filter", 2, filter}};
+
+    Patch::Graph graph;                                 // UI thread : the patch being edited
+    Patch::Engine engine;                               // Audio thread runs its plan
+    Mod::Config mod_config;                             // UI thread : the routing being edited
+    Mod::Matrix matrix;                                 // Audio thread runs its config
+    namespace Id
+    { // Nodes in the default patch
+        int pitch, center_dist, saw, noise, noise_vca, mix, cutoff, filter, envelope, amp, env_out, out;
+    }
+    bool setup_mod(bool wobble)
+    { // Mouse height is pitch. wobble : vibrato, a slow filter sweep, and a filter envelope on each note.
+        Mod::Config* c = &mod_config;
+        *c = Mod::Config{};
+        c->rate = CONTROL_RATE;
+        c->sample_rate = GameAudio::SAMPLE_RATE;
+        c->sources[MOUSE_HEIGHT]      = {Mod::EXTERNAL, 0, 0, controls[UI::VCA::HEIGHT]};
+        c->sources[MOUSE_CENTER_DIST] = {Mod::EXTERNAL, 0, 0, controls[UI::VCA::CENTER_DIST]};
+        c->sources[LFO_VIBRATO]       = {Mod::LFO_SINE, 5.5f, 0, NULL};
+        c->sources[LFO_SWEEP]         = {Mod::LFO_TRIANGLE, 0.2f, 0, NULL};
+        c->sources[ENV_FILTER]        = {Mod::ENV, 0.01f, 0.4f, NULL};   // Attack, release
+        c->num_sources = NUM_SOURCES;
+        c->dests[PITCH]  = {0, 0, 1};                   // 0:1 of FREQ_H1_MAX
+        c->dests[AMP]    = {1, 0, 1};
+        c->dests[CUTOFF] = {wobble ? 0.3f : 1.0f, 0.02f, 1};
+        c->num_dests = NUM_DESTS;
+        Mod::route(c, MOUSE_HEIGHT, PITCH, 1);
+        if(wobble)
+        {
+            Mod::route(c, LFO_VIBRATO, PITCH, 0.004f);  // About 7 cents at middle height
+            Mod::route(c, LFO_SWEEP, CUTOFF, 0.2f);
+            Mod::route(c, ENV_FILTER, CUTOFF, 0.5f);
+        }
+        return Mod::publish(&matrix, c);
+    }
+    bool setup(void)
+    { // Default patch : sawtooth voices and noise (VCA on mouse distance) through a filter and the envelope
+        Patch::Graph* g = &graph;
+        Patch::clear(g, KINDS, NUM_KINDS);
+        Id::pitch       = Patch::add(g, MOD, PITCH);
+        Id::center_dist = Patch::add(g, CONTROL, UI::VCA::CENTER_DIST);
+        Id::saw         = Patch::add(g, SAW, FREQ_H1_MAX);
+        Id::noise       = Patch::add(g, NOISE);
+        Id::noise_vca   = Patch::add(g, MUL);
+        Id::mix         = Patch::add(g, MIX, 1.0f, 0.5f);   // Noise at half volume
+        Id::cutoff      = Patch::add(g, MOD, CUTOFF);
+        Id::filter      = Patch::add(g, FILTER);
+        Id::envelope    = Patch::add(g, ENVELOPE, 0.2f);    // 0.2s release
+        Id::env_out     = Patch::add(g, MUL);
+        Id::amp         = Patch::add(g, MOD, AMP);
+        Id::out         = Patch::add(g, MUL);
+        Patch::connect(g, Id::pitch, Id::saw, 0);
+        Patch::connect(g, Id::noise, Id::noise_vca, 0);
+        Patch::connect(g, Id::center_dist, Id::noise_vca, 1);
+        Patch::connect(g, Id::saw, Id::mix, 0);
+        Patch::connect(g, Id::noise_vca, Id::mix, 1);
+        Patch::connect(g, Id::mix, Id::filter, 0);
+        Patch::connect(g, Id::cutoff, Id::filter, 1);
+        Patch::connect(g, Id::filter, Id::env_out, 0);
+        Patch::connect(g, Id::envelope, Id::env_out, 1);
+        Patch::connect(g, Id::env_out, Id::out, 0);
+        Patch::connect(g, Id::amp, Id::out, 1);
+        g->output = Id::out;
+        return setup_mod(false) && Patch::publish(&engine, g);
+    }
+}
+namespace Crossfade
+{ // Switch presets without a click : fade out, swap at a block boundary, fade in
+    /* *************DOC***************
+     * The UI thread (see Preset::apply) does:
+     *
+     *      requested++                                 // Audio starts fading out
+     *      publish patch and modulation with fade=true // Audio will not take them yet
+     *      voices = ...; ready = requested             // Everything is offered
+     *
+     * The audio thread fades out over SAMPLES, takes the marked offers at the
+     * next block boundary once silent, sets Voices::count, then fades back in.
+     * Plain edits (fade=false) still switch at once.
+     * *******************************/
+    constexpr int SAMPLES = 256;                        // Each way : about 6ms
+    enum Stage { PLAY, FADE_OUT, SILENT, FADE_IN };
+    std::atomic<Uint32> requested{0};                   // UI : preset switches started
+    std::atomic<Uint32> ready{0};                       // UI : preset switches fully offered
+    std::atomic<int> voices{1};                         // UI : Voices::count after the switch
+    Stage stage{PLAY};                                  // Audio thread only
+    Uint32 applied{};                                   // Audio thread : last switch done
+    float gain{1};                                      // Audio thread
+    bool begin_block(void)
+    { // Audio thread : move the stages along. True if marked offers can be taken now.
+        Uint32 req = requested.load(std::memory_order_acquire);
+        if((stage == PLAY) && (req != applied)) stage = FADE_OUT;
+        if(stage != SILENT) return false;
+        if(  (ready.load(std::memory_order_acquire) == req)
+          && !Patch::fade_pending(&Nodes::engine) && !Mod::fade_pending(&Nodes::matrix))
+        { // All taken last block (or UI is still offering : stay silent)
+            Voices::count = voices.load(std::memory_order_relaxed);
+            applied = req;
+            stage = FADE_IN;
+        }
+        return true;
+    }
+    void apply_gain(float* out, int frames)
+    { // Audio thread : ramp the block (NULL : no patch yet, nothing to fade)
+        if(out == NULL) { if(stage == FADE_OUT) { gain = 0; stage = SILENT; } return; }
+        if(stage == PLAY) return;
+        constexpr float STEP = 1.0f/SAMPLES;
+        for(int i=0; i<frames; i++)
+        {
+            if(stage == FADE_OUT)    { gain -= STEP; if(gain <= 0) { gain = 0; stage = SILENT; } }
+            else if(stage == FADE_IN){ gain += STEP; if(gain >= 1) { gain = 1; stage = PLAY; } }
+            out[i] *= gain;
+        }
+    }
+}
+void write_tape(Uint8* wpos, Uint32 NUM_SAMPLES)
+{ // Write `NUM_SAMPLES` to position `wpos` in audio tape
+    const Uint8* start = wpos;                          // Copy to Scope::ring when done
+    float vca[ControlRing::NUM_VALUES];                 // Mouse controls at this sample
+    for(Uint32 done=0; done<NUM_SAMPLES; )
+    { // Run the patch one block at a time
+        int frames = static_cast<int>(NUM_SAMPLES - done);
+        if(frames > Patch::BLOCK) frames = Patch::BLOCK;
+        for(int i=0; i<frames; i++)
+        { // Mouse controls at each sample of the block
+            ControlRing::next(&UI::VCA::curve, &UI::VCA::ring, vca);
+            for(int k=0; k<ControlRing::NUM_VALUES; k++) Nodes::controls[k][i] = vca[k];
+        }
+        bool silent = Crossfade::begin_block();         // Preset switch : only while silent
+        const Patch::Plan* plan = Patch::acquire(&Nodes::engine, silent);   // Patch edits start here
+        Mod::run(&Nodes::matrix, &Nodes::mod[0][0], Patch::BLOCK, frames, silent);
+        float* out = Patch::run(&Nodes::engine, plan, frames);
+        Crossfade::apply_gain(out, frames);
+        for(int i=0; i<frames; i++)
+        {
+            int sample = out ? static_cast<int>(A_MAX*out[i]) : 0; // No patch yet : silence
+            // Little Endian (LSB at lower address)
+            *wpos++ = (Uint8)(sample&0xFF);      // LSB
+            *wpos++ = (Uint8)(sample>>8);        // MSB
+        }
+        done += static_cast<Uint32>(frames);
+    }
+    SnapshotRing::write_le16(&Scope::ring, start, NUM_SAMPLES);
+    Capture::write_le16(&Recorder::tap, start, NUM_SAMPLES);
+}
+namespace SynthModule
+{
+    constexpr Uint32 layout(void)
+    { // Changes when the state the program and library share changes size
+        return static_cast<Uint32>(sizeof(Patch::Engine) + sizeof(Mod::Matrix) + sizeof(Voices::phase)
+                                 + sizeof(Nodes::controls) + sizeof(Nodes::mod) + sizeof(Capture::Tap)
+                                 + Nodes::NUM_KINDS);
+    }
+}
+
+#endif // __SYNTH_H__
@@ -0,0 +1,20 @@
+#include "SDL.h"
+#include "synth.h"
+
+/* *************Synth module***************
+ * The DSP code as a shared library: `make synth` builds build/libsynth.so from
+ * this file, and a running build/main swaps it in (see SynthModule in synth.h).
+ *
+ * Edit write_tape, Waveform, Envelope, Voices or the node process functions in
+ * synth.h, then `make synth` : the app keeps running, sound picks up the change
+ * at its next audio block. Changes to main.cpp, or to the size of the synth
+ * state (Api::layout), still need `make` and a restart.
+ * *******************************/
+
+extern "C" const SynthModule::Api* synth_module(void)
+{ // The one symbol the program looks up
+    static const SynthModule::Api api = {
+        SynthModule::VERSION, SynthModule::layout(), &Nodes::engine,
+        write_tape, Nodes::KINDS, Nodes::NUM_KINDS};
+    return &api;
+}
@@ -0,0 +1,138 @@
+#include <cstdio>
+#include <cstring>
+#include "SDL.h"
+#include "mg_Test.h"
+#include "synth.h"
+
+namespace SynthTests
+{
+    void silence(void)
+    { // write_tape writes zeros : envelope is done, controls hold at 0
+        const float zero[ControlRing::NUM_VALUES] = {0, 0};
+        ControlRing::init(&UI::VCA::curve, GameAudio::SAMPLE_RATE, zero);
+        Envelope::enabled = false; Envelope::phase = 1;
+        Voices::count = 1;
+    }
+    Uint8 mark(Uint32 n) { return static_cast<Uint8>(1 + n%251); }   // Never 0
+    bool fill_audio_dev(Uint32 dev_samples, Uint32 tape_samples)
+    { // Run the callback until the tape wraps a few times. Check it against a model:
+      //  - device gets tape bytes pos : pos+len, wrapping at the end of the tape
+      //  - then write_tape writes the next len bytes after the new pos, wrapping too
+        using namespace GameAudio;
+        const Uint32 len = dev_samples*BYTES_PER_SAMPLE;
+        const Uint32 tape_len = tape_samples*BYTES_PER_SAMPLE;
+        Uint8* model = (Uint8*)malloc(tape_len);
+        Uint8* stream = (Uint8*)malloc(len);
+        Sound::buf = (Uint8*)malloc(tape_len);
+        Sound::len = tape_len; Sound::pos = 0;
+        num_samples = dev_samples;
+        Uint32 n = 0;                                   // Marks written so far
+        for(Uint32 i=0; i<tape_len; i++) Sound::buf[i] = model[i] = mark(n++);
+        bool ok = true;
+        Uint32 pos = 0;
+        const int callbacks = static_cast<int>(3*tape_samples/dev_samples) + 3;
+        for(int k=0; (k<callbacks) && ok; k++)
+        {
+            GameAudio::fill_audio_dev(NULL, stream, static_cast<int>(len));
+            for(Uint32 j=0; j<len; j++) ok = ok && (stream[j] == model[(pos+j)%tape_len]);
+            pos = (pos + len)%tape_len;
+            ok = ok && (static_cast<Uint32>(Sound::pos) == pos);
+            for(Uint32 j=0; j<len; j++) model[(pos+j)%tape_len] = 0;   // Silence written
+            ok = ok && (memcmp(Sound::buf, model, tape_len) == 0);
+            for(Uint32 j=0; j<len; j++)
+            { // New marks where write_tape wrote, so the next reads are checked too
+                Uint32 i = (pos+j)%tape_len;
+                Sound::buf[i] = model[i] = mark(n++);
+            }
+            if(!ok) Tests::note("device %u samples, tape %u samples : wrong after callback %d", dev_samples, tape_samples, k);
+        }
+        free(Sound::buf); Sound::buf = NULL;
+        free(stream); free(model);
+        return ok;
+    }
+    double cycles(Uint32 inc, long long num_samples)
+    { // Run Waveform::advance num_samples times. Return cycles done (wraps + phase).
+        Uint32 phase = 0; long long wraps = 0;
+        for(long long i=0; i<num_samples; i++)
+        {
+            Uint32 before = phase;
+            Waveform::advance(&phase, inc);
+            wraps += (phase < before);
+        }
+        return wraps + phase/4294967296.0;
+    }
+}
+
+void run_tests_for_synth()
+{
+    { // fill_audio_dev : device reads the tape in order for every tape/device size ratio
+        SynthTests::silence();
+        bool ok = true;
+        const Uint32 devs[] = {1, 2, 3, 7, 64, 512};
+        for(Uint32 dev : devs)
+        { // Tape from 1x to 4x the device buffer (every remainder), then 1s of tape
+            for(Uint32 tape = dev; (tape <= 4*dev+3) && ok; tape++) ok = SynthTests::fill_audio_dev(dev, tape);
+            ok = ok && SynthTests::fill_audio_dev(dev, GameAudio::SAMPLE_RATE);
+        }
+        TEST(ok);
+    }
+    { // Waveform::advance : pitch does not drift over 24 hours
+        constexpr long long DAY = 24LL*3600*GameAudio::SAMPLE_RATE;
+        const float freqs[] = {FREQ_H1_MAX, 8*FREQ_H1_MAX}; // 1st and 8th harmonic
+        for(float f : freqs)
+        {
+            double got = SynthTests::cycles(Waveform::inc(f), DAY);
+            double want = static_cast<double>(DAY)*f/GameAudio::SAMPLE_RATE;
+            double cents = 1200*SDL_log(got/want)/SDL_log(2.0);
+            TESTnear(cents, 0, 0.001);                  // Only error is rounding inc
+        }
+    }
+    { // Waveform::sawtooth : table ramps from -0.5 to 0.5 over one period
+        bool ok = true;
+        for(Uint32 k=0; k<4096; k++)
+        {
+            Uint32 phase = k*(1u<<20) + k;              // Spread over the period
+            float want = static_cast<float>(phase/4294967296.0 - 0.5);
+            float got = Waveform::sawtooth(phase);
+            if(SDL_fabsf(got - want) > 1.0f/Waveform::TABLE_SIZE)
+            {
+                if(ok) Tests::note("phase %u : %f, want %f", phase, got, want);
+                ok = false;
+            }
+        }
+        TEST(ok);
+    }
+    { // Nodes::saw : pitch outside 0:1 (or NaN) and any Hz are clamped, not wrapped
+        Patch::Step st{}; st.param[0] = FREQ_H1_MAX;
+        float pitch[Patch::BLOCK]; float out[Patch::BLOCK];
+        const float* in[Patch::MAX_INPUTS] = {pitch};
+        auto phase_after = [&](float p, float hz)
+        { // Voice 1 phase step over one sample
+            st.param[0] = hz; pitch[0] = p;
+            Voices::count = 1; Voices::phase[0] = 0;
+            Nodes::saw(st, NULL, in, out, 1);
+            return Voices::phase[0];
+        };
+        TESTeq(phase_after(-0.5f, FREQ_H1_MAX), 0u);    // Negative pitch : stopped
+        TESTeq(phase_after(SDL_sqrtf(-1.0f), FREQ_H1_MAX), 0u);  // NaN : stopped
+        TESTeq(phase_after(3.0f, FREQ_H1_MAX), phase_after(1.0f, FREQ_H1_MAX));  // Over 1 : 1
+        TESTeq(phase_after(1.0f, -100), 0u);            // Negative Hz : stopped
+        TESTeq(phase_after(1.0f, 1e9f), 2147483648u);   // Above Nyquist : Nyquist
+    }
+    { // resume_fade : first buffer after a reopen ramps up from 0, later buffers untouched
+        Uint8 buf[2*512];
+        auto fill = [&buf](Sint16 x) { for(int i=0; i<512; i++) { buf[2*i] = x&0xFF; buf[2*i+1] = (x>>8)&0xFF; } };
+        auto at = [&buf](int i) { return static_cast<Sint16>(buf[2*i] | (buf[2*i+1]<<8)); };
+        fill(-1000);
+        GameAudio::resume_fade(buf, sizeof(buf));       // No reopen
+        TESTeq(at(0), -1000);
+        GameAudio::reopened++;
+        GameAudio::resume_fade(buf, sizeof(buf));
+        TESTeq(at(0), 0);
+        TESTeq(at(GameAudio::RESUME_SAMPLES/2), -500);
+        TESTeq(at(GameAudio::RESUME_SAMPLES), -1000);
+        fill(-1000);
+        GameAudio::resume_fade(buf, sizeof(buf));       // Once per reopen
+        TESTeq(at(0), -1000);
+    }
+}
@@ -1,6 +1,21 @@
 #include <cstdio>
 #include "mg_Test.h"
 #include "mg_colors_tests.cpp"
+#include "mg_gtow_tests.cpp"
+#include "mg_control_ring_tests.cpp"
+#include "mg_arena_tests.cpp"
+#include "mg_patch_tests.cpp"
+#include "mg_mod_tests.cpp"
+#include "mg_hot_tests.cpp"
+#include "mg_capture_tests.cpp"
+#include "mg_audio_device_tests.cpp"
+#include "mg_raster_tests.cpp"
+#include "mg_replay_tests.cpp"
+#include "mg_snapshot_ring_tests.cpp"
+#include "mg_tex_cache_tests.cpp"
+#include "mg_sprites_tests.cpp"
+#include "synth_tests.cpp"
+#include "preset_tests.cpp"
 
 int main()
 {
@@ -9,11 +24,27 @@ int main()
         puts("Running examples...");
         run_examples_for_mg_colors();
     }
-    if(0)
-    { // Tests : mg_colors
+    if(1)
+    { // Tests
         puts("Running tests...");
         run_tests_for_mg_colors();
+        run_tests_for_mg_gtow();
+        run_tests_for_mg_control_ring();
+        run_tests_for_mg_arena();
+        run_tests_for_mg_patch();
+        run_tests_for_mg_mod();
+        run_tests_for_mg_hot();
+        run_tests_for_mg_capture();
+        run_tests_for_mg_audio_device();
+        run_tests_for_mg_raster();
+        run_tests_for_mg_replay();
+        run_tests_for_mg_snapshot_ring();
+        run_tests_for_mg_tex_cache();
+        run_tests_for_mg_sprites();
+        run_tests_for_synth();
+        run_tests_for_preset();
     }
     printf("FAIL/PASS/TOTAL: %d/%d/%d\n",Tests::fail,Tests::pass,Tests::total);
     TESTeq(Tests::pass+Tests::fail,Tests::total);
+    return Tests::exit_code();
 }